@@ -58,6 +58,17 @@ def get_default_common_config(run_mode: RunMode = RunMode.NORMAL, **kwargs):
     # default_common_config['cache_policy'] = 'heuristic'
     default_common_config['cache_policy'] = 'pre_sample'
     default_common_config['cache_percentage'] = 0.0
+    # 0 maps the whole feature file instead of the host feature store
+    default_common_config['host_cache_percentage'] = 0.0
+    # threads reading the cold features of the host feature store
+    default_common_config['host_cache_io_thread_num'] = 8
+    # stage concurrency of the arch0 pipeline
+    default_common_config['cpu_num_sample_worker'] = 1
+    default_common_config['cpu_num_extract_worker'] = 1
+    # threads of each arch0 stage, 0 derives them from the cores
+    default_common_config['cpu_sample_thread_num'] = 0
+    default_common_config['cpu_extract_thread_num'] = 0
+    default_common_config['cpu_pin_thread'] = True
 
     default_common_config['num_epoch'] = 10
     default_common_config['batch_size'] = 8000
@@ -68,8 +79,8 @@ def get_default_common_config(run_mode: RunMode = RunMode.NORMAL, **kwargs):
 
     default_common_config['barriered_epoch'] = 0
     default_common_config['presample_epoch'] = 1
-    # 40 is faster than 80 in aliyun machine
-    default_common_config['omp_thread_num'] = 40
+    # 0 uses one thread per physical core
+    default_common_config['omp_thread_num'] = 0
 
     default_common_config.update(kwargs)
 
@@ -125,6 +136,23 @@ def add_common_arguments(argparser, run_config):
                            default=run_config['cache_policy'])
     argparser.add_argument('--cache-percentage', type=float,
                            default=run_config['cache_percentage'])
+    argparser.add_argument('--host-cache-percentage', type=float,
+                           default=run_config['host_cache_percentage'])
+    argparser.add_argument('--host-cache-io-thread-num', type=int,
+                           default=run_config['host_cache_io_thread_num'])
+    argparser.add_argument('--cpu-num-sample-worker', type=int,
+                           default=run_config['cpu_num_sample_worker'])
+    argparser.add_argument('--cpu-num-extract-worker', type=int,
+                           default=run_config['cpu_num_extract_worker'])
+    argparser.add_argument('--cpu-sample-thread-num', type=int,
+                           default=run_config['cpu_sample_thread_num'])
+    argparser.add_argument('--cpu-extract-thread-num', type=int,
+                           default=run_config['cpu_extract_thread_num'])
+    argparser.add_argument('--cpu-pin-thread', action='store_true',
+                           default=run_config['cpu_pin_thread'])
+    argparser.add_argument('--no-cpu-pin-thread', action='store_false',
+                           dest='cpu_pin_thread',
+                           default=run_config['cpu_pin_thread'])
     argparser.add_argument('--max-sampling-jobs', type=int,
                            default=run_config['max_sampling_jobs'])
     argparser.add_argument('--max-copying-jobs', type=int,
@@ -205,7 +233,15 @@ def process_common_config(run_config):
     run_config['_cache_policy'] = sam.cache_policies[run_config['cache_policy']]
     assert(run_config['cache_percentage'] >=
            0 and run_config['cache_percentage'] <= 100)
-
+    assert(run_config['host_cache_percentage'] >=
+           0 and run_config['host_cache_percentage'] <= 1)
+    assert(run_config['host_cache_io_thread_num'] > 0)
+
+    assert(run_config['cpu_num_sample_worker'] > 0)
+    assert(run_config['cpu_num_extract_worker'] > 0)
+    assert(run_config['cpu_sample_thread_num'] >= 0)
+    assert(run_config['cpu_extract_thread_num'] >= 0)
+    assert(run_config['omp_thread_num'] >= 0)
     assert(run_config['max_sampling_jobs'] > 0)
     assert(run_config['max_copying_jobs'] > 0)
 
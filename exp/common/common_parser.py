@@ -133,6 +133,7 @@ class BenchInstance:
     self.vals['async_train'] = cfg.async_train
     self.vals['seq_num'] = getattr(cfg, 'seq_num', None)
     self.vals['dataset'] = str(cfg.dataset)
+    self.vals['huge_page'] = getattr(cfg, 'huge_page', 0)
   
   def get_optimal(self):
     optimal_cfg = copy.deepcopy(self.cfg)
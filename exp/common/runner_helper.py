@@ -158,6 +158,8 @@ class RunConfig:
     self.system = System.samgraph
     self.dgl_gpu_sampling = True
     self.nv_prof = False
+    # 0: base pages, 1: transparent huge pages, 2: hugetlbfs first
+    self.huge_page = 0
     self.root_path="/graph-learning/samgraph/"
 
   def cache_log_name(self):
@@ -169,6 +171,11 @@ class RunConfig:
     if self.pipeline:
       return ["pipeline"]
     return []
+
+  def huge_page_log_name(self):
+    if self.huge_page != 0:
+      return [f"huge_page_{self.huge_page}"]
+    return []
   def preprocess_sample_type(self):
     if self.sample_type is SampleType.kDefaultForApp:
       if self.app is App.pinsage:
@@ -236,6 +243,7 @@ class RunConfig:
     cmd_line += 'export SAMGRAPH_LOG_NODE_ACCESS=0; '
     cmd_line += f'export SAMGRAPH_LOG_NODE_ACCESS_SIMPLE={self.report_optimal}; '
     cmd_line += f'export SAMGRAPH_DUMP_TRACE={self.dump_trace}; '
+    cmd_line += f'export SAMGRAPH_HUGE_PAGE={self.huge_page}; '
     if self.multi_gpu:
       if self.async_train:
         cmd_line += f'python ../../example/samgraph/multi_gpu/async/train_{self.app.name}.py'
@@ -290,7 +298,7 @@ class RunConfig:
     if self.report_optimal == 1:
       std_out_log += "report_optimal_"
     std_out_log += '_'.join(
-      [self.system.name]+self.cache_log_name() + self.pipe_log_name() +
+      [self.system.name]+self.cache_log_name() + self.pipe_log_name() + self.huge_page_log_name() +
       [self.app.name, self.sample_type.name, str(self.dataset), self.cache_policy.get_log_fname()] + 
       [f'cache_rate_{int(self.cache_percent*100):0>3}', f'batch_size_{self.batch_size}']) 
     return std_out_log
@@ -298,7 +306,7 @@ class RunConfig:
   def beauty(self):
     self.preprocess_sample_type()
     msg = ' '.join(
-      ['Running', self.system.name] + self.cache_log_name() + self.pipe_log_name() + 
+      ['Running', self.system.name] + self.cache_log_name() + self.pipe_log_name() + self.huge_page_log_name() +
       [self.app.name, self.sample_type.name, str(self.dataset), self.cache_policy.get_log_fname()] + 
       [f'cache rate:{int(self.cache_percent*100):0>3}%', f'batch size:{self.batch_size}', ])
     return msg
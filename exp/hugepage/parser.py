@@ -0,0 +1,30 @@
+import os, sys
+sys.path.append(os.getcwd()+'/../common')
+from common_parser import *
+from runner import cfg_list_collector
+import pandas
+
+selected_col = ['dataset_short', 'sample_type', 'app', 'huge_page']
+selected_col += ['huge_page_coverage', 'epoch_time:sample_time', 'epoch_time:copy_time']
+
+def get_coverage(cfg):
+  lines = grep_from(cfg.get_log_fname() + '.err.log', r'.*Dataset huge page coverage: .*')
+  if len(lines) == 0:
+    return math.nan
+  return float(re.match(r'.*coverage: ([0-9.]+)%.*', lines[-1]).group(1))
+
+if __name__ == '__main__':
+  inst_list = []
+  for cfg in cfg_list_collector.conf_list:
+    inst = BenchInstance().init_from_cfg(cfg)
+    inst.vals['huge_page_coverage'] = get_coverage(cfg)
+    inst_list.append(inst)
+  with open(f'data.dat', 'w') as f:
+    BenchInstance.print_dat(inst_list, f, selected_col)
+
+  # the copy time of arch0 is the feature extraction
+  with open(f'data.dat', 'r') as f, open('hugepage.dat', 'w') as out:
+    table = pandas.read_csv(f, sep="\t")
+    table = table.pivot_table(values=['huge_page_coverage', 'epoch_time:sample_time', 'epoch_time:copy_time'],
+                              columns=['huge_page'], index=['dataset_short'])
+    print(table, file=out)
@@ -0,0 +1,39 @@
+import os, sys, copy
+sys.path.append(os.getcwd()+'/../common')
+from runner_helper import Arch, RunConfig, ConfigList, App, Dataset, CachePolicy, run_in_list, SampleType, percent_gen
+
+do_mock = False
+durable_log = True
+
+# CPU sampling and extraction (arch0) with each huge page mode
+cur_common_base = (ConfigList()
+  .override('app', [App.gcn])
+  .override('sample_type', [SampleType.kKHop2])
+  .override('arch', [Arch.arch0])
+  .override('cache_policy', [CachePolicy.no_cache])
+  .override('cache_percent', [0])
+  .override('copy_job', [1])
+  .override('sample_job', [1])
+  .override('pipeline', [False])
+  .override('epoch', [3])
+  .override('logdir', ['run-logs',])
+  .override('profile_level', [3])
+  # the huge page coverage is logged at info level
+  .override('log_level', ['info'])
+  .override('multi_gpu', [False]))
+
+cfg_list_collector = ConfigList.Empty()
+cfg_list_collector.concat(cur_common_base.copy()
+  .override('dataset', [Dataset.products, Dataset.papers100M])
+  .override('huge_page', [0, 1, 2])
+)
+
+if __name__ == '__main__':
+  from sys import argv
+  for arg in argv[1:]:
+    if arg == '-m' or arg == '--mock':
+      do_mock = True
+    elif arg == '-i' or arg == '--interactive':
+      durable_log = False
+
+  run_in_list(cfg_list_collector.conf_list, do_mock, durable_log)
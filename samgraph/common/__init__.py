@@ -55,6 +55,7 @@ kRandomWalk            = 3
 kWeightedKHopPrefix    = 4
 kKHop2                 = 5
 kWeightedKHopHashDedup = 6
+kKHop3                 = 7
 
 kArch0 = 0
 kArch1 = 1
@@ -65,6 +66,13 @@ kArch5 = 5
 kArch6 = 6
 kArch7 = 7
 
+kCPUHash0 = 0
+kCPUHash1 = 1
+kCPUHash2 = 2
+kCPUHash3 = 3
+kCPUHash4 = 4
+kCPUHash5 = 5
+
 kCacheByDegree          = 0
 kCacheByHeuristic       = 1
 kCacheByPreSample       = 2
@@ -87,6 +95,7 @@ sample_types = {
     'khop0'                   : kKHop0,
     'khop1'                   : kKHop1,
     'khop2'                   : kKHop2,
+    'khop3'                   : kKHop3,
     'random_walk'             : kRandomWalk,
     'weighted_khop'           : kWeightedKHop,
     'weighted_khop_prefix'    : kWeightedKHopPrefix,
@@ -189,6 +198,8 @@ kLogL1GraphBytes       = _get_next_enum_val(_step_log_val)
 kLogL1MissBytes        = _get_next_enum_val(_step_log_val)
 kLogL1PrefetchAdvanced = _get_next_enum_val(_step_log_val)
 kLogL1GetNeighbourTime = _get_next_enum_val(_step_log_val)
+kLogL1HostHotNodes     = _get_next_enum_val(_step_log_val)
+kLogL1HostColdNodes    = _get_next_enum_val(_step_log_val)
 # Step L2 Log
 kLogL2ShuffleTime    = _get_next_enum_val(_step_log_val)
 kLogL2LastLayerTime  = _get_next_enum_val(_step_log_val)
@@ -200,6 +211,10 @@ kLogL2IdCopyTime     = _get_next_enum_val(_step_log_val)
 kLogL2ExtractTime    = _get_next_enum_val(_step_log_val)
 kLogL2FeatCopyTime   = _get_next_enum_val(_step_log_val)
 kLogL2CacheCopyTime  = _get_next_enum_val(_step_log_val)
+kLogL2PipelineWaitTime = _get_next_enum_val(_step_log_val)
+kLogL2PoolGetWaitTime = _get_next_enum_val(_step_log_val)
+kLogL2PoolSubmitWaitTime = _get_next_enum_val(_step_log_val)
+kLogL2PoolOccupancy  = _get_next_enum_val(_step_log_val)
 # Step L3 Log
 kLogL3KHopSampleCooTime          = _get_next_enum_val(_step_log_val)
 kLogL3KHopSampleSortCooTime      = _get_next_enum_val(_step_log_val)
@@ -228,6 +243,9 @@ kLogL3CacheExtractMissTime       = _get_next_enum_val(_step_log_val)
 kLogL3CacheCopyMissTime          = _get_next_enum_val(_step_log_val)
 kLogL3CacheCombineMissTime       = _get_next_enum_val(_step_log_val)
 kLogL3CacheCombineCacheTime      = _get_next_enum_val(_step_log_val)
+kLogL3SampleMaxThreadTime        = _get_next_enum_val(_step_log_val)
+kLogL3SampleAvgThreadTime        = _get_next_enum_val(_step_log_val)
+kLogL3HostColdReadTime           = _get_next_enum_val(_step_log_val)
 
 # Epoch Log
 _epoch_log_val = [0]
@@ -242,6 +260,17 @@ kLogEpochTotalTime                   = _get_next_enum_val(_epoch_log_val)
 kLogEpochFeatureBytes                = _get_next_enum_val(_epoch_log_val)
 kLogEpochMissBytes                   = _get_next_enum_val(_epoch_log_val)
 
+# Workspace stats
+_workspace_stat_val = [0]
+kWorkspaceInUse          = _get_next_enum_val(_workspace_stat_val)
+kWorkspaceCached         = _get_next_enum_val(_workspace_stat_val)
+kWorkspacePeakInUse      = _get_next_enum_val(_workspace_stat_val)
+kWorkspacePeakTotal      = _get_next_enum_val(_workspace_stat_val)
+kWorkspaceNumAlloc       = _get_next_enum_val(_workspace_stat_val)
+kWorkspaceNumDeviceAlloc = _get_next_enum_val(_workspace_stat_val)
+kWorkspaceNumTrim        = _get_next_enum_val(_workspace_stat_val)
+kWorkspaceTrimmedBytes   = _get_next_enum_val(_workspace_stat_val)
+
 _step_event_val = [0]
 
 kL0Event_Train_Step                  = _get_next_enum_val(_step_event_val)
@@ -336,6 +365,9 @@ class SamGraphBasics(object):
         self.C_LIB_CTYPES.samgraph_get_log_init_value.restype = ctypes.c_double
         self.C_LIB_CTYPES.samgraph_get_log_step_value.restype = ctypes.c_double
         self.C_LIB_CTYPES.samgraph_get_log_epoch_value.restype = ctypes.c_double
+        self.C_LIB_CTYPES.samgraph_workspace_stat.argtypes = (
+            ctypes.c_int, ctypes.c_int, ctypes.c_int)
+        self.C_LIB_CTYPES.samgraph_workspace_stat.restype = ctypes.c_size_t
 
         self.C_LIB_CTYPES.samgraph_num_local_step.restype = ctypes.c_size_t
         self.C_LIB_CTYPES.samgraph_wait_one_child.restype = ctypes.c_int
@@ -478,6 +510,19 @@ class SamGraphBasics(object):
     def report_node_access(self):
         return self.C_LIB_CTYPES.samgraph_report_node_access()
 
+    def report_workspace(self):
+        return self.C_LIB_CTYPES.samgraph_report_workspace()
+
+    def workspace_stat(self, ctx, item):
+        # ctx is 'cpu:0' or 'cuda:0' as given by cpu() and gpu()
+        device, device_id = ctx.split(':')
+        device_type = kGPU if device == 'cuda' else kCPU
+        return self.C_LIB_CTYPES.samgraph_workspace_stat(
+            device_type, int(device_id), item)
+
+    def trim_workspace(self):
+        return self.C_LIB_CTYPES.samgraph_trim_workspace()
+
     def trace_step_begin(self, key, item, us):
         return self.C_LIB_CTYPES.samgraph_trace_step_begin(key, item, us)
 
@@ -34,10 +34,14 @@
 #include <numeric>
 #include <sstream>  // stringstream
 #include <string>   // string
+#include <utility>
 
 #include "constant.h"
+#include "dataset_loader.h"
 #include "device.h"
+#include "huge_page.h"
 #include "logging.h"
+#include "task_arena.h"
 
 namespace samgraph {
 namespace common {
@@ -63,6 +67,26 @@ Context::Context(std::string name) {
   device_id = std::stoi(id_str);
 }
 
+std::string TensorName::ToString() const {
+  std::ostringstream ss;
+  ss << *this;
+  return ss.str();
+}
+
+std::ostream &operator<<(std::ostream &os, const TensorName &name) {
+  if (name._prefix == nullptr) {
+    return os << name._name;
+  }
+  os << name._prefix;
+  if (name._key >= 0) {
+    os << name._key;
+  }
+  if (name._layer >= 0) {
+    os << "_" << name._layer;
+  }
+  return os;
+}
+
 Tensor::Tensor() : _data(nullptr) {}
 
 Tensor::~Tensor() {
@@ -70,12 +94,17 @@ Tensor::~Tensor() {
     return;
   }
 
-  Device::Get(_ctx)->FreeWorkspace(_ctx, _data, _nbytes);
+  if (_arena == nullptr) {
+    Device::Get(_ctx)->FreeWorkspace(_ctx, _data, _nbytes);
+  }
   LOG(DEBUG) << "Tensor " << _name << " has been freed";
 }
 
 void Tensor::ReplaceData(void *data) {
-  Device::Get(_ctx)->FreeWorkspace(_ctx, _data);
+  if (_arena == nullptr) {
+    Device::Get(_ctx)->FreeWorkspace(_ctx, _data);
+  }
+  _arena = nullptr;
   _data = data;
 }
 
@@ -83,7 +112,17 @@ TensorPtr Tensor::Null() { return std::make_shared<Tensor>(); }
 
 TensorPtr Tensor::FromMmap(std::string filepath, DataType dtype,
                            std::vector<size_t> shape, Context ctx,
-                           std::string name, StreamHandle stream) {
+                           TensorName name, StreamHandle stream) {
+  TensorPtr tensor;
+  DatasetLoader loader;
+  loader.Add(&tensor, std::move(filepath), dtype, std::move(shape), ctx,
+             std::move(name), stream);
+  loader.Run();
+  return tensor;
+}
+
+TensorPtr Tensor::FromMmapLazy(std::string filepath, DataType dtype,
+                               std::vector<size_t> shape, TensorName name) {
   CHECK(FileExist(filepath));
 
   TensorPtr tensor = std::make_shared<Tensor>();
@@ -95,40 +134,24 @@ TensorPtr Tensor::FromMmap(std::string filepath, DataType dtype,
   CHECK_EQ(nbytes, file_nbytes);
 
   int fd = open(filepath.c_str(), O_RDONLY, 0);
-  void *data = mmap(NULL, nbytes, PROT_READ, MAP_SHARED | MAP_FILE | MAP_LOCKED, fd, 0);
+  void *data = mmap(NULL, nbytes, PROT_READ, MAP_SHARED | MAP_FILE, fd, 0);
   CHECK_NE(data, (void *)-1);
   close(fd);
+  AdviseHugePage(data, nbytes);
 
   tensor->_dtype = dtype;
   tensor->_nbytes = nbytes;
   tensor->_shape = shape;
-  tensor->_ctx = ctx;
+  tensor->_ctx = MMAP();
   tensor->_name = name;
-
-  // if the device is cuda, we have to copy the data from host memory to cuda
-  // memory
-  switch (ctx.device_type) {
-    case kCPU:
-    case kGPU:
-      tensor->_data = Device::Get(ctx)->AllocWorkspace(ctx, nbytes,
-                                                       Constant::kAllocNoScale);
-      Device::Get(ctx)->CopyDataFromTo(data, 0, tensor->_data, 0, nbytes, CPU(),
-                                       ctx, stream);
-      Device::Get(ctx)->StreamSync(ctx, stream);
-      munmap(data, nbytes);
-      break;
-    case kMMAP:
-      tensor->_data = data;
-      break;
-    default:
-      CHECK(0);
-  }
+  tensor->_data = data;
 
   return tensor;
 }
 
 TensorPtr Tensor::Empty(DataType dtype, std::vector<size_t> shape, Context ctx,
-                        std::string name) {
+                        TensorName name,
+                        const std::shared_ptr<TaskArena> &arena) {
   TensorPtr tensor = std::make_shared<Tensor>();
   CHECK_GT(shape.size(), 0);
   size_t nbytes = GetTensorBytes(dtype, shape.begin(), shape.end());
@@ -140,14 +163,19 @@ TensorPtr Tensor::Empty(DataType dtype, std::vector<size_t> shape, Context ctx,
   tensor->_dtype = dtype;
   tensor->_shape = shape;
   tensor->_nbytes = nbytes;
-  tensor->_data = Device::Get(ctx)->AllocWorkspace(ctx, nbytes);
+  if (arena != nullptr) {
+    tensor->_data = arena->Alloc(ctx, nbytes);
+    tensor->_arena = arena;
+  } else {
+    tensor->_data = Device::Get(ctx)->AllocWorkspace(ctx, nbytes);
+  }
   tensor->_ctx = ctx;
-  tensor->_name = name;
+  tensor->_name = std::move(name);
 
   return tensor;
 }
 TensorPtr Tensor::EmptyNoScale(DataType dtype, std::vector<size_t> shape,
-                               Context ctx, std::string name) {
+                               Context ctx, TensorName name) {
   TensorPtr tensor = std::make_shared<Tensor>();
   CHECK_GT(shape.size(), 0);
   size_t nbytes = GetTensorBytes(dtype, shape.begin(), shape.end());
@@ -168,7 +196,7 @@ TensorPtr Tensor::EmptyNoScale(DataType dtype, std::vector<size_t> shape,
 }
 
 TensorPtr Tensor::Copy1D(TensorPtr source, size_t item_offset,
-                         std::vector<size_t> shape, std::string name,
+                         std::vector<size_t> shape, TensorName name,
                          StreamHandle stream) {
   CHECK(source && source->Defined());
   CHECK_GT(shape.size(), 0);
@@ -210,7 +238,8 @@ Context MMAP(int device_id) { return {kMMAP, device_id}; }
 
 TensorPtr Tensor::FromBlob(void *data, DataType dtype,
                            std::vector<size_t> shape, Context ctx,
-                           std::string name) {
+                           TensorName name,
+                           const std::shared_ptr<TaskArena> &arena) {
   TensorPtr tensor = std::make_shared<Tensor>();
   size_t nbytes = GetTensorBytes(dtype, shape.begin(), shape.end());
 
@@ -219,14 +248,15 @@ TensorPtr Tensor::FromBlob(void *data, DataType dtype,
   tensor->_nbytes = nbytes;
   tensor->_data = data;
   tensor->_ctx = ctx;
-  tensor->_name = name;
+  tensor->_name = std::move(name);
+  tensor->_arena = arena;
 
   return tensor;
 }
 TensorPtr Tensor::CopyBlob(const void *data, DataType dtype,
                            std::vector<size_t> shape,
                            Context from_ctx, Context to_ctx,
-                           std::string name, StreamHandle stream) {
+                           TensorName name, StreamHandle stream) {
   TensorPtr tensor = std::make_shared<Tensor>();
   size_t nbytes = GetTensorBytes(dtype, shape.begin(), shape.end());
   tensor->_data =
@@ -267,6 +297,28 @@ TensorPtr Tensor::CopyTo(TensorPtr source, Context ctx, StreamHandle stream) {
   return tensor;
 }
 
+void LazyTensor::SetLoader(std::function<TensorPtr()> load) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _load = std::move(load);
+  _tensor = nullptr;
+}
+
+LazyTensor &LazyTensor::operator=(TensorPtr tensor) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _load = nullptr;
+  _tensor = std::move(tensor);
+  return *this;
+}
+
+TensorPtr LazyTensor::Get() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_load) {
+    _tensor = _load();
+    _load = nullptr;
+  }
+  return _tensor ? _tensor : Tensor::Null();
+}
+
 std::string ToReadableSize(size_t nbytes) {
   char buf[Constant::kBufferSize];
   if (nbytes > Constant::kGigabytes) {
@@ -300,6 +352,8 @@ size_t GetDataTypeBytes(DataType dtype) {
     case kU8:
       return 1ul;
     case kF16:
+    case kBF16:
+    case kU16:
       return 2ul;
     case kF32:
     case kI32:
@@ -403,6 +457,9 @@ std::ostream &operator<<(std::ostream &os, const SampleType type) {
     case kWeightedKHopHashDedup:
       os << "WeightedKHopHashDedup";
       break;
+    case kKHop3:
+      os << "KHop3";
+      break;
     default:
       CHECK(false);
   }
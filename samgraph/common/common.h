@@ -43,6 +43,8 @@ enum DataType {
   kI32 = 4,
   kI8 = 5,
   kI64 = 6,
+  kBF16 = 7,
+  kU16 = 8,
 };
 
 enum DeviceType { kCPU = 0, kMMAP = 1, kGPU = 2 };
@@ -55,6 +57,7 @@ enum SampleType {
   kWeightedKHopPrefix,
   kKHop2,
   kWeightedKHopHashDedup,
+  kKHop3,      // vertex-parallel, read-only indices, CPU only
 };
 
 // arch0: vanilla mode(CPU sampling + GPU training)
@@ -91,6 +94,13 @@ enum CachePolicy {
   kCacheByRandom,
 };
 
+// Pages backing the large host buffers, see huge_page.h
+enum HugePageMode {
+  kHugePageOff = 0,
+  kHugePageAdvise,
+  kHugePageTLB,
+};
+
 struct Context {
   DeviceType device_type;
   int device_id;
@@ -109,6 +119,34 @@ using StreamHandle = void*;
 class Tensor;
 using TensorPtr = std::shared_ptr<Tensor>;
 
+class TaskArena;
+
+namespace cpu {
+class CPUFeatureStore;
+}  // namespace cpu
+
+// Name of a tensor, only printed by the debug logs. The per-batch names are
+// kept as a prefix with the batch key and layer, and only formatted when
+// they are printed.
+class TensorName {
+ public:
+  TensorName() : _prefix(""), _key(-1), _layer(-1) {}
+  TensorName(const char* prefix, int64_t key = -1, int64_t layer = -1)
+      : _prefix(prefix), _key(key), _layer(layer) {}
+  TensorName(std::string name)
+      : _prefix(nullptr), _name(std::move(name)), _key(-1), _layer(-1) {}
+
+  std::string ToString() const;
+  friend std::ostream& operator<<(std::ostream& os, const TensorName& name);
+
+ private:
+  // a literal, nullptr if the name is in _name
+  const char* _prefix;
+  std::string _name;
+  int64_t _key;
+  int64_t _layer;
+};
+
 class Tensor {
  public:
   Tensor();
@@ -124,23 +162,31 @@ class Tensor {
   Context Ctx() const { return _ctx; }
 
   static TensorPtr Null();
+  // The data of a tensor with an arena is cut from the arena, and is only
+  // freed with the arena after the last of its tensors
   static TensorPtr Empty(DataType dtype, std::vector<size_t> shape, Context ctx,
-                         std::string name);
+                         TensorName name,
+                         const std::shared_ptr<TaskArena>& arena = nullptr);
   static TensorPtr EmptyNoScale(DataType dtype, std::vector<size_t> shape, 
-                                Context ctx, std::string name);
+                                Context ctx, TensorName name);
   static TensorPtr Copy1D(TensorPtr tensor, size_t item_offset,
-                          std::vector<size_t> shape, std::string name,
+                          std::vector<size_t> shape, TensorName name,
                           StreamHandle stream = nullptr);
   static TensorPtr FromMmap(std::string filepath, DataType dtype,
                             std::vector<size_t> shape, Context ctx,
-                            std::string name, StreamHandle stream = nullptr);
+                            TensorName name, StreamHandle stream = nullptr);
+  // Map the file to kMMAP without locking it, the pages are read on demand
+  static TensorPtr FromMmapLazy(std::string filepath, DataType dtype,
+                                std::vector<size_t> shape, TensorName name);
+  // Takes the ownership of data, which is from the arena if there is one
   static TensorPtr FromBlob(void* data, DataType dtype,
                             std::vector<size_t> shape, Context ctx,
-                            std::string name);
+                            TensorName name,
+                            const std::shared_ptr<TaskArena>& arena = nullptr);
   static TensorPtr CopyTo(TensorPtr source, Context ctx, StreamHandle stream);
   static TensorPtr CopyBlob(const void * data, DataType dtype,
                             std::vector<size_t> shape, Context from_ctx,
-                            Context to_ctx, std::string name, StreamHandle stream = nullptr);
+                            Context to_ctx, TensorName name, StreamHandle stream = nullptr);
 
  private:
   void* _data;
@@ -150,7 +196,22 @@ class Tensor {
   size_t _nbytes;
   std::vector<size_t> _shape;
 
-  std::string _name;
+  TensorName _name;
+  std::shared_ptr<TaskArena> _arena;
+};
+
+// A dataset table loaded by its first Get, for the tables few runs read
+class LazyTensor {
+ public:
+  void SetLoader(std::function<TensorPtr()> load);
+  LazyTensor& operator=(TensorPtr tensor);
+  // Null if the table has neither a tensor nor a loader
+  TensorPtr Get() const;
+
+ private:
+  mutable std::mutex _mutex;
+  mutable std::function<TensorPtr()> _load;
+  mutable TensorPtr _tensor;
 };
 
 // Graph dataset that should be loaded from the disk using MMAP.
@@ -163,11 +224,15 @@ struct Dataset {
 
   TensorPtr prob_table;
   TensorPtr alias_table;
+  // Probability of the kept and of the aliased edge of every alias column,
+  // only loaded when the CPU sampler returns the edge weights
+  TensorPtr alias_weight_table;
 
   TensorPtr prob_prefix_table;
 
-  TensorPtr in_degrees;
-  TensorPtr out_degrees;
+  // only read by the node access logs
+  LazyTensor in_degrees;
+  LazyTensor out_degrees;
 
   // Decide nodes' feature store in GPU or CPU
   TensorPtr ranking_nodes;
@@ -176,11 +241,15 @@ struct Dataset {
   size_t num_class;
   TensorPtr feat;
   TensorPtr label;
+  // Scale of every row of kI8 features, null for the other types
+  TensorPtr feat_scale;
+  // Hot and cold tiers of feat, null if feat is fully in memory
+  std::shared_ptr<cpu::CPUFeatureStore> feat_store;
 
   // Node set
   TensorPtr train_set;
-  TensorPtr test_set;
-  TensorPtr valid_set;
+  LazyTensor test_set;
+  LazyTensor valid_set;
 };
 
 // Train graph in COO format
@@ -217,6 +286,8 @@ struct Task {
   TensorPtr output_label;
   // Multi-gpu miss cache index
   MissCacheIndex miss_cache_index;
+  // Buffers of the batch tensors, null if they are separate workspaces
+  std::shared_ptr<TaskArena> arena;
   std::atomic_bool graph_remapped;
   Task() : graph_remapped(false) {}
 };
@@ -23,6 +23,7 @@ namespace common {
 const std::string Constant::kMetaFile = "meta.txt";
 const std::string Constant::kFeatFile = "feat.bin";
 const std::string Constant::kLabelFile = "label.bin";
+const std::string Constant::kFeatScaleFile = "feat_scale.bin";
 const std::string Constant::kIndptrFile = "indptr.bin";
 const std::string Constant::kIndicesFile = "indices.bin";
 const std::string Constant::kTrainSetFile = "train_set.bin";
@@ -31,6 +32,7 @@ const std::string Constant::kValidSetFile = "valid_set.bin";
 
 const std::string Constant::kProbTableFile = "prob_table.bin";
 const std::string Constant::kAliasTableFile = "alias_table.bin";
+const std::string Constant::kAliasWeightTableFile = "alias_weight_table.bin";
 const std::string Constant::kProbPrefixTableFile = "prob_prefix_table.bin";
 
 const std::string Constant::kInDegreeFile = "in_degrees.bin";
@@ -48,6 +50,8 @@ const std::string Constant::kMetaNumClass = "NUM_CLASS";
 const std::string Constant::kMetaNumTrainSet = "NUM_TRAIN_SET";
 const std::string Constant::kMetaNumTestSet = "NUM_TEST_SET";
 const std::string Constant::kMetaNumValidSet = "NUM_VALID_SET";
+const std::string Constant::kMetaFeatType = "FEAT_TYPE";
+const std::string Constant::kMetaLabelType = "LABEL_TYPE";
 
 const std::string Constant::kOMPNumThreads = "SAMGRAPH_OMP_NUM_THREADS";
 const std::string Constant::kEnvProfileLevel = "SAMGRAPH_PROFILE_LEVEL";
@@ -57,6 +61,14 @@ const std::string Constant::kEnvLogNodeAccessSimple = "SAMGRAPH_LOG_NODE_ACCESS_
 const std::string Constant::kEnvSanityCheck = "SAMGRAPH_SANITY_CHECK";
 const std::string Constant::kEnvDumpTrace = "SAMGRAPH_DUMP_TRACE";
 const std::string Constant::kEnvEmptyFeat = "SAMGRAPH_EMPTY_FEAT";
+const std::string Constant::kEnvExtractPrefetch = "SAMGRAPH_EXTRACT_PREFETCH";
+const std::string Constant::kEnvExtractStreamBytes =
+    "SAMGRAPH_EXTRACT_STREAM_BYTES";
+const std::string Constant::kEnvWorkspaceCacheLimit =
+    "SAMGRAPH_WORKSPACE_CACHE_LIMIT";
+const std::string Constant::kEnvWorkspaceIdleTrim =
+    "SAMGRAPH_WORKSPACE_IDLE_TRIM";
+const std::string Constant::kEnvHugePage = "SAMGRAPH_HUGE_PAGE";
 
 const std::string Constant::kNodeAccessLogFile = "node_access";
 const std::string Constant::kNodeAccessFrequencyFile = "node_access_frequency";
@@ -32,6 +32,7 @@ class Constant {
   static const std::string kMetaFile;
   static const std::string kFeatFile;
   static const std::string kLabelFile;
+  static const std::string kFeatScaleFile;
   static const std::string kIndptrFile;
   static const std::string kIndicesFile;
   static const std::string kTrainSetFile;
@@ -40,6 +41,7 @@ class Constant {
 
   static const std::string kProbTableFile;
   static const std::string kAliasTableFile;
+  static const std::string kAliasWeightTableFile;
   static const std::string kProbPrefixTableFile;
 
   static const std::string kInDegreeFile;
@@ -58,6 +60,10 @@ class Constant {
   static const std::string kMetaNumTrainSet;
   static const std::string kMetaNumTestSet;
   static const std::string kMetaNumValidSet;
+  // Optional, the DataType of feat.bin (kF32 by default) and label.bin
+  // (kI64 by default)
+  static const std::string kMetaFeatType;
+  static const std::string kMetaLabelType;
 
   static constexpr size_t kCudaBlockSize = 256;
   static constexpr size_t kCudaTileSize = 1024;
@@ -86,6 +92,11 @@ class Constant {
   static const std::string kEnvSanityCheck;
   static const std::string kEnvDumpTrace;
   static const std::string kEnvEmptyFeat;
+  static const std::string kEnvExtractPrefetch;
+  static const std::string kEnvExtractStreamBytes;
+  static const std::string kEnvWorkspaceCacheLimit;
+  static const std::string kEnvWorkspaceIdleTrim;
+  static const std::string kEnvHugePage;
 
   static const std::string kNodeAccessLogFile;
   static const std::string kNodeAccessFrequencyFile;
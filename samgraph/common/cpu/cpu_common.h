@@ -22,7 +22,21 @@ namespace samgraph {
 namespace common {
 namespace cpu {
 
-enum CPUHashType { kCPUHash0 = 0, kCPUHash1, kCPUHash2 };
+// kCPUHash3 is sized by the batch instead of the graph,
+// kCPUHash4 keeps a bitmap of the graph,
+// kCPUHash5 sorts, its new ids do not depend on the number of threads
+enum CPUHashType {
+  kCPUHash0 = 0,
+  kCPUHash1,
+  kCPUHash2,
+  kCPUHash3,
+  kCPUHash4,
+  kCPUHash5
+};
+
+// Queues between the stages of the arch0 pipeline, named after the stage
+// that takes the tasks
+enum QueueType { kCPUSample = 0, kCPUExtract, kCPUCopy, kNumQueues };
 
 }
 }  // namespace common
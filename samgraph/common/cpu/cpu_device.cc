@@ -23,6 +23,7 @@
 #include <cstring>
 #include <memory>
 
+#include "../huge_page.h"
 #include "../logging.h"
 #include "../workspace_pool.h"
 #include "../run_config.h"
@@ -35,7 +36,16 @@ void CPUDevice::SetDevice(Context ctx) {}
 
 void *CPUDevice::AllocDataSpace(Context ctx, size_t nbytes, size_t alignment) {
   void *ptr;
-  if (ctx.device_id == CPU_CUDA_HOST_MALLOC_DEVICE) {
+  if (UseHugePage(nbytes)) {
+    // the huge pages are pinned by registering them instead
+    ptr = AllocHugePage(nbytes);
+    if (ctx.device_id == CPU_CUDA_HOST_MALLOC_DEVICE) {
+      CUDA_CALL(cudaHostRegister(ptr, RoundUp(nbytes, kHugePageSize),
+                                 cudaHostRegisterDefault));
+    } else {
+      CHECK_EQ(ctx.device_id, CPU_CLIB_MALLOC_DEVICE);
+    }
+  } else if (ctx.device_id == CPU_CUDA_HOST_MALLOC_DEVICE) {
     CUDA_CALL(cudaHostAlloc(&ptr, nbytes, cudaHostAllocDefault));
   } else if (ctx.device_id == CPU_CLIB_MALLOC_DEVICE) {
     int ret = posix_memalign(&ptr, alignment, nbytes);
@@ -48,7 +58,12 @@ void *CPUDevice::AllocDataSpace(Context ctx, size_t nbytes, size_t alignment) {
 }
 
 void CPUDevice::FreeDataSpace(Context ctx, void *ptr) {
-  if (ctx.device_id == CPU_CUDA_HOST_MALLOC_DEVICE) {
+  if (IsHugePage(ptr)) {
+    if (ctx.device_id == CPU_CUDA_HOST_MALLOC_DEVICE) {
+      CUDA_CALL(cudaHostUnregister(ptr));
+    }
+    FreeHugePage(ptr);
+  } else if (ctx.device_id == CPU_CUDA_HOST_MALLOC_DEVICE) {
     CUDA_CALL(cudaFreeHost(ptr));
   } else if (ctx.device_id == CPU_CLIB_MALLOC_DEVICE) {
     free(ptr);
@@ -90,6 +105,20 @@ void CPUDevice::FreeWorkspace(Context ctx, void *data, size_t nbytes) {
   CPUWorkspacePool()->FreeWorkspace(ctx, data);
 }
 
+size_t CPUDevice::WorkspaceSize(Context ctx) {
+  return CPUWorkspacePool()->TotalSize(ctx);
+}
+
+size_t CPUDevice::FreeWorkspaceSize(Context ctx) {
+  return CPUWorkspacePool()->FreeSize(ctx);
+}
+
+WorkspaceStats CPUDevice::GetWorkspaceStats(Context ctx) {
+  return CPUWorkspacePool()->Stats(ctx);
+}
+
+void CPUDevice::TrimWorkspace(Context ctx) { CPUWorkspacePool()->Trim(ctx); }
+
 }  // namespace cpu
 }  // namespace common
 }  // namespace samgraph
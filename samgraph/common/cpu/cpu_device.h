@@ -38,6 +38,10 @@ class CPUDevice final : public Device {
                       Context ctx_to, StreamHandle stream) override;
 
   void StreamSync(Context ctx, StreamHandle stream) override;
+  size_t WorkspaceSize(Context ctx) override;
+  size_t FreeWorkspaceSize(Context ctx) override;
+  WorkspaceStats GetWorkspaceStats(Context ctx) override;
+  void TrimWorkspace(Context ctx) override;
 
   static const std::shared_ptr<CPUDevice> &Global();
 };
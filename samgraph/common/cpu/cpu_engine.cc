@@ -21,16 +21,45 @@
 #include "../device.h"
 #include "../logging.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
 #include "../timer.h"
 #include "cpu_hashtable0.h"
 #include "cpu_hashtable1.h"
 #include "cpu_hashtable2.h"
+#include "cpu_hashtable3.h"
+#include "cpu_hashtable4.h"
+#include "cpu_hashtable5.h"
 #include "cpu_loops.h"
 
 namespace samgraph {
 namespace common {
 namespace cpu {
 
+namespace {
+
+// max_items bounds the nodes of one batch
+CPUHashTable *CreateHashTable(size_t num_node, size_t max_items) {
+  switch (RunConfig::cpu_hash_type) {
+    case kCPUHash0:
+      return new CPUHashTable0(num_node);
+    case kCPUHash1:
+      return new CPUHashTable1(num_node);
+    case kCPUHash2:
+      return new CPUHashTable2(num_node);
+    case kCPUHash3:
+      return new CPUHashTable3(max_items);
+    case kCPUHash4:
+      return new CPUHashTable4(num_node, max_items);
+    case kCPUHash5:
+      return new CPUHashTable5(max_items);
+    default:
+      CHECK(0);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
 CPUEngine::CPUEngine() {
   _initialize = false;
   _should_shutdown = false;
@@ -52,6 +81,17 @@ void CPUEngine::Init() {
   // Check whether the ctx configuration is allowable
   ArchCheck();
 
+  // The kernels of all the stages share these threads
+  const auto &topo = CPUTopology::Get();
+  _placement = PlanPlacement(
+      topo, RunConfig::omp_thread_num, !RunConfig::UseGPUCache(),
+      RunConfig::cpu_sample_thread_num, RunConfig::cpu_extract_thread_num,
+      RunConfig::cpu_pin_thread);
+  ThreadPool::Create(RunConfig::omp_thread_num, _placement.pool_cpus);
+  LOG(INFO) << "CPU Engine runs " << RunConfig::omp_thread_num
+            << " threads on " << topo.ToString() << ": "
+            << _placement.ToString();
+
   // Load the target graph data
   LoadGraphDataset();
 
@@ -63,20 +103,58 @@ void CPUEngine::Init() {
   _shuffler =
       new CPUShuffler(_dataset->train_set, _num_epoch, _batch_size, false);
   _num_step = _shuffler->NumStep();
-  _graph_pool = new GraphPool(RunConfig::max_copying_jobs);
+  _graph_pool =
+      new GraphPool(RunConfig::max_copying_jobs, RunConfig::cpu_ordered_batch);
+
+  // KHop2 shuffles the shared indices in place
+  if (RunConfig::sample_type == kKHop2 &&
+      RunConfig::cpu_num_sample_worker > 1) {
+    LOG(WARNING) << "Multiple sample workers are not supported by "
+                 << RunConfig::sample_type << ", use 1 instead";
+    RunConfig::cpu_num_sample_worker = 1;
+  }
+  CHECK_GT(RunConfig::cpu_num_sample_worker, 0);
+  CHECK_GT(RunConfig::cpu_num_extract_worker, 0);
+
+  // every sampled edge may bring a new node
+  size_t max_items = Min(PredictNumNodes(_batch_size, _fanout, _fanout.size()),
+                         _dataset->num_node);
+  for (size_t i = 0; i < RunConfig::cpu_num_sample_worker; i++) {
+    _hash_tables.push_back(CreateHashTable(_dataset->num_node, max_items));
+  }
 
-  switch (RunConfig::cpu_hash_type) {
-    case kCPUHash0:
-      _hash_table = new CPUHashTable0(_dataset->num_node);
-      break;
-    case kCPUHash1:
-      _hash_table = new CPUHashTable1(_dataset->num_node);
-      break;
-    case kCPUHash2:
-      _hash_table = new CPUHashTable2(_dataset->num_node);
-      break;
-    default:
-      CHECK(0);
+  // only the samplers that buffer their edges per thread can remap on the
+  // fly, and only CPUHashTable2 supports it
+  _fused_remap_tables.assign(RunConfig::cpu_num_sample_worker, nullptr);
+  if (RunConfig::cpu_fused_remap) {
+    bool support_fused = RunConfig::sample_type == kKHop1 ||
+                         RunConfig::sample_type == kKHop3 ||
+                         RunConfig::sample_type == kWeightedKHop ||
+                         RunConfig::sample_type == kWeightedKHopPrefix;
+    if (support_fused && RunConfig::cpu_hash_type == kCPUHash2) {
+      for (size_t i = 0; i < RunConfig::cpu_num_sample_worker; i++) {
+        _fused_remap_tables[i] = static_cast<CPUHashTable2 *>(_hash_tables[i]);
+      }
+    } else {
+      LOG(WARNING) << "Fused remapping is not supported by "
+                   << RunConfig::sample_type << " with type "
+                   << RunConfig::cpu_hash_type << " hashtable, ignored";
+    }
+  }
+
+  _frequency_hashmaps.assign(RunConfig::cpu_num_sample_worker, nullptr);
+  if (RunConfig::sample_type == kRandomWalk) {
+    size_t edges_per_node =
+        RunConfig::num_random_walk * RunConfig::random_walk_length;
+    for (size_t i = 0; i < RunConfig::cpu_num_sample_worker; i++) {
+      _frequency_hashmaps[i] =
+          new CPUFrequencyHashmap(edges_per_node, RunConfig::omp_thread_num);
+    }
+  }
+
+  // Create queues
+  for (int i = 0; i < kNumQueues; i++) {
+    _queues.push_back(new TaskQueue(RunConfig::max_sampling_jobs));
   }
 
   if (RunConfig::UseGPUCache()) {
@@ -91,6 +169,9 @@ void CPUEngine::Init() {
 
   LOG(INFO) << "CPU Engine uses type " << RunConfig::cpu_hash_type
             << " hashtable";
+  LOG(INFO) << "CPU Engine uses " << RunConfig::cpu_num_sample_worker
+            << " sample workers and " << RunConfig::cpu_num_extract_worker
+            << " extract workers";
 
   _initialize = true;
 }
@@ -111,6 +192,13 @@ void CPUEngine::Shutdown() {
   }
 
   _should_shutdown = true;
+  // wake up the threads waiting on the graph pool and the queues
+  if (_graph_pool) {
+    _graph_pool->Stop();
+  }
+  for (auto q : _queues) {
+    q->Stop();
+  }
   int total_thread_num = _threads.size();
 
   while (!IsAllThreadFinish(total_thread_num)) {
@@ -123,6 +211,7 @@ void CPUEngine::Shutdown() {
     delete _threads[i];
     _threads[i] = nullptr;
   }
+  ThreadPool::Destroy();
 
   Device::Get(_trainer_ctx)->StreamSync(_trainer_ctx, _work_stream);
   Device::Get(_trainer_ctx)->FreeStream(_trainer_ctx, _work_stream);
@@ -130,7 +219,20 @@ void CPUEngine::Shutdown() {
   delete _dataset;
   delete _shuffler;
   delete _graph_pool;
-  delete _hash_table;
+
+  for (auto hash_table : _hash_tables) {
+    delete hash_table;
+  }
+
+  for (auto frequency_hashmap : _frequency_hashmaps) {
+    if (frequency_hashmap) {
+      delete frequency_hashmap;
+    }
+  }
+
+  for (auto queue : _queues) {
+    delete queue;
+  }
 
   if (_cache_manager) {
     delete _cache_manager;
@@ -139,10 +241,13 @@ void CPUEngine::Shutdown() {
   _dataset = nullptr;
   _shuffler = nullptr;
   _graph_pool = nullptr;
-  _hash_table = nullptr;
   _cache_manager = nullptr;
 
   _threads.clear();
+  _queues.clear();
+  _hash_tables.clear();
+  _fused_remap_tables.clear();
+  _frequency_hashmaps.clear();
   _joined_thread_cnt = 0;
   _initialize = false;
   _should_shutdown = false;
@@ -173,6 +278,7 @@ std::unordered_map<std::string, Context> CPUEngine::GetGraphFileCtx() {
   ret[Constant::kValidSetFile] = CPU();
   ret[Constant::kProbTableFile] = MMAP();
   ret[Constant::kAliasTableFile] = MMAP();
+  ret[Constant::kAliasWeightTableFile] = MMAP();
   ret[Constant::kInDegreeFile] = MMAP();
   ret[Constant::kOutDegreeFile] = MMAP();
   ret[Constant::kCacheByDegreeFile] = MMAP();
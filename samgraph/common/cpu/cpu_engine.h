@@ -25,8 +25,13 @@
 #include "../cuda/cuda_cache_manager.h"
 #include "../engine.h"
 #include "../logging.h"
+#include "../task_queue.h"
+#include "cpu_common.h"
+#include "cpu_frequency_hashmap.h"
 #include "cpu_hashtable.h"
+#include "cpu_hashtable2.h"
 #include "cpu_shuffler.h"
+#include "cpu_topology.h"
 
 namespace samgraph {
 namespace common {
@@ -44,22 +49,41 @@ class CPUEngine : public Engine {
 
   CPUShuffler* GetShuffler() { return _shuffler; }
   cudaStream_t GetWorkStream() { return _work_stream; }
-  CPUHashTable* GetHashTable() { return _hash_table; }
+  // Every sample worker remaps with its own tables
+  CPUHashTable* GetHashTable(size_t worker_id = 0) {
+    return _hash_tables[worker_id];
+  }
+  CPUFrequencyHashmap* GetFrequencyHashmap(size_t worker_id = 0) {
+    return _frequency_hashmaps[worker_id];
+  }
+  // Non-null when the samplers remap their output on the fly
+  CPUHashTable2* GetFusedRemapTable(size_t worker_id = 0) {
+    return _fused_remap_tables[worker_id];
+  }
   cuda::GPUCacheManager* GetCacheManager() { return _cache_manager; }
+  TaskQueue* GetTaskQueue(QueueType qt) { return _queues[qt]; }
+  const CPUPlacement& GetPlacement() { return _placement; }
 
   static CPUEngine* Get() { return dynamic_cast<CPUEngine*>(Engine::_engine); }
 
  private:
   // Task queue
   std::vector<std::thread*> _threads;
+  std::vector<TaskQueue*> _queues;
 
   cudaStream_t _work_stream;
   // Random node batch generator
   CPUShuffler* _shuffler;
-  // Hash table
-  CPUHashTable* _hash_table;
+  // Hash table of each sample worker
+  std::vector<CPUHashTable*> _hash_tables;
+  // The hash tables again, when fused remapping is enabled
+  std::vector<CPUHashTable2*> _fused_remap_tables;
+  // Frequency hashmaps for random walk
+  std::vector<CPUFrequencyHashmap*> _frequency_hashmaps;
   // GPU cache manager
   cuda::GPUCacheManager* _cache_manager;
+  // Cores and kernel threads of the stages
+  CPUPlacement _placement;
 
   void ArchCheck() override;
   std::unordered_map<std::string, Context> GetGraphFileCtx() override;
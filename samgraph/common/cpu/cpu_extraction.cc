@@ -15,11 +15,15 @@
  *
  */
 
-#include <cassert>
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>
 
 #include "../common.h"
 #include "../logging.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
 #include "cpu_function.h"
 
 namespace samgraph {
@@ -28,92 +32,263 @@ namespace cpu {
 
 namespace {
 
-template <typename T>
-void cpu_extract(void *dst, const void *src, const IdType *index,
-                 size_t num_index, size_t dim) {
-  T *dst_data = reinterpret_cast<T *>(dst);
-  const T *src_data = reinterpret_cast<const T *>(src);
+constexpr size_t kCacheLineBytes = 64;
+// Bytes of output a chunk of the pool covers at least
+constexpr size_t kGatherGrainBytes = 64 * 1024;
 
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_index; ++i) {
-    size_t src_index = index[i];
-#pragma omp simd
-    for (size_t j = 0; j < dim; j++) {
-      dst_data[i * dim + j] = src_data[src_index * dim + j];
+// Non-temporal store of kWidth bytes, dst is aligned to kWidth. The wide
+// stores are compiled for their own targets and only run after
+// MaxStreamWidth has found them on the cpu, so one binary serves every
+// x86-64 host.
+template <size_t kWidth>
+inline void StreamStore(char *dst, const char *src);
+
+template <>
+inline void StreamStore<8>(char *dst, const char *src) {
+  long long val;
+  std::memcpy(&val, src, sizeof(val));
+  _mm_stream_si64(reinterpret_cast<long long *>(dst), val);
+}
+
+template <>
+inline void StreamStore<16>(char *dst, const char *src) {
+  _mm_stream_si128(reinterpret_cast<__m128i *>(dst),
+                   _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+}
+
+template <>
+__attribute__((target("avx"))) inline void StreamStore<32>(char *dst,
+                                                           const char *src) {
+  _mm256_stream_si256(
+      reinterpret_cast<__m256i *>(dst),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)));
+}
+
+template <>
+__attribute__((target("avx512f"))) inline void StreamStore<64>(
+    char *dst, const char *src) {
+  _mm512_stream_si512(reinterpret_cast<__m512i *>(dst),
+                      _mm512_loadu_si512(reinterpret_cast<const void *>(src)));
+}
+
+// The widest non-temporal store of the cpu, SSE2 is part of x86-64
+size_t MaxStreamWidth() {
+  static const size_t width = __builtin_cpu_supports("avx512f") ? 64
+                              : __builtin_cpu_supports("avx")   ? 32
+                                                                : 16;
+  return width;
+}
+
+// kRowBytes is 0 for the rows without a specialised kernel, kWidth is 0
+// for the normal stores
+template <size_t kRowBytes, size_t kWidth>
+__attribute__((always_inline)) inline void CopyRow(char *dst, const char *src,
+                                                   const size_t row_bytes) {
+  const size_t bytes = kRowBytes ? kRowBytes : row_bytes;
+  if (kWidth == 0) {
+    std::memcpy(dst, src, bytes);
+  } else {
+    for (size_t off = 0; off < bytes; off += kWidth) {
+      StreamStore<kWidth ? kWidth : 8>(dst + off, src + off);
     }
   }
 }
 
-template <typename T>
-void cpu_mock_extract(void *dst, const void *src, const IdType *index,
-                 size_t num_index, size_t dim) {
-  T *dst_data = reinterpret_cast<T *>(dst);
-  const T *src_data = reinterpret_cast<const T *>(src);
-  size_t idx_mock_mask = (1ull << RunConfig::option_empty_feat) - 1;
+inline void PrefetchRow(const char *src, const size_t row_bytes) {
+  for (size_t off = 0; off < row_bytes; off += kCacheLineBytes) {
+    __builtin_prefetch(src + off, 0, 1);
+  }
+}
 
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_index; ++i) {
-    size_t src_index = index[i] & idx_mock_mask;
-#pragma omp simd
-    for (size_t j = 0; j < dim; j++) {
-      dst_data[i * dim + j] = src_data[src_index * dim + j];
+struct GatherArgs {
+  char *dst;
+  const char *src;
+  const IdType *index;
+  size_t num_index;
+  size_t row_bytes;
+  size_t mask;
+  size_t distance;
+};
+
+// Rows are copied in order and the row distance ahead is prefetched, the
+// random reads of the feature table are the bottleneck. Always inlined so
+// the wide stores end up in the kernels of their targets.
+template <size_t kRowBytes, size_t kWidth>
+__attribute__((always_inline)) inline void GatherChunk(const GatherArgs &args,
+                                                       size_t begin,
+                                                       size_t end) {
+  const size_t row_bytes = args.row_bytes;
+  const size_t distance = args.distance;
+  for (size_t i = begin; i < end; i++) {
+    if (distance > 0 && i + distance < args.num_index) {
+      const size_t next = args.index[i + distance] & args.mask;
+      PrefetchRow(args.src + next * row_bytes, row_bytes);
     }
+    const size_t row = args.index[i] & args.mask;
+    CopyRow<kRowBytes, kWidth>(args.dst + i * row_bytes,
+                               args.src + row * row_bytes, row_bytes);
+  }
+  if (kWidth > 0) {
+    _mm_sfence();
   }
 }
 
-}  // namespace
+template <size_t kRowBytes, size_t kWidth>
+struct GatherKernel {
+  static void Run(const GatherArgs &args, size_t begin, size_t end) {
+    GatherChunk<kRowBytes, kWidth>(args, begin, end);
+  }
+};
 
-void CPUExtract(void *dst, const void *src, const IdType *index,
-                size_t num_index, size_t dim, DataType dtype) {
-  switch (dtype) {
-    case kF32:
-      cpu_extract<float>(dst, src, index, num_index, dim);
-      break;
-    case kF64:
-      cpu_extract<double>(dst, src, index, num_index, dim);
-      break;
-    case kF16:
-      cpu_extract<short>(dst, src, index, num_index, dim);
+template <size_t kRowBytes>
+struct GatherKernel<kRowBytes, 32> {
+  __attribute__((target("avx"))) static void Run(const GatherArgs &args,
+                                                 size_t begin, size_t end) {
+    GatherChunk<kRowBytes, 32>(args, begin, end);
+  }
+};
+
+template <size_t kRowBytes>
+struct GatherKernel<kRowBytes, 64> {
+  __attribute__((target("avx512f"))) static void Run(const GatherArgs &args,
+                                                     size_t begin,
+                                                     size_t end) {
+    GatherChunk<kRowBytes, 64>(args, begin, end);
+  }
+};
+
+template <size_t kRowBytes, size_t kWidth>
+void GatherRows(char *dst, const char *src, const IdType *index,
+                const size_t num_index, const size_t row_bytes,
+                const size_t mask) {
+  const GatherArgs args = {dst,       src,       index,
+                           num_index, row_bytes, mask,
+                           RunConfig::option_extract_prefetch};
+  const size_t grain = Max<size_t>(kGatherGrainBytes / row_bytes, 1);
+  ParallelFor(0, num_index, grain, [&](size_t begin, size_t end) {
+    GatherKernel<kRowBytes, kWidth>::Run(args, begin, end);
+  });
+}
+
+// The widest non-temporal store that every row is aligned to, 0 for small
+// outputs that may still be read from the cache
+size_t StreamWidth(const void *dst, const size_t num_index,
+                   const size_t row_bytes) {
+  const size_t stream_bytes = RunConfig::option_extract_stream_bytes;
+  if (stream_bytes == 0 || num_index * row_bytes < stream_bytes) {
+    return 0;
+  }
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(dst);
+  for (size_t width = MaxStreamWidth(); width >= 8; width >>= 1) {
+    if (addr % width == 0 && row_bytes % width == 0) {
+      return width;
+    }
+  }
+  return 0;
+}
+
+template <size_t kRowBytes>
+void DispatchWidth(char *dst, const char *src, const IdType *index,
+                   const size_t num_index, const size_t row_bytes,
+                   const size_t mask) {
+  switch (StreamWidth(dst, num_index, row_bytes)) {
+    case 64:
+      GatherRows<kRowBytes, 64>(dst, src, index, num_index, row_bytes, mask);
       break;
-    case kU8:
-      cpu_extract<uint8_t>(dst, src, index, num_index, dim);
+    case 32:
+      GatherRows<kRowBytes, 32>(dst, src, index, num_index, row_bytes, mask);
       break;
-    case kI32:
-      cpu_extract<int32_t>(dst, src, index, num_index, dim);
+    case 16:
+      GatherRows<kRowBytes, 16>(dst, src, index, num_index, row_bytes, mask);
       break;
-    case kI64:
-      cpu_extract<int64_t>(dst, src, index, num_index, dim);
+    case 8:
+      GatherRows<kRowBytes, 8>(dst, src, index, num_index, row_bytes, mask);
       break;
     default:
-      CHECK(0);
+      GatherRows<kRowBytes, 0>(dst, src, index, num_index, row_bytes, mask);
   }
 }
 
-void CPUMockExtract(void *dst, const void *src, const IdType *index,
-                    size_t num_index, size_t dim, DataType dtype) {
-  switch (dtype) {
-    case kF32:
-      cpu_mock_extract<float>(dst, src, index, num_index, dim);
+// Row sizes of the labels and of the float features of the usual datasets
+// (products, papers100M, twitter, uk-2006, reddit) get their own kernels
+void CPUGather(void *dst, const void *src, const IdType *index,
+               const size_t num_index, const size_t row_bytes,
+               const size_t mask) {
+  char *dst_data = static_cast<char *>(dst);
+  const char *src_data = static_cast<const char *>(src);
+  switch (row_bytes) {
+    case 4:
+      DispatchWidth<4>(dst_data, src_data, index, num_index, row_bytes, mask);
+      break;
+    case 8:
+      DispatchWidth<8>(dst_data, src_data, index, num_index, row_bytes, mask);
       break;
-    case kF64:
-      cpu_mock_extract<double>(dst, src, index, num_index, dim);
+    case 100 * 4:
+      DispatchWidth<100 * 4>(dst_data, src_data, index, num_index, row_bytes,
+                             mask);
       break;
-    case kF16:
-      cpu_mock_extract<short>(dst, src, index, num_index, dim);
+    case 128 * 4:
+      DispatchWidth<128 * 4>(dst_data, src_data, index, num_index, row_bytes,
+                             mask);
       break;
-    case kU8:
-      cpu_mock_extract<uint8_t>(dst, src, index, num_index, dim);
+    case 256 * 4:
+      DispatchWidth<256 * 4>(dst_data, src_data, index, num_index, row_bytes,
+                             mask);
       break;
-    case kI32:
-      cpu_mock_extract<int32_t>(dst, src, index, num_index, dim);
+    case 300 * 4:
+      DispatchWidth<300 * 4>(dst_data, src_data, index, num_index, row_bytes,
+                             mask);
       break;
-    case kI64:
-      cpu_mock_extract<int64_t>(dst, src, index, num_index, dim);
+    case 602 * 4:
+      DispatchWidth<602 * 4>(dst_data, src_data, index, num_index, row_bytes,
+                             mask);
       break;
     default:
-      CHECK(0);
+      DispatchWidth<0>(dst_data, src_data, index, num_index, row_bytes, mask);
   }
 }
+
+}  // namespace
+
+void CPUExtract(void *dst, const void *src, const IdType *index,
+                size_t num_index, size_t dim, DataType dtype) {
+  CPUGather(dst, src, index, num_index, dim * GetDataTypeBytes(dtype),
+            ~static_cast<size_t>(0));
+}
+
+void CPUMockExtract(void *dst, const void *src, const IdType *index,
+                    size_t num_index, size_t dim, DataType dtype) {
+  size_t idx_mock_mask = (1ull << RunConfig::option_empty_feat) - 1;
+  CPUGather(dst, src, index, num_index, dim * GetDataTypeBytes(dtype),
+            idx_mock_mask);
+}
+
+void CPUExtractDequant(void *dst, const void *src, const float *scale,
+                       const IdType *index, size_t num_index, size_t dim) {
+  float *dst_data = static_cast<float *>(dst);
+  const int8_t *src_data = static_cast<const int8_t *>(src);
+  const size_t distance = RunConfig::option_extract_prefetch;
+
+  const size_t grain =
+      Max<size_t>(kGatherGrainBytes / (dim * sizeof(float)), 1);
+  ParallelFor(0, num_index, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (distance > 0 && i + distance < num_index) {
+        const IdType next = index[i + distance];
+        const int8_t *next_row = src_data + static_cast<size_t>(next) * dim;
+        PrefetchRow(reinterpret_cast<const char *>(next_row), dim);
+        __builtin_prefetch(scale + next, 0, 1);
+      }
+      const int8_t *row = src_data + static_cast<size_t>(index[i]) * dim;
+      const float row_scale = scale[index[i]];
+#pragma omp simd
+      for (size_t j = 0; j < dim; j++) {
+        dst_data[i * dim + j] = row[j] * row_scale;
+      }
+    }
+  });
+}
+
 }  // namespace cpu
 }  // namespace common
-}  // namespace samgraph
\ No newline at end of file
+}  // namespace samgraph
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "cpu_feature_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "../constant.h"
+#include "../device.h"
+#include "../logging.h"
+#include "../profiler.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
+#include "cpu_radix_sort.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+CPUFeatureStore::CPUFeatureStore(std::string filepath, DataType dtype,
+                                 size_t num_node, size_t dim,
+                                 const IdType *ranking_nodes, size_t num_hot)
+    : _filepath(filepath),
+      _row_bytes(GetDataTypeBytes(dtype) * dim),
+      _num_node(num_node),
+      _num_hot(std::min(num_hot, num_node)),
+      _hot_data(nullptr),
+      _io_shutdown(false) {
+  _fd = open(filepath.c_str(), O_RDONLY, 0);
+  CHECK_GE(_fd, 0) << "Cannot open " << filepath;
+
+  struct stat st;
+  CHECK_EQ(fstat(_fd, &st), 0) << "Cannot stat " << filepath << ": "
+                               << strerror(errno);
+  CHECK_EQ(static_cast<size_t>(st.st_size), num_node * _row_bytes);
+  // the cold rows are read at random, readahead only wastes memory
+  posix_fadvise(_fd, 0, 0, POSIX_FADV_RANDOM);
+
+  // The dist engine builds the store before it forks, so the load runs on
+  // threads of its own instead of starting the pool in the parent
+  const size_t num_thread = RunConfig::omp_thread_num;
+  _hot_slot.resize(num_node);
+  ParallelForOwnThreads(0, num_node, kExtractGrain, num_thread,
+                        [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _hot_slot[i] = Constant::kEmptyKey;
+    }
+  });
+
+  Timer t;
+  if (_num_hot > 0) {
+    // Not allocated by cuda, so the store can be created before the dist
+    // engine forks its workers
+    const Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+    size_t nbytes = _num_hot * _row_bytes;
+    _hot_data = static_cast<char *>(
+        Device::Get(ctx)->AllocDataSpace(ctx, nbytes));
+    if (mlock(_hot_data, nbytes) != 0) {
+      LOG(WARNING) << "Cannot lock the hot features in memory: "
+                   << strerror(errno);
+    }
+
+    std::vector<ColdRow> rows(_num_hot);
+    ParallelForOwnThreads(0, _num_hot, kExtractGrain, num_thread,
+                          [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        _hot_slot[ranking_nodes[i]] = i;
+        rows[i] = {ranking_nodes[i], _hot_data + i * _row_bytes};
+      }
+    });
+    std::sort(rows.begin(), rows.end(), [](const ColdRow &a, const ColdRow &b) {
+      return a.node < b.node;
+    });
+    const std::vector<size_t> requests = MergeRequests(rows);
+    ParallelForOwnThreads(0, requests.size() - 1, 1, num_thread,
+                          [&](size_t begin, size_t end) {
+      std::vector<char> buf;
+      for (size_t r = begin; r < end; r++) {
+        ReadRequest(rows, requests, r, buf);
+      }
+    });
+  }
+
+  LOG(INFO) << "CPUFeatureStore keeps " << _num_hot << " of " << num_node
+            << " rows in memory (" << ToReadableSize(_num_hot * _row_bytes)
+            << ", " << t.Passed() << " secs)";
+}
+
+CPUFeatureStore::~CPUFeatureStore() {
+  {
+    std::lock_guard<std::mutex> lock(_io_mutex);
+    _io_shutdown = true;
+  }
+  _io_cv.notify_all();
+  for (auto &thread : _io_threads) {
+    thread.join();
+  }
+
+  if (_hot_data) {
+    const Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+    munlock(_hot_data, _num_hot * _row_bytes);
+    Device::Get(ctx)->FreeDataSpace(ctx, _hot_data);
+  }
+  close(_fd);
+}
+
+void CPUFeatureStore::Extract(void *dst, const IdType *index,
+                              size_t num_index, uint64_t key) {
+  char *dst_data = static_cast<char *>(dst);
+
+  // 1. Count the cold rows of every chunk
+  // 2. Collect the cold rows of a chunk after those of the chunks before
+  std::vector<ColdRow> rows(num_index);
+  const size_t num_cold = ParallelScan(
+      0, num_index, kExtractGrain, size_t(0),
+      [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+          count += _hot_slot[index[i]] == Constant::kEmptyKey;
+        }
+        return count;
+      },
+      [&](size_t begin, size_t end, size_t pos) {
+        for (size_t i = begin; i < end; i++) {
+          if (_hot_slot[index[i]] == Constant::kEmptyKey) {
+            rows[pos++] = {index[i], dst_data + i * _row_bytes};
+          }
+        }
+      });
+  rows.resize(num_cold);
+
+  // 3. Hand the cold rows to the I/O threads
+  Timer t;
+  std::vector<ColdRow> tmp;
+  RadixSort(rows, tmp, static_cast<IdType>(_num_node - 1),
+            [](const ColdRow &row) { return row.node; });
+  const std::vector<size_t> requests = MergeRequests(rows);
+  ReadJob job;
+  job.rows = &rows;
+  job.requests = &requests;
+  job.next = 0;
+  job.remaining = requests.size() - 1;
+  job.num_reader = 0;
+  SubmitRead(&job);
+
+  // 4. Copy the hot rows while the cold ones are read
+  ParallelFor(0, num_index, kExtractGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const IdType slot = _hot_slot[index[i]];
+      if (slot != Constant::kEmptyKey) {
+        memcpy(dst_data + i * _row_bytes,
+               _hot_data + static_cast<size_t>(slot) * _row_bytes,
+               _row_bytes);
+      }
+    }
+  });
+  WaitRead(&job);
+
+  Profiler::Get().LogStepAdd(key, kLogL1HostHotNodes, num_index - num_cold);
+  Profiler::Get().LogStepAdd(key, kLogL1HostColdNodes, num_cold);
+  Profiler::Get().LogStepAdd(key, kLogL3HostColdReadTime, t.Passed());
+}
+
+// Adjacent rows in file order are merged into one request
+std::vector<size_t> CPUFeatureStore::MergeRequests(
+    const std::vector<ColdRow> &rows) const {
+  const size_t max_rows = std::max<size_t>(kMaxRequestBytes / _row_bytes, 1);
+  std::vector<size_t> requests;
+  for (size_t k = 0; k < rows.size(); k++) {
+    if (k == 0 || rows[k].node != rows[k - 1].node + 1 ||
+        k - requests.back() == max_rows) {
+      requests.push_back(k);
+    }
+  }
+  requests.push_back(rows.size());
+  return requests;
+}
+
+void CPUFeatureStore::ReadRequest(const std::vector<ColdRow> &rows,
+                                  const std::vector<size_t> &requests,
+                                  size_t r, std::vector<char> &buf) const {
+  const size_t begin = requests[r];
+  const size_t count = requests[r + 1] - begin;
+  const size_t offset = rows[begin].node * _row_bytes;
+  if (count == 1) {
+    ReadFile(rows[begin].dst, _row_bytes, offset);
+    return;
+  }
+  buf.resize(count * _row_bytes);
+  ReadFile(buf.data(), count * _row_bytes, offset);
+  for (size_t k = 0; k < count; k++) {
+    memcpy(rows[begin + k].dst, buf.data() + k * _row_bytes, _row_bytes);
+  }
+}
+
+void CPUFeatureStore::SubmitRead(ReadJob *job) {
+  if (job->remaining == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_io_mutex);
+    if (_io_threads.empty()) {
+      const size_t num_thread =
+          std::max<size_t>(RunConfig::host_cache_io_thread_num, 1);
+      for (size_t i = 0; i < num_thread; i++) {
+        _io_threads.emplace_back([this] { IOLoop(); });
+      }
+    }
+    _io_jobs.push_back(job);
+  }
+  _io_cv.notify_all();
+}
+
+// The job lives on the stack of Extract, so it only returns after the last
+// I/O thread has let go of it
+void CPUFeatureStore::WaitRead(ReadJob *job) {
+  std::unique_lock<std::mutex> lock(_io_mutex);
+  _io_done_cv.wait(lock, [job] {
+    return job->remaining == 0 && job->num_reader == 0;
+  });
+}
+
+// Every thread takes requests of the oldest job until none is left, and the
+// first one to run out retires the job from the queue
+void CPUFeatureStore::IOLoop() {
+  std::vector<char> buf;
+  std::unique_lock<std::mutex> lock(_io_mutex);
+  while (true) {
+    _io_cv.wait(lock, [this] { return _io_shutdown || !_io_jobs.empty(); });
+    if (_io_jobs.empty()) {
+      return;
+    }
+    ReadJob *job = _io_jobs.front();
+    job->num_reader++;
+    lock.unlock();
+
+    const size_t num_request = job->requests->size() - 1;
+    size_t r;
+    while ((r = job->next.fetch_add(1)) < num_request) {
+      ReadRequest(*job->rows, *job->requests, r, buf);
+      job->remaining--;
+    }
+
+    lock.lock();
+    if (!_io_jobs.empty() && _io_jobs.front() == job) {
+      _io_jobs.pop_front();
+    }
+    job->num_reader--;
+    if (job->remaining == 0 && job->num_reader == 0) {
+      _io_done_cv.notify_all();
+    }
+  }
+}
+
+void CPUFeatureStore::ReadFile(void *buf, size_t nbytes, size_t offset) const {
+  char *data = static_cast<char *>(buf);
+  while (nbytes > 0) {
+    ssize_t ret = pread(_fd, data, nbytes, offset);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    CHECK_GE(ret, 0) << "Reading " << _filepath << " error: "
+                     << strerror(errno);
+    CHECK_GT(ret, 0) << "Reading " << _filepath << " stopped at offset "
+                     << offset << " with " << nbytes << " bytes left";
+    data += ret;
+    nbytes -= ret;
+    offset += ret;
+  }
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
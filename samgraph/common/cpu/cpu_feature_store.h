@@ -0,0 +1,112 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_CPU_FEATURE_STORE_H
+#define SAMGRAPH_CPU_FEATURE_STORE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// Host feature store for features that do not fit in memory. The hot tier
+// keeps the top ranked rows locked in memory, the cold rows are read from
+// the file with batched pread: a batch is sorted by row, adjacent rows are
+// merged into one request and the requests are issued by a dedicated set of
+// I/O threads to keep the device queue full, while the compute pool copies
+// the hot rows of the batch.
+class CPUFeatureStore {
+ public:
+  CPUFeatureStore(std::string filepath, DataType dtype, size_t num_node,
+                  size_t dim, const IdType *ranking_nodes, size_t num_hot);
+  ~CPUFeatureStore();
+
+  // Gather the rows of index into dst and log the hot and cold rows of the
+  // step with key
+  void Extract(void *dst, const IdType *index, size_t num_index,
+               uint64_t key);
+
+  size_t NumHot() const { return _num_hot; }
+
+ private:
+  struct ColdRow {
+    IdType node;
+    char *dst;
+  };
+
+  // The merged requests of one Extract, shared by the I/O threads
+  struct ReadJob {
+    const std::vector<ColdRow> *rows;
+    // first row of every request and the end of the last one
+    const std::vector<size_t> *requests;
+    std::atomic<size_t> next;
+    std::atomic<size_t> remaining;
+    // I/O threads still holding the job, guarded by _io_mutex
+    size_t num_reader;
+  };
+
+  // rows of a chunk of the pool
+  static constexpr size_t kExtractGrain = 4096;
+  // the largest merged request
+  static constexpr size_t kMaxRequestBytes = 1024 * 1024;
+
+  // Requests of the rows sorted by node
+  std::vector<size_t> MergeRequests(const std::vector<ColdRow> &rows) const;
+  void ReadRequest(const std::vector<ColdRow> &rows,
+                   const std::vector<size_t> &requests, size_t r,
+                   std::vector<char> &buf) const;
+  void ReadFile(void *buf, size_t nbytes, size_t offset) const;
+
+  // The I/O threads start with the first Extract, so the dist engine can
+  // build the store before it forks its workers
+  void SubmitRead(ReadJob *job);
+  void WaitRead(ReadJob *job);
+  void IOLoop();
+
+  int _fd;
+  std::string _filepath;
+  size_t _row_bytes;
+  size_t _num_node;
+  size_t _num_hot;
+
+  char *_hot_data;
+  // hot slot of every node, kEmptyKey for the cold ones
+  std::vector<IdType> _hot_slot;
+
+  std::mutex _io_mutex;
+  std::condition_variable _io_cv;
+  std::condition_variable _io_done_cv;
+  std::deque<ReadJob *> _io_jobs;
+  std::vector<std::thread> _io_threads;
+  bool _io_shutdown;
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_FEATURE_STORE_H
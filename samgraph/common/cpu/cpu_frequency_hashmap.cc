@@ -0,0 +1,184 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "cpu_frequency_hashmap.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../constant.h"
+#include "../device.h"
+#include "../logging.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+namespace {
+
+constexpr size_t kInitGrain = 4096;
+
+}  // namespace
+
+CPUFrequencyHashmap::CPUFrequencyHashmap(const size_t edges_per_node,
+                                         const size_t num_threads,
+                                         const size_t edge_table_scale)
+    : _edges_per_node(edges_per_node), _num_threads(num_threads) {
+  _per_thread_etable_size = 1;
+  while (_per_thread_etable_size < edges_per_node * edge_table_scale) {
+    _per_thread_etable_size <<= 1;
+  }
+  _hash_mask = _per_thread_etable_size - 1;
+
+  size_t etable_bytes =
+      _num_threads * _per_thread_etable_size * sizeof(EdgeBucket);
+  _edge_table = static_cast<EdgeBucket *>(
+      Device::Get(CPU())->AllocDataSpace(CPU(), etable_bytes));
+
+  const size_t num_bucket = _num_threads * _per_thread_etable_size;
+  ParallelFor(0, num_bucket, kInitGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _edge_table[i].key = Constant::kEmptyKey;
+      _edge_table[i].count = 0;
+    }
+  });
+
+  LOG(DEBUG) << "CPUFrequencyHashmap: edge table "
+             << ToReadableSize(etable_bytes);
+}
+
+CPUFrequencyHashmap::~CPUFrequencyHashmap() {
+  Device::Get(CPU())->FreeDataSpace(CPU(), _edge_table);
+}
+
+void CPUFrequencyHashmap::SelectTopK(const IdType *input_dst,
+                                     const IdType *input_nodes,
+                                     const size_t node_begin,
+                                     const size_t node_end, const size_t K,
+                                     EdgeBucket *table,
+                                     TopKBuffer &buffer) const {
+  // reused among batches to avoid allocating in every sampling step
+  static thread_local std::vector<IdType> touched;
+  static thread_local std::vector<EdgeBucket> unique;
+
+  buffer.src.resize((node_end - node_begin) * K);
+  buffer.dst.resize((node_end - node_begin) * K);
+  buffer.data.resize((node_end - node_begin) * K);
+  touched.resize(_edges_per_node);
+  unique.resize(_edges_per_node);
+
+  size_t num_local = 0;
+  for (size_t i = node_begin; i < node_end; i++) {
+    // 1. Count the visits of this seed
+    const IdType *visits = input_dst + i * _edges_per_node;
+    size_t num_unique = 0;
+    for (size_t j = 0; j < _edges_per_node; j++) {
+      const IdType dst = visits[j];
+      if (dst == Constant::kEmptyKey) {
+        continue;
+      }
+
+      IdType pos = EdgeHash(dst);
+      while (table[pos].key != dst && table[pos].key != Constant::kEmptyKey) {
+        pos = (pos + 1) & _hash_mask;
+      }
+      if (table[pos].key == Constant::kEmptyKey) {
+        table[pos].key = dst;
+        touched[num_unique++] = pos;
+      }
+      table[pos].count++;
+    }
+
+    // 2. Gather the unique edges and reset the touched buckets
+    for (size_t j = 0; j < num_unique; j++) {
+      unique[j] = table[touched[j]];
+      table[touched[j]].key = Constant::kEmptyKey;
+      table[touched[j]].count = 0;
+    }
+
+    // 3. Partial top-K selection, ties go to the smaller node id
+    size_t num_selected = num_unique;
+    if (num_unique > K) {
+      std::nth_element(unique.begin(), unique.begin() + K,
+                       unique.begin() + num_unique,
+                       [](const EdgeBucket &a, const EdgeBucket &b) {
+                         return a.count > b.count ||
+                                (a.count == b.count && a.key < b.key);
+                       });
+      num_selected = K;
+    }
+
+    for (size_t j = 0; j < num_selected; j++) {
+      buffer.src[num_local + j] = input_nodes[i];
+      buffer.dst[num_local + j] = unique[j].key;
+      buffer.data[num_local + j] = unique[j].count;
+    }
+    num_local += num_selected;
+  }
+  buffer.num = num_local;
+}
+
+void CPUFrequencyHashmap::GetTopK(const IdType *input_dst,
+                                  const IdType *input_nodes,
+                                  const size_t num_input_node, const size_t K,
+                                  IdType *output_src, IdType *output_dst,
+                                  IdType *output_data, size_t *num_output) {
+  // the part buffers of the calls of this thread, reused among batches
+  static thread_local std::vector<TopKBuffer> my_buffers;
+  std::vector<TopKBuffer> &buffers = my_buffers;
+
+  const size_t num_parts = ThreadBudget::Get();
+  CHECK_LE(num_parts, _num_threads);
+  if (buffers.size() < num_parts) {
+    buffers.resize(num_parts);
+  }
+
+  // 1. Select the top-K edges of every part into its buffer
+  // 2. Merge the buffers into the output after those of the parts before
+  *num_output = ParallelScan(
+      0, num_parts, 1, size_t(0),
+      [&](size_t part_begin, size_t part_end) {
+        size_t count = 0;
+        for (size_t part = part_begin; part < part_end; part++) {
+          const size_t node_begin = num_input_node * part / num_parts;
+          const size_t node_end = num_input_node * (part + 1) / num_parts;
+          SelectTopK(input_dst, input_nodes, node_begin, node_end, K,
+                     _edge_table + part * _per_thread_etable_size,
+                     buffers[part]);
+          count += buffers[part].num;
+        }
+        return count;
+      },
+      [&](size_t part_begin, size_t part_end, size_t out_off) {
+        for (size_t part = part_begin; part < part_end; part++) {
+          const TopKBuffer &buffer = buffers[part];
+          std::memcpy(output_src + out_off, buffer.src.data(),
+                      buffer.num * sizeof(IdType));
+          std::memcpy(output_dst + out_off, buffer.dst.data(),
+                      buffer.num * sizeof(IdType));
+          std::memcpy(output_data + out_off, buffer.data.data(),
+                      buffer.num * sizeof(IdType));
+          out_off += buffer.num;
+        }
+      });
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
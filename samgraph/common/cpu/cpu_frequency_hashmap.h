@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_CPU_FREQUENCY_HASHMAP_H
+#define SAMGRAPH_CPU_FREQUENCY_HASHMAP_H
+
+#include <vector>
+
+#include "../common.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// Counts the visits of random walks and selects the top-K visited nodes of
+// every seed. Seeds are independent, so the seeds are split into one part
+// per thread and every part owns one small open-addressing edge table that
+// is filled by one seed at a time and cleared through the list of touched
+// slots afterwards.
+class CPUFrequencyHashmap {
+ public:
+  static constexpr size_t kDefaultEdgeTableScale = 2;
+
+  CPUFrequencyHashmap(const size_t edges_per_node, const size_t num_threads,
+                      const size_t edge_table_scale = kDefaultEdgeTableScale);
+  ~CPUFrequencyHashmap();
+
+  // input_dst holds edges_per_node visited nodes for every input node,
+  // kEmptyKey marks the unused slots. output_data gets the visit counts.
+  void GetTopK(const IdType *input_dst, const IdType *input_nodes,
+               const size_t num_input_node, const size_t K,
+               IdType *output_src, IdType *output_dst, IdType *output_data,
+               size_t *num_output);
+
+ private:
+  struct EdgeBucket {
+    IdType key;
+    IdType count;
+  };
+
+  // The selected edges of a part of the seeds
+  struct TopKBuffer {
+    std::vector<IdType> src;
+    std::vector<IdType> dst;
+    std::vector<IdType> data;
+    size_t num;
+  };
+
+  // Selects the top-K edges of the seeds in [node_begin, node_end) into
+  // buffer, counting the visits in table
+  void SelectTopK(const IdType *input_dst, const IdType *input_nodes,
+                  const size_t node_begin, const size_t node_end,
+                  const size_t K, EdgeBucket *table,
+                  TopKBuffer &buffer) const;
+
+  EdgeBucket *_edge_table;
+  size_t _edges_per_node;
+  size_t _num_threads;
+  // per-part table size, always a power of two
+  size_t _per_thread_etable_size;
+  IdType _hash_mask;
+
+  inline IdType EdgeHash(const IdType id) const {
+    // multiplicative hashing spreads the clustered node ids
+    return (id * 2654435761u) & _hash_mask;
+  }
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_FREQUENCY_HASHMAP_H
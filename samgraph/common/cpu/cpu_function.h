@@ -24,32 +24,69 @@ namespace samgraph {
 namespace common {
 namespace cpu {
 
+class CPUFrequencyHashmap;
+class CPUHashTable2;
+
+// The samplers with a remap_table argument can remap their output on the
+// fly: with a non-null remap_table, output_src gets the frontier index of
+// the seed and output_dst the local id of the neighbour (see
+// CPUHashTable2::Claim). Pass nullptr to get the global ids.
+
 void CPUSampleKHop0(const IdType *const indptr, const IdType *const indices,
                     const IdType *const input, const size_t num_input,
                     IdType *output_src, IdType *output_dst, size_t *num_ouput,
-                    const size_t fanout);
+                    const size_t fanout, const uint64_t random_stream);
 
 void CPUSampleKHop1(const IdType *const indptr, const IdType *const indices,
                     const IdType *const input, const size_t num_input,
                     IdType *output_src, IdType *output_dst, size_t *num_ouput,
-                    const size_t fanout);
+                    const size_t fanout, const uint64_t random_stream,
+                    CPUHashTable2 *remap_table);
 
 void CPUSampleKHop2(const IdType *const indptr, IdType *indices,
                     const IdType *const input, const size_t num_input,
                     IdType *output_src, IdType *output_dst, size_t *num_ouput,
-                    const size_t fanout);
+                    const size_t fanout, const uint64_t random_stream);
+
+void CPUSampleKHop3(const IdType *const indptr, const IdType *const indices,
+                    const IdType *const input, const size_t num_input,
+                    IdType *output_src, IdType *output_dst, size_t *num_ouput,
+                    const size_t fanout, const uint64_t random_stream,
+                    CPUHashTable2 *remap_table);
 
+// output_data is optional, pass nullptr to skip the edge weights; it needs
+// alias_weight_table of create_alias_table (2 floats per edge)
 void CPUSampleWeightedKHop(const IdType *const indptr,
                            const IdType *const indices,
+                           const float *const prob_table,
+                           const IdType *const alias_table,
+                           const float *const alias_weight_table,
                            const IdType *const input, const size_t num_input,
                            IdType *output_src, IdType *output_dst,
-                           size_t *num_ouput, const size_t fanout);
+                           float *output_data, size_t *num_ouput,
+                           const size_t fanout, const uint64_t random_stream,
+                           CPUHashTable2 *remap_table);
+
+void CPUSampleWeightedKHopPrefix(const IdType *const indptr,
+                                 const IdType *const indices,
+                                 const float *const prob_prefix_table,
+                                 const IdType *const input,
+                                 const size_t num_input, IdType *output_src,
+                                 IdType *output_dst, float *output_data,
+                                 size_t *num_ouput, const size_t fanout,
+                                 const uint64_t random_stream,
+                                 CPUHashTable2 *remap_table);
 
 void CPUSampleRandomWalk(const IdType *const indptr,
                          const IdType *const indices, const IdType *const input,
-                         const size_t num_input, IdType *output_src,
-                         IdType *output_dst, size_t *num_ouput,
-                         const size_t fanout);
+                         const size_t num_input,
+                         const size_t random_walk_length,
+                         const double random_walk_restart_prob,
+                         const size_t num_random_walk, const size_t K,
+                         IdType *output_src, IdType *output_dst,
+                         IdType *output_data, size_t *num_ouput,
+                         CPUFrequencyHashmap *frequency_hashmap,
+                         const uint64_t random_stream, uint64_t task_key);
 
 void CPUExtract(void *dst, const void *src, const IdType *index,
                 size_t num_index, size_t dim, DataType dtype);
@@ -57,7 +94,9 @@ void CPUExtract(void *dst, const void *src, const IdType *index,
 void CPUMockExtract(void *dst, const void *src, const IdType *index,
                 size_t num_index, size_t dim, DataType dtype);
 
-IdType RandomID(const IdType &min, const IdType &max);
+// Gather kI8 rows into kF32, each row multiplied by its scale
+void CPUExtractDequant(void *dst, const void *src, const float *scale,
+                       const IdType *index, size_t num_index, size_t dim);
 
 void CPUSanityCheckList(const IdType *input, size_t num_input,
                         IdType invalid_val);
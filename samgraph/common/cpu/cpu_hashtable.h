@@ -24,6 +24,10 @@ namespace samgraph {
 namespace common {
 namespace cpu {
 
+// Items a chunk of the thread pool covers at least, the per-item work of
+// the tables is a few memory accesses
+constexpr size_t kHashTableGrain = 4096;
+
 class CPUHashTable {
  public:
   virtual ~CPUHashTable() {}
@@ -17,6 +17,8 @@
 
 #include "cpu_hashtable0.h"
 
+#include <cstring>
+
 #include "../device.h"
 #include "../logging.h"
 
@@ -24,6 +24,7 @@
 #include "../device.h"
 #include "../logging.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
 #include "../timer.h"
 
 namespace samgraph {
@@ -48,54 +49,59 @@ CPUHashTable1::~CPUHashTable1() {
 }
 
 void CPUHashTable1::Populate(const IdType *input, const size_t num_input) {
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_input; i++) {
-    IdType id = input[i];
-    const IdType key = __sync_val_compare_and_swap(&_o2n_table[id].id,
-                                                   Constant::kEmptyKey, id);
-    if (key == Constant::kEmptyKey) {
-      IdType local = __sync_fetch_and_add(&_num_items, 1);
-      _o2n_table[id].local = local;
-      _n2o_table[local].global = id;
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      IdType id = input[i];
+      const IdType key = __sync_val_compare_and_swap(&_o2n_table[id].id,
+                                                     Constant::kEmptyKey, id);
+      if (key == Constant::kEmptyKey) {
+        IdType local = __sync_fetch_and_add(&_num_items, 1);
+        _o2n_table[id].local = local;
+        _n2o_table[local].global = id;
+      }
     }
-  }
+  });
 }
 
 void CPUHashTable1::MapNodes(IdType *output, size_t num_ouput) {
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_ouput; i++) {
-    output[i] = _n2o_table[i].global;
-  }
+  ParallelFor(0, num_ouput, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      output[i] = _n2o_table[i].global;
+    }
+  });
 }
 
 void CPUHashTable1::MapEdges(const IdType *src, const IdType *dst,
                              const size_t len, IdType *new_src,
                              IdType *new_dst) {
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < len; i++) {
-    BucketO2N &bucket0 = _o2n_table[src[i]];
-    BucketO2N &bucket1 = _o2n_table[dst[i]];
+  ParallelFor(0, len, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      BucketO2N &bucket0 = _o2n_table[src[i]];
+      BucketO2N &bucket1 = _o2n_table[dst[i]];
 
-    new_src[i] = bucket0.local;
-    new_dst[i] = bucket1.local;
-  }
+      new_src[i] = bucket0.local;
+      new_dst[i] = bucket1.local;
+    }
+  });
 }
 
 void CPUHashTable1::Reset() {
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < _num_items; i++) {
-    IdType key = _n2o_table[i].global;
-    _o2n_table[key].id = Constant::kEmptyKey;
-  }
+  ParallelFor(0, _num_items, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      IdType key = _n2o_table[i].global;
+      _o2n_table[key].id = Constant::kEmptyKey;
+    }
+  });
   _num_items = 0;
 }
 
 void CPUHashTable1::InitTable() {
   _num_items = 0;
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < _capacity; i++) {
-    _o2n_table[i].id = Constant::kEmptyKey;
-  }
+  ParallelFor(0, _capacity, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _o2n_table[i].id = Constant::kEmptyKey;
+    }
+  });
 }
 
 }  // namespace cpu
@@ -17,8 +17,7 @@
 
 #include "cpu_hashtable2.h"
 
-#include <omp.h>
-
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 
@@ -26,6 +25,7 @@
 #include "../device.h"
 #include "../logging.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
 #include "../timer.h"
 
 namespace samgraph {
@@ -52,57 +52,62 @@ CPUHashTable2::~CPUHashTable2() {
 
 void CPUHashTable2::Populate(const IdType *input, const size_t num_input) {
   // 1. Populate the hashtable
-  // Note: OMP should use static schedule
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_input; i++) {
-    IdType id = input[i];
-    const IdType key = __sync_val_compare_and_swap(&_o2n_table[id].key,
-                                                   Constant::kEmptyKey, id);
-    if (key == Constant::kEmptyKey) {
-      _o2n_table[id].index = i;
-      _o2n_table[id].version = _version;
-    }
-  }
-
-  // 2. Count the number of insert
-  // Note: OMP should use static schedule
-  std::vector<PrefixItem> items_prefix(RunConfig::omp_thread_num + 1);
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_input; i++) {
-    IdType id = input[i];
-    IdType my_thread_idx = omp_get_thread_num();
-    const BucketO2N &bucket = _o2n_table[id];
-    if (bucket.index == i && bucket.version == _version) {
-      items_prefix[my_thread_idx].val++;
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      IdType id = input[i];
+      const IdType key = __sync_val_compare_and_swap(&_o2n_table[id].key,
+                                                     Constant::kEmptyKey, id);
+      if (key == Constant::kEmptyKey) {
+        _o2n_table[id].index = i;
+        _o2n_table[id].version = _version;
+      }
     }
-  }
-
-  // 3. Single-thread prefix sum
-  size_t prefix_sum = 0;
-  for (int i = 0; i <= RunConfig::omp_thread_num; i++) {
-    size_t tmp = items_prefix[i].val;
-    items_prefix[i].val = prefix_sum;
-    prefix_sum += tmp;
-  }
+  });
 
-  // 4. Map old id to new id
-  // Note: OMP should use static schedule
-  IdType start_off = _num_items;
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_input; i++) {
-    IdType id = input[i];
-    IdType my_thread_idx = omp_get_thread_num();
-    BucketO2N &bucket = _o2n_table[id];
-    if (bucket.index == i && bucket.version == _version) {
-      IdType new_id = start_off + items_prefix[my_thread_idx].val;
-      bucket.local = new_id;
-      _n2o_table[new_id].global = id;
-      items_prefix[my_thread_idx].val++;
+  // Keep the first occurrence instead of the CAS winner, so the new ids do
+  // not depend on the number of threads
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      BucketO2N &bucket = _o2n_table[input[i]];
+      if (bucket.version != _version) {
+        continue;
+      }
+      IdType index = bucket.index;
+      while (i < index) {
+        IdType old = __sync_val_compare_and_swap(&bucket.index, index, i);
+        if (old == index) {
+          break;
+        }
+        index = old;
+      }
     }
-  }
+  });
 
-  IdType new_inserted = items_prefix[RunConfig::omp_thread_num].val;
-  _num_items += new_inserted;
+  // 2. Count the first occurrences of every chunk
+  // 3. Number them after those of the chunks before, in input order
+  auto is_new = [&](size_t i) {
+    const BucketO2N &bucket = _o2n_table[input[i]];
+    return bucket.index == i && bucket.version == _version;
+  };
+  _num_items = ParallelScan(
+      0, num_input, kHashTableGrain, static_cast<size_t>(_num_items),
+      [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+          count += is_new(i);
+        }
+        return count;
+      },
+      [&](size_t begin, size_t end, size_t new_id) {
+        for (size_t i = begin; i < end; i++) {
+          if (is_new(i)) {
+            IdType id = input[i];
+            _o2n_table[id].local = new_id;
+            _n2o_table[new_id].global = id;
+            new_id++;
+          }
+        }
+      });
   _version++;
 }
 
@@ -164,31 +169,122 @@ void CPUHashTable2::Populate(const IdType *input, const size_t num_input) {
 
 void CPUHashTable2::MapNodes(IdType *output, size_t num_ouput) {
   CHECK_LE(num_ouput, _num_items);
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_ouput; i++) {
-    output[i] = _n2o_table[i].global;
-  }
+  ParallelFor(0, num_ouput, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      output[i] = _n2o_table[i].global;
+    }
+  });
 }
 
 void CPUHashTable2::MapEdges(const IdType *src, const IdType *dst,
                              const size_t len, IdType *new_src,
                              IdType *new_dst) {
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < len; i++) {
-    BucketO2N &bucket0 = _o2n_table[src[i]];
-    BucketO2N &bucket1 = _o2n_table[dst[i]];
+  ParallelFor(0, len, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      BucketO2N &bucket0 = _o2n_table[src[i]];
+      BucketO2N &bucket1 = _o2n_table[dst[i]];
+
+      new_src[i] = bucket0.local;
+      new_dst[i] = bucket1.local;
+    }
+  });
+}
 
-    new_src[i] = bucket0.local;
-    new_dst[i] = bucket1.local;
+// key and index share one 64-bit word, so a node is claimed and its first
+// seed is lowered with a single CAS. version and local are only written by
+// the thread that moves the key out of kEmptyKey, and only read by
+// MapClaimed once all chunks are done.
+void CPUHashTable2::Claim(const IdType *nodes, const size_t num_nodes,
+                          const IdType seed_idx) {
+  static_assert(offsetof(BucketO2N, index) == sizeof(IdType),
+                "key and index must be adjacent");
+  for (size_t i = 0; i < num_nodes; i++) {
+    const IdType id = nodes[i];
+    BucketO2N &bucket = _o2n_table[id];
+    uint64_t *word = reinterpret_cast<uint64_t *>(&bucket.key);
+    const uint64_t claimed = (static_cast<uint64_t>(seed_idx) << 32) | id;
+
+    uint64_t old = __atomic_load_n(word, __ATOMIC_RELAXED);
+    while (true) {
+      const IdType key = static_cast<IdType>(old);
+      const IdType index = static_cast<IdType>(old >> 32);
+      if (key != Constant::kEmptyKey && index <= seed_idx) {
+        break;
+      }
+      const uint64_t prev = __sync_val_compare_and_swap(word, old, claimed);
+      if (prev == old) {
+        if (key == Constant::kEmptyKey) {
+          bucket.version = _version;
+          bucket.local = Constant::kEmptyKey;
+        }
+        break;
+      }
+      old = prev;
+    }
   }
 }
 
-void CPUHashTable2::Reset() {
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < _num_items; i++) {
-    IdType key = _n2o_table[i].global;
-    _o2n_table[key].key = Constant::kEmptyKey;
+void CPUHashTable2::MapClaimed(const std::vector<ClaimedChunk> &chunks) {
+  if (_claimed_nodes.size() < chunks.size()) {
+    _claimed_nodes.resize(chunks.size());
   }
+
+  // 1. A node is new if it was claimed in this round, the chunk that holds
+  //    its first seed numbers it in the order of the first occurrence
+  // 2. The numbers of a chunk are offset by the new nodes of the chunks
+  //    before it
+  _num_items = ParallelScan(
+      0, chunks.size(), 1, _num_items,
+      [&](size_t c_begin, size_t c_end) {
+        IdType count = 0;
+        for (size_t c = c_begin; c < c_end; c++) {
+          const ClaimedChunk &chunk = chunks[c];
+          std::vector<IdType> &new_nodes = _claimed_nodes[c];
+          new_nodes.clear();
+          for (size_t i = 0; i < chunk.len; i++) {
+            BucketO2N &bucket = _o2n_table[chunk.dst[i]];
+            if (bucket.version == _version &&
+                bucket.index == chunk.seed_idx[i] &&
+                bucket.local == Constant::kEmptyKey) {
+              bucket.local = new_nodes.size();
+              new_nodes.push_back(chunk.dst[i]);
+            }
+          }
+          count += new_nodes.size();
+        }
+        return count;
+      },
+      [&](size_t c_begin, size_t c_end, IdType start_off) {
+        for (size_t c = c_begin; c < c_end; c++) {
+          const std::vector<IdType> &new_nodes = _claimed_nodes[c];
+          for (size_t j = 0; j < new_nodes.size(); j++) {
+            const IdType id = new_nodes[j];
+            _o2n_table[id].local += start_off;
+            _n2o_table[start_off + j].global = id;
+          }
+          start_off += new_nodes.size();
+        }
+      });
+
+  // 3. Map the buffered edges
+  ParallelFor(0, chunks.size(), 1, [&](size_t c_begin, size_t c_end) {
+    for (size_t c = c_begin; c < c_end; c++) {
+      const ClaimedChunk &chunk = chunks[c];
+      for (size_t i = 0; i < chunk.len; i++) {
+        chunk.dst[i] = _o2n_table[chunk.dst[i]].local;
+      }
+    }
+  });
+  _version++;
+}
+
+void CPUHashTable2::Reset() {
+  ParallelFor(0, _num_items, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      IdType key = _n2o_table[i].global;
+      _o2n_table[key].key = Constant::kEmptyKey;
+    }
+  });
   _num_items = 0;
   _version = 0;
 }
@@ -196,10 +292,11 @@ void CPUHashTable2::Reset() {
 void CPUHashTable2::InitTable() {
   _num_items = 0;
   _version = 0;
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < _capacity; i++) {
-    _o2n_table[i].key = Constant::kEmptyKey;
-  }
+  ParallelFor(0, _capacity, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _o2n_table[i].key = Constant::kEmptyKey;
+    }
+  });
 }
 
 }  // namespace cpu
@@ -18,6 +18,8 @@
 #ifndef SAMGRAPH_CPU_HASHTABLE2_H
 #define SAMGRAPH_CPU_HASHTABLE2_H
 
+#include <vector>
+
 #include "../common.h"
 #include "cpu_hashtable.h"
 
@@ -38,6 +40,26 @@ class CPUHashTable2 : public CPUHashTable {
   void Reset() override;
   size_t NumItems() const override { return _num_items; }
 
+  // The edges one chunk of a sampler buffered, in seed order
+  struct ClaimedChunk {
+    const IdType *seed_idx;
+    IdType *dst;
+    size_t len;
+  };
+
+  // Fused sampling and remapping, used by the samplers that buffer their
+  // edges per chunk of seeds. Seed i of the frontier must have the local id
+  // i, which holds since every frontier is the MapNodes output of the
+  // previous layer.
+  //   1. the chunks call Claim with the nodes they draw from seed i
+  //   2. once all chunks are done, MapClaimed gets the buffered edges of
+  //      every chunk in seed order, dst is rewritten to local ids in place
+  // The new nodes get the same local ids as Populate over the merged
+  // sampler output would give them.
+  void Claim(const IdType *nodes, const size_t num_nodes,
+             const IdType seed_idx);
+  void MapClaimed(const std::vector<ClaimedChunk> &chunks);
+
  private:
   struct BucketO2N {
     IdType key;
@@ -50,13 +72,6 @@ class CPUHashTable2 : public CPUHashTable {
     IdType global;
   };
 
-  struct PrefixItem {
-    size_t val;
-    size_t _padding[7];
-
-    PrefixItem() : val(0) {}
-  };
-
   BucketO2N *_o2n_table;
   BucketN2O *_n2o_table;
 
@@ -64,6 +79,9 @@ class CPUHashTable2 : public CPUHashTable {
   size_t _capacity;
   IdType _version;
 
+  // the nodes first claimed by every chunk, reused among batches
+  std::vector<std::vector<IdType>> _claimed_nodes;
+
   void InitTable();
 };
 
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "cpu_hashtable3.h"
+
+#include "../common.h"
+#include "../constant.h"
+#include "../device.h"
+#include "../logging.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+CPUHashTable3::CPUHashTable3(size_t max_items) {
+  // at most half full, and at least two groups for the hash shift
+  size_t num_groups = 2;
+  while (num_groups * kGroupSize < 2 * max_items) {
+    num_groups <<= 1;
+  }
+
+  _max_items = max_items;
+  _num_slots = num_groups * kGroupSize;
+  _group_mask = num_groups - 1;
+  _hash_shift = 64;
+  for (size_t n = num_groups; n > 1; n >>= 1) {
+    _hash_shift--;
+  }
+
+  const Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  _o2n_table = static_cast<BucketO2N *>(Device::Get(ctx)->AllocDataSpace(
+      ctx, _num_slots * sizeof(BucketO2N), kGroupSize * sizeof(BucketO2N)));
+  _n2o_table = static_cast<BucketN2O *>(
+      Device::Get(ctx)->AllocDataSpace(ctx, max_items * sizeof(BucketN2O)));
+
+  LOG(INFO) << "CPUHashTable3 holds " << max_items << " nodes in "
+            << ToReadableSize(_num_slots * sizeof(BucketO2N) +
+                              max_items * sizeof(BucketN2O));
+
+  InitTable();
+}
+
+CPUHashTable3::~CPUHashTable3() {
+  const Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  Device::Get(ctx)->FreeDataSpace(ctx, _o2n_table);
+  Device::Get(ctx)->FreeDataSpace(ctx, _n2o_table);
+}
+
+// Insert into the first free slot of the first group that has one, so a
+// key is never stored twice: a thread that loses the CAS rereads the group
+// and finds the key if the winner inserted the same one.
+size_t CPUHashTable3::Insert(const IdType id, const size_t i) {
+  const uint64_t tag = Tag(id);
+  size_t group = HomeGroup(id);
+  for (size_t probe = 0; probe <= _group_mask;) {
+    BucketO2N *buckets = _o2n_table + group * kGroupSize;
+    uint64_t cur[kGroupSize];
+    uint32_t match = 0;
+    uint32_t empty = 0;
+#pragma omp simd reduction(| : match, empty)
+    for (size_t k = 0; k < kGroupSize; k++) {
+      cur[k] = buckets[k].tag;
+      match |= static_cast<uint32_t>(cur[k] == tag) << k;
+      empty |= static_cast<uint32_t>((cur[k] >> 32) != _version) << k;
+    }
+
+    if (match) {
+      return group * kGroupSize + __builtin_ctz(match);
+    }
+    if (empty) {
+      const size_t k = __builtin_ctz(empty);
+      if (__sync_bool_compare_and_swap(&buckets[k].tag, cur[k], tag)) {
+        buckets[k].index = i;
+        buckets[k].local = Constant::kEmptyKey;
+        return group * kGroupSize + k;
+      }
+      continue;
+    }
+
+    group = (group + 1) & _group_mask;
+    probe++;
+  }
+
+  CHECK(false) << "CPUHashTable3 is full, " << _max_items
+               << " items are predicted";
+  return 0;
+}
+
+size_t CPUHashTable3::Lookup(const IdType id) const {
+  const uint64_t tag = Tag(id);
+  size_t group = HomeGroup(id);
+  for (size_t probe = 0; probe <= _group_mask; probe++) {
+    const BucketO2N *buckets = _o2n_table + group * kGroupSize;
+    uint32_t match = 0;
+    uint32_t empty = 0;
+#pragma omp simd reduction(| : match, empty)
+    for (size_t k = 0; k < kGroupSize; k++) {
+      match |= static_cast<uint32_t>(buckets[k].tag == tag) << k;
+      empty |= static_cast<uint32_t>((buckets[k].tag >> 32) != _version) << k;
+    }
+
+    if (match) {
+      return group * kGroupSize + __builtin_ctz(match);
+    }
+    // the key would be in this group
+    if (empty) {
+      break;
+    }
+    group = (group + 1) & _group_mask;
+  }
+
+  CHECK(false) << "Node " << id << " is not in CPUHashTable3";
+  return 0;
+}
+
+void CPUHashTable3::Populate(const IdType *input, const size_t num_input) {
+  _input_slots.resize(num_input);
+
+  // 1. Populate the hashtable
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _input_slots[i] = Insert(input[i], i);
+    }
+  });
+
+  // Keep the first occurrence instead of the CAS winner, so the new ids do
+  // not depend on the number of threads. Only the new nodes have no local
+  // id yet.
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      BucketO2N &bucket = _o2n_table[_input_slots[i]];
+      if (bucket.local != Constant::kEmptyKey) {
+        continue;
+      }
+      IdType index = bucket.index;
+      while (i < index) {
+        IdType old = __sync_val_compare_and_swap(&bucket.index, index, i);
+        if (old == index) {
+          break;
+        }
+        index = old;
+      }
+    }
+  });
+
+  // 2. Count the first occurrences of every chunk
+  // 3. Number them after those of the chunks before, in input order
+  auto is_new = [&](size_t i) {
+    const BucketO2N &bucket = _o2n_table[_input_slots[i]];
+    return bucket.index == i && bucket.local == Constant::kEmptyKey;
+  };
+  _num_items = ParallelScan(
+      0, num_input, kHashTableGrain, static_cast<size_t>(_num_items),
+      [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+          count += is_new(i);
+        }
+        return count;
+      },
+      [&](size_t begin, size_t end, size_t new_id) {
+        for (size_t i = begin; i < end; i++) {
+          if (is_new(i)) {
+            CHECK_LT(new_id, _max_items);
+            _o2n_table[_input_slots[i]].local = new_id;
+            _n2o_table[new_id].global = input[i];
+            new_id++;
+          }
+        }
+      });
+}
+
+void CPUHashTable3::MapNodes(IdType *output, size_t num_ouput) {
+  CHECK_LE(num_ouput, _num_items);
+  ParallelFor(0, num_ouput, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      output[i] = _n2o_table[i].global;
+    }
+  });
+}
+
+void CPUHashTable3::MapEdges(const IdType *src, const IdType *dst,
+                             const size_t len, IdType *new_src,
+                             IdType *new_dst) {
+  ParallelFor(0, len, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      new_src[i] = _o2n_table[Lookup(src[i])].local;
+      new_dst[i] = _o2n_table[Lookup(dst[i])].local;
+    }
+  });
+}
+
+// The tags of the previous batch do not match the new version anymore
+void CPUHashTable3::Reset() {
+  _num_items = 0;
+  _version++;
+  if (_version == 0) {
+    InitTable();
+  }
+}
+
+void CPUHashTable3::InitTable() {
+  _num_items = 0;
+  _version = 1;
+  ParallelFor(0, _num_slots, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _o2n_table[i].tag = 0;
+    }
+  });
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
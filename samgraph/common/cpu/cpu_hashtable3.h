@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef SAMGRAPH_CPU_HASHTABLE3_H
+#define SAMGRAPH_CPU_HASHTABLE3_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../common.h"
+#include "cpu_hashtable.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// An open-addressing parallel hashtable sized by the nodes of one batch
+// instead of the nodes of the graph. Slots are probed linearly in groups of
+// one cache line, whose tags are compared at once with simd. A tag holds the
+// key and the version of the batch that inserted it, so Reset only bumps
+// the version. The new ids follow the first occurrence like CPUHashTable2.
+// The table is not pinned, it never takes part in a cuda copy.
+class CPUHashTable3 : public CPUHashTable {
+ public:
+  CPUHashTable3(size_t max_items);
+  ~CPUHashTable3();
+
+  void Populate(const IdType *input, const size_t num_input) override;
+  void MapNodes(IdType *ouput, size_t num_output) override;
+  void MapEdges(const IdType *src, const IdType *dst, const size_t len,
+                IdType *new_src, IdType *new_dst) override;
+  void Reset() override;
+  size_t NumItems() const override { return _num_items; }
+
+ private:
+  // slots per cache line
+  static constexpr size_t kGroupSize = 4;
+
+  struct BucketO2N {
+    // version << 32 | key
+    uint64_t tag;
+    IdType index;
+    IdType local;
+  };
+
+  struct BucketN2O {
+    IdType global;
+  };
+
+  BucketO2N *_o2n_table;
+  BucketN2O *_n2o_table;
+
+  IdType _num_items;
+  size_t _max_items;
+  size_t _num_slots;
+  size_t _group_mask;
+  int _hash_shift;
+  uint32_t _version;
+
+  // slot of every input of the current Populate
+  std::vector<size_t> _input_slots;
+
+  void InitTable();
+  size_t Insert(const IdType id, const size_t i);
+  size_t Lookup(const IdType id) const;
+
+  inline size_t HomeGroup(const IdType id) const {
+    return (static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ull) >> _hash_shift;
+  }
+  inline uint64_t Tag(const IdType id) const {
+    return (static_cast<uint64_t>(_version) << 32) | id;
+  }
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_HASHTABLE3_H
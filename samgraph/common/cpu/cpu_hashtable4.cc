@@ -0,0 +1,226 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "cpu_hashtable4.h"
+
+#include <algorithm>
+
+#include "../common.h"
+#include "../device.h"
+#include "../logging.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+CPUHashTable4::CPUHashTable4(size_t num_node, size_t max_items) {
+  _num_words = RoundUpDiv(num_node, static_cast<size_t>(64));
+  _max_items = max_items;
+
+  const Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  _bitmap = static_cast<uint64_t *>(
+      Device::Get(ctx)->AllocDataSpace(ctx, _num_words * sizeof(uint64_t)));
+  _word_record = static_cast<IdType *>(
+      Device::Get(ctx)->AllocDataSpace(ctx, _num_words * sizeof(IdType)));
+  _n2o_table = static_cast<BucketN2O *>(
+      Device::Get(ctx)->AllocDataSpace(ctx, max_items * sizeof(BucketN2O)));
+  _rank_local.reserve(max_items);
+  _next_rank_local.reserve(max_items);
+
+  LOG(INFO) << "CPUHashTable4 holds " << max_items << " nodes in "
+            << ToReadableSize(_num_words *
+                                  (sizeof(uint64_t) + sizeof(IdType)) +
+                              max_items * (sizeof(BucketN2O) +
+                                           2 * sizeof(IdType)));
+
+  ParallelFor(0, _num_words, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      _bitmap[i] = 0;
+    }
+  });
+  _num_items = 0;
+}
+
+CPUHashTable4::~CPUHashTable4() {
+  const Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  Device::Get(ctx)->FreeDataSpace(ctx, _bitmap);
+  Device::Get(ctx)->FreeDataSpace(ctx, _word_record);
+  Device::Get(ctx)->FreeDataSpace(ctx, _n2o_table);
+}
+
+// Add the words touched for the first time to the sorted records
+void CPUHashTable4::MergeWords(std::vector<IdType> &fresh) {
+  if (fresh.empty()) {
+    return;
+  }
+  std::sort(fresh.begin(), fresh.end());
+
+  std::vector<WordRecord> merged(_records.size() + fresh.size());
+  size_t r = 0;
+  size_t f = 0;
+  for (size_t k = 0; k < merged.size(); k++) {
+    if (f == fresh.size() ||
+        (r < _records.size() && _records[r].word < fresh[f])) {
+      merged[k] = _records[r++];
+    } else {
+      merged[k] = {0, 0, fresh[f++]};
+    }
+  }
+  _records.swap(merged);
+
+  const size_t num_record = _records.size();
+  ParallelFor(0, num_record, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t k = begin; k < end; k++) {
+      _word_record[_records[k].word] = k;
+    }
+  });
+}
+
+void CPUHashTable4::Populate(const IdType *input, const size_t num_input) {
+  const bool keep_order = (_num_items == 0);
+
+  // 1. Set the bits, the chunk that sets the first bit of a word owns it
+  NewWords new_words = ParallelReduce(
+      0, num_input, kHashTableGrain, NewWords{0, {}},
+      [&](size_t begin, size_t end) {
+        NewWords chunk{0, {}};
+        for (size_t i = begin; i < end; i++) {
+          const IdType id = input[i];
+          const uint64_t bit = 1ull << (id & 63);
+          const uint64_t old =
+              __atomic_fetch_or(&_bitmap[id >> 6], bit, __ATOMIC_RELAXED);
+          if ((old & bit) == 0) {
+            chunk.num_new++;
+            if (old == 0) {
+              chunk.words.push_back(id >> 6);
+            }
+          }
+        }
+        return chunk;
+      },
+      [](NewWords total, NewWords chunk) {
+        total.num_new += chunk.num_new;
+        total.words.insert(total.words.end(), chunk.words.begin(),
+                           chunk.words.end());
+        return total;
+      });
+
+  const size_t num_new = new_words.num_new;
+  CHECK_LE(_num_items + num_new, _max_items);
+  if (keep_order) {
+    CHECK_EQ(num_new, num_input)
+        << "the first input of CPUHashTable4 must be unique";
+  }
+
+  // 2. Every touched word needs a record
+  MergeWords(new_words.words);
+
+  // 3. Lay the words out again in _next_rank_local. The nodes of a word
+  //    keep their ids, the new ones are numbered by ascending id.
+  const size_t num_records = _records.size();
+  _next_rank_local.resize(_num_items + num_new);
+  ParallelScan(
+      0, num_records, kHashTableGrain, RankCount{0, _num_items},
+      [&](size_t begin, size_t end) {
+        RankCount count{0, 0};
+        for (size_t r = begin; r < end; r++) {
+          const uint64_t cur = _bitmap[_records[r].word];
+          count.num_rank += __builtin_popcountll(cur);
+          count.num_fresh += __builtin_popcountll(cur & ~_records[r].seen);
+        }
+        return count;
+      },
+      [&](size_t begin, size_t end, RankCount prefix) {
+        size_t rank_off = prefix.num_rank;
+        size_t new_off = prefix.num_fresh;
+        for (size_t r = begin; r < end; r++) {
+          WordRecord &record = _records[r];
+          const uint64_t cur = _bitmap[record.word];
+          size_t old_rank = record.base;
+          record.base = rank_off;
+          for (uint64_t bits = cur; bits; bits &= bits - 1) {
+            const uint64_t bit = bits & (~bits + 1);
+            if (record.seen & bit) {
+              _next_rank_local[rank_off] = _rank_local[old_rank++];
+            } else if (!keep_order) {
+              const IdType id = (record.word << 6) | __builtin_ctzll(bits);
+              _next_rank_local[rank_off] = new_off;
+              _n2o_table[new_off].global = id;
+              new_off++;
+            }
+            rank_off++;
+          }
+          record.seen = cur;
+        }
+      });
+
+  // 4. The first input is unique, so its ids are its positions
+  if (keep_order) {
+    ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        const IdType id = input[i];
+        const WordRecord &record = _records[_word_record[id >> 6]];
+        const uint64_t below = record.seen & ((1ull << (id & 63)) - 1);
+        _next_rank_local[record.base + __builtin_popcountll(below)] =
+            _num_items + i;
+        _n2o_table[_num_items + i].global = id;
+      }
+    });
+  }
+
+  _rank_local.swap(_next_rank_local);
+  _num_items += num_new;
+}
+
+void CPUHashTable4::MapNodes(IdType *output, size_t num_ouput) {
+  CHECK_LE(num_ouput, _num_items);
+  ParallelFor(0, num_ouput, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      output[i] = _n2o_table[i].global;
+    }
+  });
+}
+
+void CPUHashTable4::MapEdges(const IdType *src, const IdType *dst,
+                             const size_t len, IdType *new_src,
+                             IdType *new_dst) {
+  ParallelFor(0, len, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      new_src[i] = Local(src[i]);
+      new_dst[i] = Local(dst[i]);
+    }
+  });
+}
+
+// Only the touched words have to be cleared
+void CPUHashTable4::Reset() {
+  const size_t num_record = _records.size();
+  ParallelFor(0, num_record, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t r = begin; r < end; r++) {
+      _bitmap[_records[r].word] = 0;
+    }
+  });
+  _records.clear();
+  _rank_local.clear();
+  _num_items = 0;
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
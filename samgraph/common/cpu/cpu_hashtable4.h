@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_CPU_HASHTABLE4_H
+#define SAMGRAPH_CPU_HASHTABLE4_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../common.h"
+#include "cpu_hashtable.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// A visited bitmap with one bit per graph node. Every touched 64-bit word
+// gets a record, and the new ids of the nodes in a word are stored in a
+// dense array at the rank of their bits, so a lookup is a popcount. Only
+// the bitmap and the word directory grow with the graph (1.5 bits per
+// node), the rest is sized by the batch.
+//
+// The first Populate after Reset keeps the order of its input, which must
+// be unique like the seeds of a batch. Later calls number the new nodes by
+// ascending id.
+class CPUHashTable4 : public CPUHashTable {
+ public:
+  CPUHashTable4(size_t num_node, size_t max_items);
+  ~CPUHashTable4();
+
+  void Populate(const IdType *input, const size_t num_input) override;
+  void MapNodes(IdType *ouput, size_t num_output) override;
+  void MapEdges(const IdType *src, const IdType *dst, const size_t len,
+                IdType *new_src, IdType *new_dst) override;
+  void Reset() override;
+  size_t NumItems() const override { return _num_items; }
+
+ private:
+  struct WordRecord {
+    // bits of the word at the end of the last Populate
+    uint64_t seen;
+    // offset of the word in _rank_local
+    IdType base;
+    IdType word;
+  };
+
+  struct BucketN2O {
+    IdType global;
+  };
+
+  // The nodes a chunk of the input sets and the words it touches first
+  struct NewWords {
+    size_t num_new;
+    std::vector<IdType> words;
+  };
+
+  // The bits of a range of records, and the new ones among them
+  struct RankCount {
+    size_t num_rank;
+    size_t num_fresh;
+
+    RankCount operator+(const RankCount &other) const {
+      return {num_rank + other.num_rank, num_fresh + other.num_fresh};
+    }
+  };
+
+  uint64_t *_bitmap;
+  // record of every touched word, stale for the others
+  IdType *_word_record;
+  BucketN2O *_n2o_table;
+
+  // sorted by word
+  std::vector<WordRecord> _records;
+  std::vector<IdType> _rank_local;
+  std::vector<IdType> _next_rank_local;
+
+  IdType _num_items;
+  size_t _max_items;
+  size_t _num_words;
+
+  void MergeWords(std::vector<IdType> &fresh);
+
+  inline IdType Local(const IdType id) const {
+    const WordRecord &record = _records[_word_record[id >> 6]];
+    const uint64_t below = record.seen & ((1ull << (id & 63)) - 1);
+    return _rank_local[record.base + __builtin_popcountll(below)];
+  }
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_HASHTABLE4_H
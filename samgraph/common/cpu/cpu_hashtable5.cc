@@ -0,0 +1,224 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "cpu_hashtable5.h"
+
+#include <algorithm>
+
+#include "../common.h"
+#include "../constant.h"
+#include "../logging.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "cpu_radix_sort.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+CPUHashTable5::CPUHashTable5(size_t max_items) {
+  _sorted.reserve(max_items);
+  _next_sorted.reserve(max_items);
+  _n2o_table.reserve(max_items);
+  _last_input = nullptr;
+  _last_len = 0;
+  _num_items = 0;
+}
+
+CPUHashTable5::~CPUHashTable5() {}
+
+void CPUHashTable5::SortInput(const IdType *input, const size_t num_input) {
+  _pairs.resize(num_input);
+  IdType max_key = ParallelReduce(
+      0, num_input, kHashTableGrain, IdType(0),
+      [&](size_t begin, size_t end) {
+        IdType chunk_max = 0;
+        for (size_t i = begin; i < end; i++) {
+          _pairs[i] = {input[i], static_cast<IdType>(i)};
+          chunk_max = std::max(chunk_max, input[i]);
+        }
+        return chunk_max;
+      },
+      [](IdType a, IdType b) { return std::max(a, b); });
+  RadixSort(_pairs, _tmp_pairs, max_key,
+            [](const Pair &pair) { return pair.key; });
+  _last_input = nullptr;
+}
+
+IdType CPUHashTable5::Find(const IdType id) const {
+  auto it = std::lower_bound(
+      _sorted.begin(), _sorted.end(), id,
+      [](const Pair &pair, const IdType key) { return pair.key < key; });
+  if (it != _sorted.end() && it->key == id) {
+    return it->val;
+  }
+  return Constant::kEmptyKey;
+}
+
+void CPUHashTable5::Populate(const IdType *input, const size_t num_input) {
+  const bool keep_order = (_num_items == 0);
+
+  // 1. Sort the (id, position) pairs, the head of every run is the first
+  //    occurrence of a node
+  SortInput(input, num_input);
+  _pair_local.resize(num_input);
+  _head_local.resize(num_input);
+
+  // 2. Look up the heads and collect the new nodes in ascending id order
+  auto is_head = [&](size_t k) {
+    return k == 0 || _pairs[k].key != _pairs[k - 1].key;
+  };
+  _new_nodes.resize(num_input);
+  const size_t num_new = ParallelScan(
+      0, num_input, kHashTableGrain, size_t(0),
+      [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t k = begin; k < end; k++) {
+          if (is_head(k)) {
+            _head_local[k] = Find(_pairs[k].key);
+            count += (_head_local[k] == Constant::kEmptyKey);
+          }
+        }
+        return count;
+      },
+      [&](size_t begin, size_t end, size_t off) {
+        for (size_t k = begin; k < end; k++) {
+          if (is_head(k) && _head_local[k] == Constant::kEmptyKey) {
+            _new_nodes[off++] = {_pairs[k].key, static_cast<IdType>(k)};
+          }
+        }
+      });
+  _new_nodes.resize(num_new);
+
+  // 3. Number the new nodes
+  const IdType start_off = _num_items;
+  _n2o_table.resize(_num_items + num_new);
+  if (keep_order) {
+    // sort the heads by their position in the input
+    std::vector<Pair> order(num_new);
+    std::vector<Pair> tmp;
+    ParallelFor(0, num_new, kHashTableGrain, [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; r++) {
+        order[r] = {_pairs[_new_nodes[r].val].val, static_cast<IdType>(r)};
+      }
+    });
+    RadixSort(order, tmp, num_input,
+              [](const Pair &pair) { return pair.key; });
+    ParallelFor(0, num_new, kHashTableGrain, [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; r++) {
+        Pair &node = _new_nodes[order[r].val];
+        _head_local[node.val] = start_off + r;
+        _n2o_table[start_off + r] = node.key;
+      }
+    });
+  } else {
+    ParallelFor(0, num_new, kHashTableGrain, [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; r++) {
+        _head_local[_new_nodes[r].val] = start_off + r;
+        _n2o_table[start_off + r] = _new_nodes[r].key;
+      }
+    });
+  }
+  ParallelFor(0, num_new, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t r = begin; r < end; r++) {
+      _new_nodes[r].val = _head_local[_new_nodes[r].val];
+    }
+  });
+
+  // 4. Every pair takes the new id of its head
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    size_t head = begin;
+    while (head > 0 && _pairs[head].key == _pairs[head - 1].key) {
+      head--;
+    }
+    IdType local = _head_local[head];
+    for (size_t k = begin; k < end; k++) {
+      if (_pairs[k].key != _pairs[head].key) {
+        head = k;
+        local = _head_local[k];
+      }
+      _pair_local[k] = local;
+    }
+  });
+
+  // 5. Merge the new nodes into the sorted nodes
+  _next_sorted.resize(_sorted.size() + num_new);
+  std::merge(_sorted.begin(), _sorted.end(), _new_nodes.begin(),
+             _new_nodes.end(), _next_sorted.begin(),
+             [](const Pair &a, const Pair &b) { return a.key < b.key; });
+  _sorted.swap(_next_sorted);
+
+  _num_items += num_new;
+  _last_input = input;
+  _last_len = num_input;
+}
+
+void CPUHashTable5::MapSorted(const IdType *input, const size_t num_input,
+                              IdType *output) {
+  SortInput(input, num_input);
+
+  // both sides are sorted, so every chunk walks its nodes once
+  ParallelFor(0, num_input, kHashTableGrain, [&](size_t begin, size_t end) {
+    auto it = std::lower_bound(
+        _sorted.begin(), _sorted.end(), _pairs[begin].key,
+        [](const Pair &pair, const IdType key) { return pair.key < key; });
+    for (size_t k = begin; k < end; k++) {
+      while (it != _sorted.end() && it->key < _pairs[k].key) {
+        ++it;
+      }
+      CHECK(it != _sorted.end() && it->key == _pairs[k].key)
+          << "Node " << _pairs[k].key << " is not in CPUHashTable5";
+      output[_pairs[k].val] = it->val;
+    }
+  });
+}
+
+void CPUHashTable5::MapNodes(IdType *output, size_t num_ouput) {
+  CHECK_LE(num_ouput, _num_items);
+  ParallelFor(0, num_ouput, kHashTableGrain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      output[i] = _n2o_table[i];
+    }
+  });
+}
+
+void CPUHashTable5::MapEdges(const IdType *src, const IdType *dst,
+                             const size_t len, IdType *new_src,
+                             IdType *new_dst) {
+  if (dst == _last_input && len == _last_len) {
+    ParallelFor(0, len, kHashTableGrain, [&](size_t begin, size_t end) {
+      for (size_t k = begin; k < end; k++) {
+        new_dst[_pairs[k].val] = _pair_local[k];
+      }
+    });
+  } else {
+    MapSorted(dst, len, new_dst);
+  }
+  MapSorted(src, len, new_src);
+}
+
+void CPUHashTable5::Reset() {
+  _sorted.clear();
+  _n2o_table.clear();
+  _last_input = nullptr;
+  _last_len = 0;
+  _num_items = 0;
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
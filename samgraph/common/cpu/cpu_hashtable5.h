@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_CPU_HASHTABLE5_H
+#define SAMGRAPH_CPU_HASHTABLE5_H
+
+#include <vector>
+
+#include "../common.h"
+#include "cpu_hashtable.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// A sort-based remapper. The input is radix sorted as (id, position) pairs,
+// the heads of the runs are the unique nodes, and the nodes of the table
+// are kept sorted by id for the lookups. The first Populate after Reset
+// numbers its nodes by first occurrence, the later ones by ascending id, so
+// the new ids only depend on the input and the gathers by new id run
+// forward in memory.
+class CPUHashTable5 : public CPUHashTable {
+ public:
+  CPUHashTable5(size_t max_items);
+  ~CPUHashTable5();
+
+  void Populate(const IdType *input, const size_t num_input) override;
+  void MapNodes(IdType *ouput, size_t num_output) override;
+  void MapEdges(const IdType *src, const IdType *dst, const size_t len,
+                IdType *new_src, IdType *new_dst) override;
+  void Reset() override;
+  size_t NumItems() const override { return _num_items; }
+
+ private:
+  struct Pair {
+    IdType key;
+    IdType val;
+  };
+
+  // (id, new id) of every node, sorted by id
+  std::vector<Pair> _sorted;
+  std::vector<Pair> _next_sorted;
+  std::vector<IdType> _n2o_table;
+
+  // (id, position) of the last sorted input and the new id of every pair,
+  // MapEdges scatters them instead of sorting the last input again
+  std::vector<Pair> _pairs;
+  std::vector<Pair> _tmp_pairs;
+  std::vector<IdType> _pair_local;
+  // new id of the head of every run, only set at the heads; kept apart from
+  // _pair_local so that no chunk reads a slot another chunk writes
+  std::vector<IdType> _head_local;
+  std::vector<Pair> _new_nodes;
+  const IdType *_last_input;
+  size_t _last_len;
+
+  size_t _num_items;
+
+  void SortInput(const IdType *input, const size_t num_input);
+  void MapSorted(const IdType *input, const size_t num_input,
+                 IdType *output);
+  IdType Find(const IdType id) const;
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_HASHTABLE5_H
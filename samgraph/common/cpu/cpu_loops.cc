@@ -29,10 +29,14 @@
 #include "../logging.h"
 #include "../profiler.h"
 #include "../run_config.h"
+#include "../task_arena.h"
 #include "../timer.h"
 #include "cpu_engine.h"
+#include "cpu_feature_store.h"
 #include "cpu_function.h"
 #include "cpu_hashtable.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
 
 namespace samgraph {
 namespace common {
@@ -46,21 +50,25 @@ TaskPtr DoShuffle() {
     auto task = std::make_shared<Task>();
     task->key = CPUEngine::Get()->GetBatchKey(s->Epoch(), s->Step());
     task->output_nodes = batch;
+    task->arena = std::make_shared<TaskArena>();
     return task;
   } else {
     return nullptr;
   }
 }
 
-void DoCPUSample(TaskPtr task) {
+void DoCPUSample(TaskPtr task, size_t worker_id) {
   auto fanouts = CPUEngine::Get()->GetFanout();
   auto num_layers = fanouts.size();
   auto last_layer_idx = num_layers - 1;
 
   auto dataset = CPUEngine::Get()->GetGraphDataset();
   auto cpu_device = Device::Get(CPU());
+  auto arena = task->arena;
 
-  auto hash_table = CPUEngine::Get()->GetHashTable();
+  auto hash_table = CPUEngine::Get()->GetHashTable(worker_id);
+  auto frequency_hashmap = CPUEngine::Get()->GetFrequencyHashmap(worker_id);
+  auto remap_table = CPUEngine::Get()->GetFusedRemapTable(worker_id);
   hash_table->Reset();
 
   size_t num_train_node = task->output_nodes->Shape()[0];
@@ -73,6 +81,27 @@ void DoCPUSample(TaskPtr task) {
   const IdType *indices = static_cast<const IdType *>(dataset->indices->Data());
   IdType *mutable_indices =
       static_cast<IdType *>(dataset->indices->MutableData());
+  const float *prob_table =
+      static_cast<const float *>(dataset->prob_table->Data());
+  const IdType *alias_table =
+      static_cast<const IdType *>(dataset->alias_table->Data());
+  const float *alias_weight_table =
+      static_cast<const float *>(dataset->alias_weight_table->Data());
+  const float *prob_prefix_table =
+      static_cast<const float *>(dataset->prob_prefix_table->Data());
+  // random walk always returns the visit counts, the weighted samplers
+  // return the edge weights on demand
+  bool has_data = false;
+  DataType data_type = kF32;
+  if (RunConfig::sample_type == kRandomWalk) {
+    has_data = true;
+    data_type = kI32;
+  } else if (RunConfig::sample_edge_weight &&
+             (RunConfig::sample_type == kWeightedKHop ||
+              RunConfig::sample_type == kWeightedKHopPrefix)) {
+    has_data = true;
+    data_type = kF32;
+  }
 
   auto cur_input = task->output_nodes;
   size_t last_layer_num_unique = 0;
@@ -82,12 +111,28 @@ void DoCPUSample(TaskPtr task) {
     const size_t fanout = fanouts[i];
     const IdType *input = static_cast<const IdType *>(cur_input->Data());
     const size_t num_input = cur_input->Shape()[0];
+    const uint64_t random_stream = SampleStream(task->key, i);
     LOG(DEBUG) << "CPUSample: begin sample layer " << i;
 
-    IdType *out_src = static_cast<IdType *>(
-        cpu_device->AllocWorkspace(CPU(), num_input * fanout * sizeof(IdType)));
-    IdType *out_dst = static_cast<IdType *>(
-        cpu_device->AllocWorkspace(CPU(), num_input * fanout * sizeof(IdType)));
+    // The fused samplers write the remapped edges of the train graph, the
+    // others the raw edges that are only kept until MapEdges
+    const size_t out_nbytes = num_input * fanout * sizeof(IdType);
+    IdType *out_src;
+    IdType *out_dst;
+    if (remap_table != nullptr) {
+      out_src = static_cast<IdType *>(arena->Alloc(CPU(), out_nbytes));
+      out_dst = static_cast<IdType *>(arena->Alloc(CPU(), out_nbytes));
+    } else {
+      out_src = static_cast<IdType *>(
+          cpu_device->AllocWorkspace(CPU(), out_nbytes));
+      out_dst = static_cast<IdType *>(
+          cpu_device->AllocWorkspace(CPU(), out_nbytes));
+    }
+    void *out_data = nullptr;
+    if (has_data) {
+      out_data = arena->Alloc(
+          CPU(), num_input * fanout * GetDataTypeBytes(data_type));
+    }
     size_t num_out;
     LOG(DEBUG) << "CPUSample: cpu out_src malloc "
                << ToReadableSize(num_input * fanout * sizeof(IdType));
@@ -98,11 +143,40 @@ void DoCPUSample(TaskPtr task) {
     switch (RunConfig::sample_type) {
       case kKHop0:
         CPUSampleKHop0(indptr, indices, input, num_input, out_src, out_dst,
-                       &num_out, fanout);
+                       &num_out, fanout, random_stream);
+        break;
+      case kKHop1:
+        CPUSampleKHop1(indptr, indices, input, num_input, out_src, out_dst,
+                       &num_out, fanout, random_stream, remap_table);
         break;
       case kKHop2:
         CPUSampleKHop2(indptr, mutable_indices, input, num_input, out_src,
-                       out_dst, &num_out, fanout);
+                       out_dst, &num_out, fanout, random_stream);
+        break;
+      case kKHop3:
+        CPUSampleKHop3(indptr, indices, input, num_input, out_src, out_dst,
+                       &num_out, fanout, random_stream, remap_table);
+        break;
+      case kWeightedKHop:
+        CPUSampleWeightedKHop(indptr, indices, prob_table, alias_table,
+                              alias_weight_table, input, num_input, out_src,
+                              out_dst, static_cast<float *>(out_data),
+                              &num_out, fanout, random_stream, remap_table);
+        break;
+      case kWeightedKHopPrefix:
+        CPUSampleWeightedKHopPrefix(indptr, indices, prob_prefix_table, input,
+                                    num_input, out_src, out_dst,
+                                    static_cast<float *>(out_data), &num_out,
+                                    fanout, random_stream, remap_table);
+        break;
+      case kRandomWalk:
+        CHECK_EQ(fanout, RunConfig::num_neighbor);
+        CPUSampleRandomWalk(
+            indptr, indices, input, num_input, RunConfig::random_walk_length,
+            RunConfig::random_walk_restart_prob, RunConfig::num_random_walk,
+            RunConfig::num_neighbor, out_src, out_dst,
+            static_cast<IdType *>(out_data), &num_out, frequency_hashmap,
+            random_stream, task->key);
         break;
       default:
         CHECK(0);
@@ -110,12 +184,17 @@ void DoCPUSample(TaskPtr task) {
 
     LOG(DEBUG) << "CPUSample: num_out " << num_out;
     double core_sample_time = t0.Passed();
+    double max_thread_time, avg_thread_time;
+    CPUSamplePartition::GetLastThreadTime(&max_thread_time, &avg_thread_time);
 
     Timer t1;
     Timer t2;
 
-    // Populate the hash table with newly sampled nodes
-    hash_table->Populate(out_dst, num_out);
+    // Populate the hash table with newly sampled nodes, the fused samplers
+    // did it while sampling
+    if (remap_table == nullptr) {
+      hash_table->Populate(out_dst, num_out);
+    }
 
     double populate_time = t2.Passed();
 
@@ -123,7 +202,7 @@ void DoCPUSample(TaskPtr task) {
     size_t num_unique = hash_table->NumItems();
     LOG(DEBUG) << "CPUSample: num_unique " << num_unique;
     IdType *unique = static_cast<IdType *>(
-        cpu_device->AllocWorkspace(CPU(), num_unique * sizeof(IdType)));
+        arena->Alloc(CPU(), num_unique * sizeof(IdType)));
     hash_table->MapNodes(unique, num_unique);
 
     double map_nodes_time = t3.Passed();
@@ -133,15 +212,19 @@ void DoCPUSample(TaskPtr task) {
       last_layer_num_unique = num_unique;
     }
     // Mapping edges
-    IdType *new_src = static_cast<IdType *>(
-        cpu_device->AllocWorkspace(CPU(), num_out * sizeof(IdType)));
-    IdType *new_dst = static_cast<IdType *>(
-        cpu_device->AllocWorkspace(CPU(), num_out * sizeof(IdType)));
-    LOG(DEBUG) << "CPUSample: cpu new_src malloc "
-               << ToReadableSize(num_out * sizeof(IdType));
-    LOG(DEBUG) << "CPUSample: cpu new_src malloc "
-               << ToReadableSize(num_out * sizeof(IdType));
-    hash_table->MapEdges(out_src, out_dst, num_out, new_src, new_dst);
+    IdType *new_src = out_src;
+    IdType *new_dst = out_dst;
+    if (remap_table == nullptr) {
+      new_src = static_cast<IdType *>(
+          arena->Alloc(CPU(), num_out * sizeof(IdType)));
+      new_dst = static_cast<IdType *>(
+          arena->Alloc(CPU(), num_out * sizeof(IdType)));
+      LOG(DEBUG) << "CPUSample: cpu new_src malloc "
+                 << ToReadableSize(num_out * sizeof(IdType));
+      LOG(DEBUG) << "CPUSample: cpu new_src malloc "
+                 << ToReadableSize(num_out * sizeof(IdType));
+      hash_table->MapEdges(out_src, out_dst, num_out, new_src, new_dst);
+    }
 
     double map_edges_time = t4.Passed();
 
@@ -150,12 +233,15 @@ void DoCPUSample(TaskPtr task) {
     auto train_graph = std::make_shared<TrainGraph>();
     train_graph->row = Tensor::FromBlob(
         new_dst, DataType::kI32, {num_out}, CPU(),
-        "train_graph.row_cpu_sample_" + std::to_string(task->key) + "_" +
-            std::to_string(i));
+        TensorName("train_graph.row_cpu_sample_", task->key, i), arena);
     train_graph->col = Tensor::FromBlob(
         new_src, DataType::kI32, {num_out}, CPU(),
-        "train_graph.col_cpu_sample_" + std::to_string(task->key) + "_" +
-            std::to_string(i));
+        TensorName("train_graph.col_cpu_sample_", task->key, i), arena);
+    if (out_data != nullptr) {
+      train_graph->data = Tensor::FromBlob(
+          out_data, data_type, {num_out}, CPU(),
+          TensorName("train_graph.data_cpu_sample_", task->key, i), arena);
+    }
     train_graph->num_src = num_unique;
     train_graph->num_dst = num_input;
     train_graph->num_edge = num_out;
@@ -163,14 +249,20 @@ void DoCPUSample(TaskPtr task) {
     task->graphs[i] = train_graph;
     cur_input =
         Tensor::FromBlob((void *)unique, DataType::kI32, {num_unique}, CPU(),
-                         "cur_input_unique_cpu_" + std::to_string(task->key) +
-                             "_" + std::to_string(i));
+                         TensorName("cur_input_unique_cpu_", task->key, i),
+                         arena);
     total_num_samples += num_out;
-    cpu_device->FreeWorkspace(CPU(), out_src);
-    cpu_device->FreeWorkspace(CPU(), out_dst);
+    if (remap_table == nullptr) {
+      cpu_device->FreeWorkspace(CPU(), out_src);
+      cpu_device->FreeWorkspace(CPU(), out_dst);
+    }
 
     Profiler::Get().LogStepAdd(task->key, kLogL2CoreSampleTime,
                                core_sample_time);
+    Profiler::Get().LogStepAdd(task->key, kLogL3SampleMaxThreadTime,
+                               max_thread_time);
+    Profiler::Get().LogStepAdd(task->key, kLogL3SampleAvgThreadTime,
+                               avg_thread_time);
     Profiler::Get().LogStepAdd(task->key, kLogL2IdRemapTime, remap_time);
     Profiler::Get().LogStepAdd(task->key, kLogL3RemapPopulateTime,
                                populate_time);
@@ -197,7 +289,9 @@ void DoFeatureExtract(TaskPtr task) {
   auto output_nodes = task->output_nodes;
 
   auto feat_dim = dataset->feat->Shape()[1];
-  auto feat_type = dataset->feat->Type();
+  // int8 features are dequantized to kF32 while gathering
+  auto feat_type =
+      dataset->feat_scale->Defined() ? kF32 : dataset->feat->Type();
   auto label_type = dataset->label->Type();
 
   auto input_data = reinterpret_cast<const IdType *>(input_nodes->Data());
@@ -206,15 +300,22 @@ void DoFeatureExtract(TaskPtr task) {
   auto num_ouput = output_nodes->Shape()[0];
 
   auto feat = Tensor::Empty(feat_type, {num_input, feat_dim}, CPU(),
-                            "task.input_feat_cpu_" + std::to_string(task->key));
-  auto label =
-      Tensor::Empty(label_type, {num_ouput}, CPU(),
-                    "task.output_label_cpu" + std::to_string(task->key));
+                            TensorName("task.input_feat_cpu_", task->key),
+                            task->arena);
+  auto label = Tensor::Empty(label_type, {num_ouput}, CPU(),
+                             TensorName("task.output_label_cpu", task->key),
+                             task->arena);
 
   auto feat_dst = feat->MutableData();
   auto feat_src = dataset->feat->Data();
   if (RunConfig::option_empty_feat != 0) {
     CPUMockExtract(feat_dst, feat_src, input_data, num_input, feat_dim, feat_type);
+  } else if (dataset->feat_store) {
+    dataset->feat_store->Extract(feat_dst, input_data, num_input, task->key);
+  } else if (dataset->feat_scale->Defined()) {
+    CPUExtractDequant(feat_dst, feat_src,
+                      static_cast<const float *>(dataset->feat_scale->Data()),
+                      input_data, num_input, feat_dim);
   } else {
     CPUExtract(feat_dst, feat_src, input_data, num_input, feat_dim, feat_type);
   }
@@ -235,12 +336,12 @@ void DoGraphCopy(TaskPtr task) {
     auto graph = task->graphs[i];
     auto train_row =
         Tensor::Empty(graph->row->Type(), graph->row->Shape(), trainer_ctx,
-                      "train_graph.row_cuda_train_" +
-                          std::to_string(task->key) + "_" + std::to_string(i));
+                      TensorName("train_graph.row_cuda_train_", task->key, i),
+                      task->arena);
     auto train_col =
         Tensor::Empty(graph->col->Type(), graph->col->Shape(), trainer_ctx,
-                      "train_graph.col_cuda_train_" +
-                          std::to_string(task->key) + "_" + std::to_string(i));
+                      TensorName("train_graph.col_cuda_train_", task->key, i),
+                      task->arena);
     LOG(DEBUG) << "GraphCopyDevice2DeviceLoop: cuda train_row malloc "
                << ToReadableSize(graph->row->NumBytes());
     LOG(DEBUG) << "GraphCopyDevice2DeviceLoop: cuda train_col malloc "
@@ -257,8 +358,21 @@ void DoGraphCopy(TaskPtr task) {
     graph->row = train_row;
     graph->col = train_col;
 
-    Profiler::Get().LogStepAdd(task->key, kLogL1GraphBytes,
-                               train_row->NumBytes() + train_col->NumBytes());
+    size_t graph_bytes = train_row->NumBytes() + train_col->NumBytes();
+    if (graph->data && graph->data->Defined()) {
+      auto train_data = Tensor::Empty(
+          graph->data->Type(), graph->data->Shape(), trainer_ctx,
+          TensorName("train_graph.data_cuda_train_", task->key, i),
+          task->arena);
+      trainer_device->CopyDataFromTo(
+          graph->data->Data(), 0, train_data->MutableData(), 0,
+          graph->data->NumBytes(), CPU(), trainer_ctx, work_stream);
+      trainer_device->StreamSync(trainer_ctx, work_stream);
+      graph->data = train_data;
+      graph_bytes += train_data->NumBytes();
+    }
+
+    Profiler::Get().LogStepAdd(task->key, kLogL1GraphBytes, graph_bytes);
   }
 }
 
@@ -272,10 +386,12 @@ void DoFeatureCopy(TaskPtr task) {
 
   auto train_feat =
       Tensor::Empty(feat->Type(), feat->Shape(), trainer_ctx,
-                    "task.train_feat_cuda_" + std::to_string(task->key));
+                    TensorName("task.train_feat_cuda_", task->key),
+                    task->arena);
   auto train_label =
       Tensor::Empty(label->Type(), label->Shape(), trainer_ctx,
-                    "task.train_label_cuda" + std::to_string(task->key));
+                    TensorName("task.train_label_cuda", task->key),
+                    task->arena);
 
   trainer_device->CopyDataFromTo(feat->Data(), 0, train_feat->MutableData(), 0,
                                  feat->NumBytes(), CPU(), trainer_ctx,
@@ -304,7 +420,7 @@ void DoCacheIdCopy(TaskPtr task) {
 
   auto input_nodes = Tensor::Empty(
       task->input_nodes->Type(), task->input_nodes->Shape(), trainer_ctx,
-      "task.output_nodes_cuda_" + std::to_string(task->key));
+      TensorName("task.output_nodes_cuda_", task->key), task->arena);
   LOG(DEBUG) << "DoCacheIdCopy input_nodes cuda malloc "
              << ToReadableSize(input_nodes->NumBytes());
 
@@ -338,7 +454,8 @@ void DoGPULabelExtract(TaskPtr task) {
 
   auto train_label =
       Tensor::Empty(label_type, {num_ouput}, trainer_ctx,
-                    "task.train_label_cuda" + std::to_string(task->key));
+                    TensorName("task.train_label_cuda", task->key),
+                    task->arena);
 
   void *label_dst = train_label->MutableData();
   const void *label_src = dataset->label->Data();
@@ -377,7 +494,8 @@ void DoCPULabelExtractAndCopy(TaskPtr task) {
 
   task->output_label =
       Tensor::Empty(label_type, {num_ouput}, CPU(),
-                    "task.output_label_cpu" + std::to_string(task->key));
+                    TensorName("task.output_label_cpu", task->key),
+                    task->arena);
 
   LOG(DEBUG) << "DoCPUFeatureExtract output_label cpu malloc "
              << ToReadableSize(task->output_label->NumBytes());
@@ -392,7 +510,8 @@ void DoCPULabelExtractAndCopy(TaskPtr task) {
   CHECK_EQ(cpu_label->Ctx().device_type, CPU().device_type);
   auto train_label =
       Tensor::Empty(cpu_label->Type(), cpu_label->Shape(), trainer_ctx,
-                    "task.train_label_cuda" + std::to_string(task->key));
+                    TensorName("task.train_label_cuda", task->key),
+                    task->arena);
   trainer_device->CopyDataFromTo(
       cpu_label->Data(), 0, train_label->MutableData(), 0,
       cpu_label->NumBytes(), cpu_label->Ctx(), train_label->Ctx(), stream);
@@ -426,7 +545,8 @@ void DoCacheFeatureExtractCopy(TaskPtr task) {
 
   auto train_feat =
       Tensor::Empty(feat_type, {num_input, feat_dim}, trainer_ctx,
-                    "task.train_feat_cuda_" + std::to_string(task->key));
+                    TensorName("task.train_feat_cuda_", task->key),
+                    task->arena);
 
   // 0. Get index of miss data and cache data
   // feature data has cache, so we only need to extract the miss data
@@ -478,7 +598,7 @@ void DoCacheFeatureExtractCopy(TaskPtr task) {
       trainer_ctx, GetTensorBytes(feat_type, {num_output_miss, feat_dim}));
 
   cache_manager->ExtractMissData(cpu_output_miss, cpu_output_miss_src_index,
-                                 num_output_miss);
+                                 num_output_miss, task->key);
 
   double extract_miss_time = t2.Passed();
 
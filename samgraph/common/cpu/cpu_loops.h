@@ -30,7 +30,8 @@ std::vector<LoopFunction> GetArch0Loops();
 
 // common steps
 TaskPtr DoShuffle();
-void DoCPUSample(TaskPtr task);
+// worker_id picks the remap tables of the calling sample worker
+void DoCPUSample(TaskPtr task, size_t worker_id = 0);
 void DoGraphCopy(TaskPtr task);
 void DoFeatureExtract(TaskPtr task);
 void DoFeatureCopy(TaskPtr task);
@@ -15,11 +15,17 @@
  *
  */
 
+#include <atomic>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 
+#include "../logging.h"
 #include "../profiler.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
 #include "../timer.h"
+#include "../workspace_pool.h"
 #include "cpu_engine.h"
 #include "cpu_loops.h"
 
@@ -37,14 +43,22 @@ namespace cpu {
  *  |                         |          |                      |
  *  |          CPU            |          |         GPU          |
  *  +-------------------------+          +----------------------+
+ *
+ *  Pipeline of the CPU side, every arrow is a bounded task queue
+ *
+ *              +-> Sample worker 0 -+    +-> Extract worker 0 -+
+ *  Shuffler ---+-> Sample worker 1 -+----+-> Extract worker 1 -+---> Copier
+ *              +-> ...             -+    +-> ...              -+
+ *
+ *  With the GPU cache the copier extracts the missed rows itself, so the
+ *  samplers feed it directly.
  * clang-format on
  */
 
 namespace {
 bool RunSampleCopySubLoopOnce() {
   auto graph_pool = CPUEngine::Get()->GetGraphPool();
-  if (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  if (!graph_pool->WaitNotFull()) {
     return true;
   }
 
@@ -94,8 +108,7 @@ bool RunSampleCopySubLoopOnce() {
 
 bool RunCacheSampleCopySubLoopOnce() {
   auto graph_pool = CPUEngine::Get()->GetGraphPool();
-  if (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  if (!graph_pool->WaitNotFull()) {
     return true;
   }
 
@@ -144,14 +157,213 @@ bool RunCacheSampleCopySubLoopOnce() {
   return true;
 }
 
-void SampleCopySubLoop() {
-  if (RunConfig::UseGPUCache()) {
-    while (RunSampleCopySubLoopOnce() && !CPUEngine::Get()->ShouldShutdown()) {
-    }
+// Time a task entered the pipeline, the copier subtracts the busy time of
+// the stages to get the time it waited in the queues
+std::mutex start_mutex;
+std::unordered_map<uint64_t, Timer> start_time;
+std::atomic<size_t> next_sample_worker(0);
+
+void LogStart(uint64_t key, Timer t) {
+  std::lock_guard<std::mutex> lock(start_mutex);
+  start_time.emplace(key, t);
+}
+
+double PassedSinceStart(uint64_t key) {
+  std::lock_guard<std::mutex> lock(start_mutex);
+  auto it = start_time.find(key);
+  CHECK(it != start_time.end());
+  double passed = it->second.Passed();
+  start_time.erase(it);
+  return passed;
+}
+
+bool RunShuffleSubLoopOnce() {
+  auto next_q = CPUEngine::Get()->GetTaskQueue(kCPUSample);
+
+  Timer t0;
+  auto task = DoShuffle();
+  if (task) {
+    double shuffle_time = t0.Passed();
+    LogStart(task->key, t0);
+
+    // log before handing the task over, the next stage logs the same key
+    Profiler::Get().LogStepAdd(task->key, kLogL1SampleTime, shuffle_time);
+    Profiler::Get().LogStep(task->key, kLogL2ShuffleTime, shuffle_time);
+    Profiler::Get().LogEpochAdd(task->key, kLogEpochSampleTime, shuffle_time);
+
+    next_q->AddTask(task);
   } else {
-    while (RunCacheSampleCopySubLoopOnce() &&
-           !CPUEngine::Get()->ShouldShutdown()) {
-    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  }
+
+  return true;
+}
+
+bool RunSampleSubLoopOnce(size_t worker_id) {
+  auto next_op = RunConfig::UseGPUCache() ? kCPUCopy : kCPUExtract;
+  auto next_q = CPUEngine::Get()->GetTaskQueue(next_op);
+
+  auto q = CPUEngine::Get()->GetTaskQueue(kCPUSample);
+  // nullptr once the engine shuts down
+  auto task = q->WaitTask();
+  if (task) {
+    Timer t1;
+    DoCPUSample(task, worker_id);
+    double sample_time = t1.Passed();
+
+    Profiler::Get().LogStepAdd(task->key, kLogL1SampleTime, sample_time);
+    Profiler::Get().LogEpochAdd(task->key, kLogEpochSampleTime, sample_time);
+    LOG(DEBUG) << "CPUSampleLoop: worker " << worker_id
+               << " process task with key " << task->key;
+
+    next_q->AddTask(task);
+  }
+
+  return true;
+}
+
+bool RunExtractSubLoopOnce() {
+  auto next_q = CPUEngine::Get()->GetTaskQueue(kCPUCopy);
+
+  auto q = CPUEngine::Get()->GetTaskQueue(kCPUExtract);
+  // nullptr once the engine shuts down
+  auto task = q->WaitTask();
+  if (task) {
+    Timer t2;
+    DoFeatureExtract(task);
+    double extract_time = t2.Passed();
+
+    Profiler::Get().LogStepAdd(task->key, kLogL1CopyTime, extract_time);
+    Profiler::Get().LogStep(task->key, kLogL2ExtractTime, extract_time);
+    Profiler::Get().LogEpochAdd(task->key, kLogEpochCopyTime, extract_time);
+
+    next_q->AddTask(task);
+  }
+
+  return true;
+}
+
+void LogWaitTime(uint64_t key) {
+  double busy_time = Profiler::Get().GetLogStepValue(key, kLogL1SampleTime) +
+                     Profiler::Get().GetLogStepValue(key, kLogL1CopyTime);
+  Profiler::Get().LogStep(key, kLogL2PipelineWaitTime,
+                          Max(PassedSinceStart(key) - busy_time, 0.0));
+}
+
+bool RunCopySubLoopOnce() {
+  auto graph_pool = CPUEngine::Get()->GetGraphPool();
+  if (!graph_pool->WaitNotFull()) {
+    return true;
+  }
+
+  auto q = CPUEngine::Get()->GetTaskQueue(kCPUCopy);
+  // nullptr once the engine shuts down
+  auto task = q->WaitTask();
+  if (task) {
+    Timer t3;
+    DoGraphCopy(task);
+    double graph_copy_time = t3.Passed();
+
+    Timer t4;
+    DoFeatureCopy(task);
+    double feat_copy_time = t4.Passed();
+
+    Profiler::Get().LogStepAdd(task->key, kLogL1CopyTime,
+                               graph_copy_time + feat_copy_time);
+    Profiler::Get().LogStep(task->key, kLogL2GraphCopyTime, graph_copy_time);
+    Profiler::Get().LogStep(task->key, kLogL2FeatCopyTime, feat_copy_time);
+    Profiler::Get().LogEpochAdd(task->key, kLogEpochCopyTime,
+                                graph_copy_time + feat_copy_time);
+    LogWaitTime(task->key);
+
+    graph_pool->Submit(task->key, task);
+  }
+
+  return true;
+}
+
+bool RunCacheCopySubLoopOnce() {
+  auto graph_pool = CPUEngine::Get()->GetGraphPool();
+  if (!graph_pool->WaitNotFull()) {
+    return true;
+  }
+
+  auto q = CPUEngine::Get()->GetTaskQueue(kCPUCopy);
+  // nullptr once the engine shuts down
+  auto task = q->WaitTask();
+  if (task) {
+    Timer t2;
+    DoGraphCopy(task);
+    double graph_copy_time = t2.Passed();
+
+    Timer t3;
+    DoCacheIdCopy(task);
+    double id_copy_time = t3.Passed();
+
+    Timer t4;
+    DoCPULabelExtractAndCopy(task);
+    DoCacheFeatureExtractCopy(task);
+    double feat_copy_time = t4.Passed();
+
+    Profiler::Get().LogStepAdd(task->key, kLogL1CopyTime,
+                               graph_copy_time + id_copy_time + feat_copy_time);
+    Profiler::Get().LogStep(task->key, kLogL2GraphCopyTime, graph_copy_time);
+    Profiler::Get().LogStep(task->key, kLogL2IdCopyTime, id_copy_time);
+    Profiler::Get().LogStep(task->key, kLogL2CacheCopyTime, feat_copy_time);
+    Profiler::Get().LogEpochAdd(
+        task->key, kLogEpochCopyTime,
+        graph_copy_time + id_copy_time + feat_copy_time);
+    LogWaitTime(task->key);
+
+    graph_pool->Submit(task->key, task);
+  }
+
+  return true;
+}
+
+void ShuffleSubLoop() {
+  WorkspaceSite site("shuffle");
+  while (RunShuffleSubLoopOnce() && !CPUEngine::Get()->ShouldShutdown()) {
+  }
+  CPUEngine::Get()->ReportThreadFinish();
+}
+
+void SampleSubLoop() {
+  size_t worker_id = next_sample_worker++;
+  const auto &placement = CPUEngine::Get()->GetPlacement();
+  PinThread(placement.sample_cpus);
+  // the workers of a stage split its threads
+  ThreadBudget budget(Max<size_t>(
+      placement.sample_thread_num / RunConfig::cpu_num_sample_worker, 1));
+  WorkspaceSite site("sample");
+  while (RunSampleSubLoopOnce(worker_id) &&
+         !CPUEngine::Get()->ShouldShutdown()) {
+  }
+  CPUEngine::Get()->ReportThreadFinish();
+}
+
+void ExtractSubLoop() {
+  const auto &placement = CPUEngine::Get()->GetPlacement();
+  PinThread(placement.extract_cpus);
+  ThreadBudget budget(Max<size_t>(
+      placement.extract_thread_num / RunConfig::cpu_num_extract_worker, 1));
+  WorkspaceSite site("extract");
+  while (RunExtractSubLoopOnce() && !CPUEngine::Get()->ShouldShutdown()) {
+  }
+  CPUEngine::Get()->ReportThreadFinish();
+}
+
+void CopySubLoop() {
+  LoopOnceFunction func;
+  if (!RunConfig::UseGPUCache()) {
+    func = RunCopySubLoopOnce;
+  } else {
+    func = RunCacheCopySubLoopOnce;
+  }
+
+  PinThread(CPUEngine::Get()->GetPlacement().copy_cpus);
+  WorkspaceSite site("copy");
+  while (func() && !CPUEngine::Get()->ShouldShutdown()) {
   }
   CPUEngine::Get()->ReportThreadFinish();
 }
@@ -169,11 +381,23 @@ void RunArch0LoopsOnce() {
 std::vector<LoopFunction> GetArch0Loops() {
   std::vector<LoopFunction> func;
 
-  func.push_back(SampleCopySubLoop);
+  next_sample_worker = 0;
+  start_time.clear();
+
+  func.push_back(ShuffleSubLoop);
+  for (size_t i = 0; i < RunConfig::cpu_num_sample_worker; i++) {
+    func.push_back(SampleSubLoop);
+  }
+  if (!RunConfig::UseGPUCache()) {
+    for (size_t i = 0; i < RunConfig::cpu_num_extract_worker; i++) {
+      func.push_back(ExtractSubLoop);
+    }
+  }
+  func.push_back(CopySubLoop);
 
   return func;
 }
 
 }  // namespace cpu
 }  // namespace common
-}  // namespace samgraph
\ No newline at end of file
+}  // namespace samgraph
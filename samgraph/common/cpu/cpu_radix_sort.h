@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef SAMGRAPH_CPU_RADIX_SORT_H
+#define SAMGRAPH_CPU_RADIX_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../common.h"
+#include "../thread_pool.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+constexpr int kRadixBits = 8;
+constexpr size_t kRadix = 1 << kRadixBits;
+
+// Stable LSD radix sort by key(item), keys are at most max_key. Every slice
+// counts its own digits, and the slices are scattered in slice order, so
+// the result does not depend on the number of threads. tmp is scratch.
+template <typename T, typename KeyF>
+void RadixSort(std::vector<T> &data, std::vector<T> &tmp, IdType max_key,
+               KeyF key) {
+  const size_t n = data.size();
+  const size_t num_slices = ThreadBudget::Get();
+  std::vector<size_t> offsets(num_slices * kRadix);
+  tmp.resize(n);
+
+  for (int shift = 0; shift < 32 && (max_key >> shift) > 0;
+       shift += kRadixBits) {
+    const T *from = data.data();
+    T *to = tmp.data();
+    ThreadPool::Get()->Run(num_slices, num_slices, [&](size_t slice) {
+      const size_t begin = n * slice / num_slices;
+      const size_t end = n * (slice + 1) / num_slices;
+      size_t *count = offsets.data() + slice * kRadix;
+
+      std::fill(count, count + kRadix, 0);
+      for (size_t i = begin; i < end; i++) {
+        count[(key(from[i]) >> shift) & (kRadix - 1)]++;
+      }
+    });
+
+    size_t prefix_sum = 0;
+    for (size_t d = 0; d < kRadix; d++) {
+      for (size_t k = 0; k < num_slices; k++) {
+        size_t cnt = offsets[k * kRadix + d];
+        offsets[k * kRadix + d] = prefix_sum;
+        prefix_sum += cnt;
+      }
+    }
+
+    ThreadPool::Get()->Run(num_slices, num_slices, [&](size_t slice) {
+      const size_t begin = n * slice / num_slices;
+      const size_t end = n * (slice + 1) / num_slices;
+      size_t *count = offsets.data() + slice * kRadix;
+      for (size_t i = begin; i < end; i++) {
+        to[count[(key(from[i]) >> shift) & (kRadix - 1)]++] = from[i];
+      }
+    });
+    data.swap(tmp);
+  }
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_RADIX_SORT_H
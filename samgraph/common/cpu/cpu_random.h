@@ -0,0 +1,188 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_CPU_RANDOM_H
+#define SAMGRAPH_CPU_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Self-contained on purpose: the data-process utilities include this header
+// without the rest of samgraph.
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// Streams of the shufflers, samplers use the task key and the layer.
+constexpr uint64_t kShuffleStream = 1ull << 63;
+
+inline uint64_t SampleStream(uint64_t task_key, size_t layer) {
+  return (task_key & ((1ull << 56) - 1)) | (static_cast<uint64_t>(layer) << 56);
+}
+
+// Counter-based random generator (Philox4x32-10).
+// The i-th number of a (seed, stream, node) triple is a pure function of
+// those values, so the result does not depend on which thread draws it or
+// in which order. Each block of the counter yields 4 numbers.
+class PhiloxRandom {
+ public:
+  PhiloxRandom(uint64_t seed, uint64_t stream, uint32_t node)
+      : _key0(static_cast<uint32_t>(seed)),
+        _key1(static_cast<uint32_t>(seed >> 32)),
+        _node(node),
+        _stream0(static_cast<uint32_t>(stream)),
+        _stream1(static_cast<uint32_t>(stream >> 32)),
+        _block(0),
+        _buf_pos(4) {}
+
+  // The idx-th number of the stream, random access
+  inline uint32_t At(uint64_t idx) const {
+    uint32_t out[4];
+    Block(static_cast<uint32_t>(idx >> 2), out);
+    return out[idx & 3];
+  }
+
+  // Sequential access
+  inline uint32_t Next() {
+    if (_buf_pos == 4) {
+      Block(_block++, _buf);
+      _buf_pos = 0;
+    }
+    return _buf[_buf_pos++];
+  }
+
+  // Continue the sequential access from the idx-th number
+  inline void Seek(uint64_t idx) {
+    _block = static_cast<uint32_t>(idx >> 2);
+    _buf_pos = 4;
+    if (idx & 3) {
+      Block(_block++, _buf);
+      _buf_pos = static_cast<int>(idx & 3);
+    }
+  }
+
+  inline uint32_t NextBounded(uint32_t range) { return Bound(Next(), range); }
+  inline float NextUniform() { return ToUniform(Next()); }
+
+  // Batched sequential access, whole blocks are generated in a simd loop
+  inline void Fill(uint32_t *out, size_t num) {
+    size_t i = 0;
+    while (i < num && _buf_pos != 4) {
+      out[i++] = _buf[_buf_pos++];
+    }
+
+    const size_t num_block = (num - i) / 4;
+    const uint32_t base = _block;
+    uint32_t *dst = out + i;
+#pragma omp simd
+    for (size_t b = 0; b < num_block; b++) {
+      uint32_t c[4];
+      Block(base + static_cast<uint32_t>(b), c);
+      dst[4 * b + 0] = c[0];
+      dst[4 * b + 1] = c[1];
+      dst[4 * b + 2] = c[2];
+      dst[4 * b + 3] = c[3];
+    }
+    _block += static_cast<uint32_t>(num_block);
+    i += num_block * 4;
+
+    while (i < num) {
+      out[i++] = Next();
+    }
+  }
+
+  // Fill with numbers in [0, range)
+  inline void FillBounded(uint32_t *out, size_t num, uint32_t range) {
+    Fill(out, num);
+#pragma omp simd
+    for (size_t i = 0; i < num; i++) {
+      out[i] = Bound(out[i], range);
+    }
+  }
+
+  // Fill with numbers in [0, 1), the words go through a local batch so the
+  // floats are never accessed as integers
+  inline void FillUniform(float *out, size_t num) {
+    uint32_t words[kUniformBatch];
+    for (size_t i = 0; i < num; i += kUniformBatch) {
+      const size_t n = num - i < kUniformBatch ? num - i : kUniformBatch;
+      Fill(words, n);
+#pragma omp simd
+      for (size_t j = 0; j < n; j++) {
+        out[i + j] = ToUniform(words[j]);
+      }
+    }
+  }
+
+  // Lemire's multiply-shift: maps x to [0, range) without division
+  static inline uint32_t Bound(uint32_t x, uint32_t range) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(x) * range) >> 32);
+  }
+
+  // 24 random bits, exactly representable and always < 1
+  static inline float ToUniform(uint32_t x) {
+    return (x >> 8) * (1.0f / 16777216.0f);
+  }
+
+  inline void Block(uint32_t block, uint32_t out[4]) const {
+    uint32_t c0 = block, c1 = _node, c2 = _stream0, c3 = _stream1;
+    uint32_t k0 = _key0, k1 = _key1;
+    for (int r = 0; r < 10; r++) {
+      const uint64_t p0 = static_cast<uint64_t>(kMul0) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(kMul1) * c2;
+      const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+      const uint32_t lo0 = static_cast<uint32_t>(p0);
+      const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+      const uint32_t lo1 = static_cast<uint32_t>(p1);
+      c0 = hi1 ^ c1 ^ k0;
+      c1 = lo1;
+      c2 = hi0 ^ c3 ^ k1;
+      c3 = lo0;
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+ private:
+  // words generated at once by FillUniform
+  static constexpr size_t kUniformBatch = 256;
+  static constexpr uint32_t kMul0 = 0xD2511F53;
+  static constexpr uint32_t kMul1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+  uint32_t _key0;
+  uint32_t _key1;
+  uint32_t _node;
+  uint32_t _stream0;
+  uint32_t _stream1;
+
+  uint32_t _block;
+  uint32_t _buf[4];
+  int _buf_pos;
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_RANDOM_H
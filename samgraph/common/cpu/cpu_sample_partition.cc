@@ -0,0 +1,180 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "cpu_sample_partition.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+namespace {
+
+thread_local double last_max_thread_time = 0;
+thread_local double last_avg_thread_time = 0;
+// the part buffers of the sampling calls of this thread
+thread_local std::vector<CPUSampleBuffer> my_buffers;
+
+inline size_t SeedCost(const IdType *const indptr, const IdType rid,
+                       const size_t work_cap) {
+  const size_t len = indptr[rid + 1] - indptr[rid];
+  return 1 + std::min(len, work_cap);
+}
+
+}  // namespace
+
+void CPUSampleBuffer::Reset(size_t max_num, bool with_data) {
+  src.resize(max_num);
+  dst.resize(max_num);
+  if (with_data) {
+    data.resize(max_num);
+  }
+  num = 0;
+}
+
+void CPUSamplePartition::Init(const size_t num_parts) {
+  _bounds.assign(num_parts + 1, 0);
+  _chunk_cost.assign(num_parts + 1, PrefixItem());
+  _thread_time.assign(num_parts, TimeItem());
+  // only grown, the buffers keep their memory among batches
+  if (my_buffers.size() < num_parts) {
+    my_buffers.resize(num_parts);
+  }
+  _buffers = &my_buffers;
+}
+
+// Two passes over the static chunks, so no per-seed prefix array is needed:
+//   1. every part sums the cost of its static chunk
+//   2. after a prefix sum over the chunks, the part whose chunk holds the
+//      k-th cut target rescans the chunk to find the exact seed
+void CPUSamplePartition::Build(const IdType *const indptr,
+                               const IdType *const input,
+                               const size_t num_input,
+                               const size_t work_cap) {
+  const size_t num_parts = ThreadBudget::Get();
+  Init(num_parts);
+
+  auto chunk_begin = [&](size_t part) {
+    return num_input * part / num_parts;
+  };
+
+  ThreadPool::Get()->Run(num_parts, num_parts, [&](size_t part) {
+    size_t chunk_cost = 0;
+    for (size_t i = chunk_begin(part); i < chunk_begin(part + 1); i++) {
+      chunk_cost += SeedCost(indptr, input[i], work_cap);
+    }
+    _chunk_cost[part].val = chunk_cost;
+  });
+
+  size_t prefix_sum = 0;
+  for (size_t k = 0; k <= num_parts; k++) {
+    size_t tmp = _chunk_cost[k].val;
+    _chunk_cost[k].val = prefix_sum;
+    prefix_sum += tmp;
+  }
+  _bounds[num_parts] = num_input;
+
+  // cut k is the first seed i whose cost prefix reaches total * k / num
+  const size_t total = _chunk_cost[num_parts].val;
+  ThreadPool::Get()->Run(num_parts, num_parts, [&](size_t part) {
+    const size_t cost_begin = _chunk_cost[part].val;
+    const size_t cost_end = _chunk_cost[part + 1].val;
+    size_t cost = cost_begin;
+    size_t i = chunk_begin(part);
+    for (size_t k = 1; k < num_parts; k++) {
+      const size_t target = total * k / num_parts;
+      if (target <= cost_begin || target > cost_end) {
+        continue;
+      }
+      while (cost < target) {
+        cost += SeedCost(indptr, input[i], work_cap);
+        i++;
+      }
+      _bounds[k] = i;
+    }
+  });
+}
+
+void CPUSamplePartition::BuildUniform(const size_t num_task) {
+  const size_t num_parts = ThreadBudget::Get();
+  Init(num_parts);
+  for (size_t part = 0; part < num_parts; part++) {
+    _bounds[part + 1] = num_task * (part + 1) / num_parts;
+  }
+}
+
+size_t CPUSamplePartition::Merge(IdType *output_src, IdType *output_dst,
+                                 float *output_data,
+                                 CPUHashTable2 *remap_table) {
+  const size_t num_parts = NumPart();
+  if (remap_table) {
+    std::vector<CPUHashTable2::ClaimedChunk> chunks(num_parts);
+    for (size_t part = 0; part < num_parts; part++) {
+      CPUSampleBuffer &buffer = Buffer(part);
+      chunks[part] = {buffer.src.data(), buffer.dst.data(), buffer.num};
+    }
+    remap_table->MapClaimed(chunks);
+  }
+
+  // Exclusive prefix sum over the part counts
+  std::vector<size_t> out_offs(num_parts);
+  size_t prefix_sum = 0;
+  for (size_t part = 0; part < num_parts; part++) {
+    out_offs[part] = prefix_sum;
+    prefix_sum += Buffer(part).num;
+  }
+
+  ParallelFor(0, num_parts, 1, [&](size_t p_begin, size_t p_end) {
+    for (size_t part = p_begin; part < p_end; part++) {
+      const CPUSampleBuffer &buffer = Buffer(part);
+      const size_t out_off = out_offs[part];
+      std::memcpy(output_src + out_off, buffer.src.data(),
+                  buffer.num * sizeof(IdType));
+      std::memcpy(output_dst + out_off, buffer.dst.data(),
+                  buffer.num * sizeof(IdType));
+      if (output_data) {
+        std::memcpy(output_data + out_off, buffer.data.data(),
+                    buffer.num * sizeof(float));
+      }
+    }
+  });
+  return prefix_sum;
+}
+
+void CPUSamplePartition::Finish() const {
+  double max_time = 0;
+  double sum_time = 0;
+  for (const auto &item : _thread_time) {
+    max_time = std::max(max_time, item.val);
+    sum_time += item.val;
+  }
+
+  last_max_thread_time = max_time;
+  last_avg_thread_time =
+      _thread_time.empty() ? 0 : sum_time / _thread_time.size();
+}
+
+void CPUSamplePartition::GetLastThreadTime(double *max_time,
+                                           double *avg_time) {
+  *max_time = last_max_thread_time;
+  *avg_time = last_avg_thread_time;
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
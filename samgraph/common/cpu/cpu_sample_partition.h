@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef SAMGRAPH_CPU_SAMPLE_PARTITION_H
+#define SAMGRAPH_CPU_SAMPLE_PARTITION_H
+
+#include <limits>
+#include <vector>
+
+#include "../common.h"
+#include "../thread_pool.h"
+#include "../timer.h"
+#include "cpu_hashtable2.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// The edges a part of the seeds samples before they are merged into the
+// output
+struct CPUSampleBuffer {
+  std::vector<IdType> src;
+  std::vector<IdType> dst;
+  std::vector<float> data;
+  size_t num;
+
+  CPUSampleBuffer() : num(0) {}
+  // Room for max_num edges, data only if with_data
+  void Reset(size_t max_num, bool with_data);
+};
+
+// Splits the seeds of a sampling call into one contiguous range per thread
+// of the budget of the caller, the parts run on the thread pool. With
+// power-law graphs a static split leaves the part that gets the hubs far
+// behind, so the ranges are cut at equal cost instead, where a seed costs
+// 1 + min(degree, work_cap) and work_cap is the most work the sampler does
+// for one seed. The ranges keep the seed order, so the samplers that buffer
+// their edges per part still merge them with a prefix sum.
+class CPUSamplePartition {
+ public:
+  static constexpr size_t kNoWorkCap = std::numeric_limits<size_t>::max();
+
+  // Degree-aware split of the seeds.
+  void Build(const IdType *const indptr, const IdType *const input,
+             const size_t num_input, const size_t work_cap);
+  // Split of num_task tasks that cost the same, e.g. the seeds of KHop1
+  // whose cost is capped at fanout, or the walks of the random walk.
+  void BuildUniform(const size_t num_task);
+
+  size_t NumPart() const { return _bounds.size() - 1; }
+  size_t Begin(size_t part) const { return _bounds[part]; }
+  size_t End(size_t part) const { return _bounds[part + 1]; }
+
+  // Calls fn(part, begin, end) for every part on the thread pool and keeps
+  // the busy time of the parts
+  template <typename F>
+  void Run(F fn) {
+    ThreadPool::Get()->Run(NumPart(), ThreadBudget::Get(), [&](size_t part) {
+      Timer t;
+      fn(part, Begin(part), End(part));
+      _thread_time[part].val = t.Passed();
+    });
+  }
+
+  // The buffer of a part, kept by the calling thread among batches
+  CPUSampleBuffer &Buffer(size_t part) { return (*_buffers)[part]; }
+  // Remaps the buffered edges if remap_table is given and writes the
+  // buffers to the output in part order, data only if output_data is given.
+  // Returns the number of edges.
+  size_t Merge(IdType *output_src, IdType *output_dst, float *output_data,
+               CPUHashTable2 *remap_table);
+
+  // Called once after the parts are done. Publishes the slowest and the
+  // average part time of this call for the calling thread, the sampling
+  // loop reads them with GetLastThreadTime and reports the imbalance.
+  void Finish() const;
+  static void GetLastThreadTime(double *max_time, double *avg_time);
+
+ private:
+  struct PrefixItem {
+    size_t val;
+    size_t _padding[7];
+
+    PrefixItem() : val(0) {}
+  };
+
+  struct TimeItem {
+    double val;
+    double _padding[7];
+
+    TimeItem() : val(0) {}
+  };
+
+  void Init(const size_t num_parts);
+
+  std::vector<size_t> _bounds;
+  std::vector<PrefixItem> _chunk_cost;
+  std::vector<TimeItem> _thread_time;
+  std::vector<CPUSampleBuffer> *_buffers;
+};
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_SAMPLE_PARTITION_H
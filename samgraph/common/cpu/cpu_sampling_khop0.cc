@@ -16,11 +16,16 @@
  */
 
 #include <algorithm>
+#include <atomic>
 
 #include "../common.h"
 #include "../constant.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
 #include "cpu_function.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
 
 namespace samgraph {
 namespace common {
@@ -29,47 +34,66 @@ namespace cpu {
 void CPUSampleKHop0(const IdType *const indptr, const IdType *const indices,
                     const IdType *const input, const size_t num_input,
                     IdType *output_src, IdType *output_dst, size_t *num_ouput,
-                    const size_t fanout) {
-  bool all_has_fanout = true;
+                    const size_t fanout, const uint64_t random_stream) {
+  // random numbers of the reservoir are drawn in batches
+  constexpr size_t kRandomBatch = 64;
+  std::atomic<bool> all_has_fanout(true);
 
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num) reduction  (&&:all_has_fanout)
-  for (size_t i = 0; i < num_input; ++i) {
-    const IdType rid = input[i];
-    const IdType off = indptr[rid];
-    const IdType len = indptr[rid + 1] - off;
+  // the reservoir scans the whole row, so a seed costs its full degree
+  CPUSamplePartition partition;
 
-    all_has_fanout = all_has_fanout && (len >= fanout);
+  partition.Build(indptr, input, num_input, CPUSamplePartition::kNoWorkCap);
+  partition.Run([&](size_t, size_t input_begin, size_t input_end) {
+    bool has_fanout = true;
+    for (size_t i = input_begin; i < input_end; ++i) {
+      const IdType rid = input[i];
+      const IdType off = indptr[rid];
+      const IdType len = indptr[rid + 1] - off;
 
-    if (len <= fanout) {
-      size_t j = 0;
-      for (; j < len; ++j) {
-        output_src[i * fanout + j] = rid;
-        output_dst[i * fanout + j] = indices[off + j];
-      }
+      has_fanout = has_fanout && (len >= fanout);
 
-      for (; j < fanout; ++j) {
-        output_src[i * fanout + j] = Constant::kEmptyKey;
-        output_dst[i * fanout + j] = Constant::kEmptyKey;
-      }
-    } else {
-      // reservoir algorithm
-      // time: O(population), space: O(num)
-      for (size_t j = 0; j < fanout; ++j) {
-        output_src[i * fanout + j] = rid;
-        output_dst[i * fanout + j] = indices[off + j];
-      }
+      if (len <= fanout) {
+        size_t j = 0;
+        for (; j < len; ++j) {
+          output_src[i * fanout + j] = rid;
+          output_dst[i * fanout + j] = indices[off + j];
+        }
+
+        for (; j < fanout; ++j) {
+          output_src[i * fanout + j] = Constant::kEmptyKey;
+          output_dst[i * fanout + j] = Constant::kEmptyKey;
+        }
+      } else {
+        // reservoir algorithm
+        // time: O(population), space: O(num)
+        for (size_t j = 0; j < fanout; ++j) {
+          output_src[i * fanout + j] = rid;
+          output_dst[i * fanout + j] = indices[off + j];
+        }
 
-      for (size_t j = fanout; j < len; ++j) {
-        const IdType k = RandomID(0, j + 1);
-        if (k < fanout) {
-          output_dst[i * fanout + k] = indices[off + j];
+        PhiloxRandom rng(RunConfig::seed, random_stream, rid);
+        uint32_t random_batch[kRandomBatch];
+        for (size_t j = fanout; j < len; j += kRandomBatch) {
+          const size_t num_batch = Min(kRandomBatch, len - j);
+          rng.Fill(random_batch, num_batch);
+          for (size_t b = 0; b < num_batch; ++b) {
+            const IdType k = PhiloxRandom::Bound(random_batch[b], j + b + 1);
+            if (k < fanout) {
+              output_dst[i * fanout + k] = indices[off + j + b];
+            }
+          }
         }
       }
     }
-  }
+
+    if (!has_fanout) {
+      all_has_fanout.store(false, std::memory_order_relaxed);
+    }
+  });
+  partition.Finish();
 
   // single-thread compacting is faster than omp compacting
-  if (!all_has_fanout) {
+  if (!all_has_fanout.load()) {
     IdType *output_src_end =
         std::remove_if(output_src, output_src + num_input * fanout,
                        [](IdType num) { return num == Constant::kEmptyKey; });
@@ -15,17 +15,85 @@
  *
  */
 
+#include <vector>
+
+#include "../common.h"
+#include "../constant.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
 #include "cpu_function.h"
+#include "cpu_hashtable2.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
 
 namespace samgraph {
 namespace common {
 namespace cpu {
 
+// Sample-parallel khop: a seed costs at most fanout draws whatever its
+// degree, so whole seeds are evenly split among the parts without looking
+// at the graph; a hub is no heavier than any seed with fanout neighbours.
+// Each part samples its seeds into a private buffer that only holds the
+// valid edges, then the buffers are merged into the output with a prefix
+// sum over the per-part counts. Nodes with more than fanout neighbours are
+// sampled with replacement like the GPU kernel, but the result is not
+// deduplicated.
 void CPUSampleKHop1(const IdType *const indptr, const IdType *const indices,
                     const IdType *const input, const size_t num_input,
                     IdType *output_src, IdType *output_dst, size_t *num_ouput,
-                    const size_t fanout) {}
+                    const size_t fanout, const uint64_t random_stream,
+                    CPUHashTable2 *remap_table) {
+  CPUSamplePartition partition;
+
+  // whole seeds per part: the remap table needs one owner per seed and the
+  // slots of a seed come from one generator
+  partition.BuildUniform(num_input);
+  partition.Run([&](size_t part, size_t input_begin, size_t input_end) {
+    CPUSampleBuffer &buffer = partition.Buffer(part);
+    buffer.Reset((input_end - input_begin) * fanout, false);
+    IdType *local_src = buffer.src.data();
+    IdType *local_dst = buffer.dst.data();
+
+    // 1. Sample the seeds of this part into the local buffer
+    size_t num_local = 0;
+    for (size_t i = input_begin; i < input_end; i++) {
+      const IdType rid = input[i];
+      const IdType off = indptr[rid];
+      const IdType len = indptr[rid + 1] - off;
+      const IdType src = remap_table ? static_cast<IdType>(i) : rid;
+      const size_t num_item = Min<size_t>(len, fanout);
+
+      if (len <= fanout) {
+        for (size_t j = 0; j < len; j++) {
+          local_dst[num_local + j] = indices[off + j];
+        }
+      } else {
+        // slot j takes the j-th number of the seed node, the positions are
+        // drawn into the buffer and replaced by the neighbours
+        PhiloxRandom rng(RunConfig::seed, random_stream, rid);
+        rng.FillBounded(local_dst + num_local, fanout, len);
+        for (size_t j = 0; j < fanout; j++) {
+          local_dst[num_local + j] = indices[off + local_dst[num_local + j]];
+        }
+      }
+      for (size_t j = 0; j < num_item; j++) {
+        local_src[num_local + j] = src;
+      }
+
+      if (remap_table) {
+        remap_table->Claim(local_dst + num_local, num_item, src);
+      }
+      num_local += num_item;
+    }
+    buffer.num = num_local;
+  });
+
+  // 2. Remap and merge the local buffers into the output
+  *num_ouput = partition.Merge(output_src, output_dst, nullptr, remap_table);
+  partition.Finish();
+}
 
 }  // namespace cpu
 }  // namespace common
-}  // namespace samgraph
\ No newline at end of file
+}  // namespace samgraph
@@ -16,11 +16,16 @@
  */
 
 #include <algorithm>
+#include <atomic>
 
 #include "../common.h"
 #include "../constant.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
 #include "cpu_function.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
 
 namespace samgraph {
 namespace common {
@@ -29,40 +34,51 @@ namespace cpu {
 void CPUSampleKHop2(const IdType *const indptr, IdType *indices,
                     const IdType *const input, const size_t num_input,
                     IdType *output_src, IdType *output_dst, size_t *num_ouput,
-                    const size_t fanout) {
-  bool all_has_fanout = true;
+                    const size_t fanout, const uint64_t random_stream) {
+  std::atomic<bool> all_has_fanout(true);
 
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num) reduction  (&&:all_has_fanout)
-  for (size_t i = 0; i < num_input; ++i) {
-    const IdType rid = input[i];
-    const IdType off = indptr[rid];
-    const IdType len = indptr[rid + 1] - off;
+  CPUSamplePartition partition;
 
-    all_has_fanout = all_has_fanout && (len >= fanout);
+  partition.Build(indptr, input, num_input, fanout);
+  partition.Run([&](size_t, size_t input_begin, size_t input_end) {
+    bool has_fanout = true;
+    for (size_t i = input_begin; i < input_end; ++i) {
+      const IdType rid = input[i];
+      const IdType off = indptr[rid];
+      const IdType len = indptr[rid + 1] - off;
 
-    if (len <= fanout) {
-      size_t j = 0;
-      for (; j < len; ++j) {
-        output_src[i * fanout + j] = rid;
-        output_dst[i * fanout + j] = indices[off + j];
-      }
+      has_fanout = has_fanout && (len >= fanout);
 
-      for (; j < fanout; ++j) {
-        output_src[i * fanout + j] = Constant::kEmptyKey;
-        output_dst[i * fanout + j] = Constant::kEmptyKey;
-      }
-    } else {
-      for (size_t j = 0; j < fanout; ++j) {
-        const IdType k = RandomID(0, len - j - 1);
-        output_src[i * fanout + j] = rid;
-        output_dst[i * fanout + j] = indices[off + k];
-        std::swap(indices[off + k], indices[off + len - j - 1]);
+      if (len <= fanout) {
+        size_t j = 0;
+        for (; j < len; ++j) {
+          output_src[i * fanout + j] = rid;
+          output_dst[i * fanout + j] = indices[off + j];
+        }
+
+        for (; j < fanout; ++j) {
+          output_src[i * fanout + j] = Constant::kEmptyKey;
+          output_dst[i * fanout + j] = Constant::kEmptyKey;
+        }
+      } else {
+        PhiloxRandom rng(RunConfig::seed, random_stream, rid);
+        for (size_t j = 0; j < fanout; ++j) {
+          const IdType k = rng.NextBounded(len - j);
+          output_src[i * fanout + j] = rid;
+          output_dst[i * fanout + j] = indices[off + k];
+          std::swap(indices[off + k], indices[off + len - j - 1]);
+        }
       }
     }
-  }
+
+    if (!has_fanout) {
+      all_has_fanout.store(false, std::memory_order_relaxed);
+    }
+  });
+  partition.Finish();
 
   // single-thread compacting is faster than omp compacting
-  if (!all_has_fanout) {
+  if (!all_has_fanout.load()) {
     IdType *output_src_end =
         std::remove_if(output_src, output_src + num_input * fanout,
                        [](IdType num) { return num == Constant::kEmptyKey; });
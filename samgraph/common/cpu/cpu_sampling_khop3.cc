@@ -0,0 +1,175 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <vector>
+
+#include "../common.h"
+#include "../constant.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
+#include "cpu_function.h"
+#include "cpu_hashtable2.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+namespace {
+
+// small fanouts check the duplicates with a scan of the picked positions
+constexpr size_t kLinearScanMaxFanout = 32;
+
+// Open-addressing set of positions, reused by one thread for all its seeds
+class PositionSet {
+ public:
+  void Init(size_t fanout) {
+    size_t size = 1;
+    while (size < 2 * fanout) {
+      size <<= 1;
+    }
+    if (_table.size() != size) {
+      _table.assign(size, static_cast<IdType>(Constant::kEmptyKey));
+    }
+    _mask = size - 1;
+    _num_touched = 0;
+    _touched.resize(fanout);
+  }
+
+  // return false if the position is already in the set
+  bool Insert(IdType pos) {
+    IdType slot = (pos * 2654435761u) & _mask;
+    while (_table[slot] != Constant::kEmptyKey) {
+      if (_table[slot] == pos) {
+        return false;
+      }
+      slot = (slot + 1) & _mask;
+    }
+    _table[slot] = pos;
+    _touched[_num_touched++] = slot;
+    return true;
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < _num_touched; i++) {
+      _table[_touched[i]] = Constant::kEmptyKey;
+    }
+    _num_touched = 0;
+  }
+
+ private:
+  std::vector<IdType> _table;
+  std::vector<IdType> _touched;
+  size_t _num_touched;
+  IdType _mask;
+};
+
+}  // namespace
+
+// Uniform sampling without replacement with Floyd's algorithm: for
+// j = len - fanout .. len - 1, pick t in [0, j] and take j instead if t
+// was picked already. It needs exactly fanout random numbers per seed and
+// never writes to indices, so indices can stay on the read-only MMAP ctx
+// and concurrent samples of the same hub do not race like KHop2.
+// time: O(fanout) with the set, O(fanout^2) with the scan for small fanout
+void CPUSampleKHop3(const IdType *const indptr, const IdType *const indices,
+                    const IdType *const input, const size_t num_input,
+                    IdType *output_src, IdType *output_dst, size_t *num_ouput,
+                    const size_t fanout, const uint64_t random_stream,
+                    CPUHashTable2 *remap_table) {
+  CPUSamplePartition partition;
+
+  partition.Build(indptr, input, num_input, fanout);
+  partition.Run([&](size_t part, size_t input_begin, size_t input_end) {
+    // reused among batches to avoid allocating in every sampling step
+    static thread_local std::vector<IdType> picked;
+    static thread_local PositionSet picked_set;
+
+    CPUSampleBuffer &buffer = partition.Buffer(part);
+    buffer.Reset((input_end - input_begin) * fanout, false);
+    IdType *local_src = buffer.src.data();
+    IdType *local_dst = buffer.dst.data();
+    picked.resize(fanout);
+    const bool use_scan = fanout <= kLinearScanMaxFanout;
+    if (!use_scan) {
+      picked_set.Init(fanout);
+    }
+
+    // 1. Sample the seeds of this part into the local buffer
+    size_t num_local = 0;
+    for (size_t i = input_begin; i < input_end; i++) {
+      const IdType rid = input[i];
+      const IdType off = indptr[rid];
+      const IdType len = indptr[rid + 1] - off;
+      const IdType src = remap_table ? static_cast<IdType>(i) : rid;
+
+      if (len <= fanout) {
+        for (IdType j = 0; j < len; j++) {
+          local_src[num_local + j] = src;
+          local_dst[num_local + j] = indices[off + j];
+        }
+        if (remap_table) {
+          remap_table->Claim(local_dst + num_local, len, src);
+        }
+        num_local += len;
+        continue;
+      }
+
+      PhiloxRandom rng(RunConfig::seed, random_stream, rid);
+      size_t num_picked = 0;
+      for (IdType j = len - fanout; j < len; j++) {
+        IdType t = rng.NextBounded(j + 1);
+        if (use_scan) {
+          for (size_t k = 0; k < num_picked; k++) {
+            if (picked[k] == t) {
+              t = j;
+              break;
+            }
+          }
+        } else if (!picked_set.Insert(t)) {
+          // j can not be picked before, it is larger than all the others
+          picked_set.Insert(j);
+          t = j;
+        }
+        picked[num_picked++] = t;
+      }
+      if (!use_scan) {
+        picked_set.Clear();
+      }
+
+      for (size_t j = 0; j < fanout; j++) {
+        local_src[num_local + j] = src;
+        local_dst[num_local + j] = indices[off + picked[j]];
+      }
+      if (remap_table) {
+        remap_table->Claim(local_dst + num_local, fanout, src);
+      }
+      num_local += fanout;
+    }
+    buffer.num = num_local;
+  });
+
+  // 2. Remap and merge the local buffers into the output
+  *num_ouput = partition.Merge(output_src, output_dst, nullptr, remap_table);
+  partition.Finish();
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
@@ -15,7 +15,18 @@
  *
  */
 
+#include "../common.h"
+#include "../constant.h"
+#include "../device.h"
+#include "../logging.h"
+#include "../profiler.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
+#include "cpu_frequency_hashmap.h"
 #include "cpu_function.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
 
 namespace samgraph {
 namespace common {
@@ -23,10 +34,82 @@ namespace cpu {
 
 void CPUSampleRandomWalk(const IdType *const indptr,
                          const IdType *const indices, const IdType *const input,
-                         const size_t num_input, IdType *output_src,
-                         IdType *output_dst, size_t *num_ouput,
-                         const size_t fanout) {}
+                         const size_t num_input,
+                         const size_t random_walk_length,
+                         const double random_walk_restart_prob,
+                         const size_t num_random_walk, const size_t K,
+                         IdType *output_src, IdType *output_dst,
+                         IdType *output_data, size_t *num_ouput,
+                         CPUFrequencyHashmap *frequency_hashmap,
+                         const uint64_t random_stream, uint64_t task_key) {
+  auto cpu_device = Device::Get(CPU());
+  const size_t edges_per_node = num_random_walk * random_walk_length;
+
+  // 1. random walk sampling
+  //    layout: the edges_per_node visits of a seed are contiguous, so the
+  //    frequency map only touches one range per seed.
+  Timer t0;
+  IdType *tmp_dst = static_cast<IdType *>(cpu_device->AllocWorkspace(
+      CPU(), num_input * edges_per_node * sizeof(IdType)));
+
+  // walks are independent, so the (seed, walk) pairs are split among the
+  // threads and the walks of a seed may run on different threads
+  const size_t num_task = num_input * num_random_walk;
+  CPUSamplePartition partition;
+
+  partition.BuildUniform(num_task);
+  partition.Run([&](size_t, size_t task_begin, size_t task_end) {
+    for (size_t task_idx = task_begin; task_idx < task_end; task_idx++) {
+      const size_t i = task_idx / num_random_walk;
+      const size_t walk_idx = task_idx % num_random_walk;
+      const IdType start_node = input[i];
+      IdType *visits =
+          tmp_dst + i * edges_per_node + walk_idx * random_walk_length;
+
+      // a step draws at most two numbers, every walk has its own range
+      PhiloxRandom rng(RunConfig::seed, random_stream, start_node);
+      rng.Seek(walk_idx * random_walk_length * 2);
+
+      IdType node = start_node;
+      for (size_t step_idx = 0; step_idx < random_walk_length; step_idx++) {
+        if (node == Constant::kEmptyKey) {
+          visits[step_idx] = Constant::kEmptyKey;
+          continue;
+        }
+
+        const IdType off = indptr[node];
+        const IdType len = indptr[node + 1] - off;
+        if (len == 0) {
+          visits[step_idx] = Constant::kEmptyKey;
+          node = Constant::kEmptyKey;
+        } else {
+          node = indices[off + rng.NextBounded(len)];
+          visits[step_idx] = node;
+
+          // terminate, the next walk restarts from the seed
+          if (rng.NextUniform() < random_walk_restart_prob) {
+            node = Constant::kEmptyKey;
+          }
+        }
+      }
+    }
+  });
+  partition.Finish();
+
+  double random_walk_sampling_time = t0.Passed();
+
+  // 2. TopK
+  Timer t1;
+  frequency_hashmap->GetTopK(tmp_dst, input, num_input, K, output_src,
+                             output_dst, output_data, num_ouput);
+  cpu_device->FreeWorkspace(CPU(), tmp_dst);
+  double topk_time = t1.Passed();
+
+  Profiler::Get().LogStepAdd(task_key, kLogL3RandomWalkSampleCooTime,
+                             random_walk_sampling_time);
+  Profiler::Get().LogStepAdd(task_key, kLogL3RandomWalkTopKTime, topk_time);
+}
 
 }  // namespace cpu
 }  // namespace common
-}  // namespace samgraph
\ No newline at end of file
+}  // namespace samgraph
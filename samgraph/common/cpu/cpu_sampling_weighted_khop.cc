@@ -15,17 +15,92 @@
  *
  */
 
+#include <algorithm>
+#include <vector>
+
+#include "../common.h"
+#include "../constant.h"
+#include "../logging.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
 #include "cpu_function.h"
+#include "cpu_hashtable2.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
 
 namespace samgraph {
 namespace common {
 namespace cpu {
 
+// Alias method: each draw picks a column k uniformly and keeps
+// indices[off + k] with probability prob_table[off + k], otherwise takes
+// alias_table[off + k]. Every seed with neighbours gets exactly fanout
+// samples (with replacement, like the GPU sampler), so the work per seed
+// is O(fanout) and the tables are only touched at the sampled columns.
+// The weight of a draw is read at its column of the alias weight table,
+// which keeps the probability of the kept and of the aliased edge.
 void CPUSampleWeightedKHop(const IdType *const indptr,
                            const IdType *const indices,
+                           const float *const prob_table,
+                           const IdType *const alias_table,
+                           const float *const alias_weight_table,
                            const IdType *const input, const size_t num_input,
                            IdType *output_src, IdType *output_dst,
-                           size_t *num_ouput, const size_t fanout) {}
+                           float *output_data, size_t *num_ouput,
+                           const size_t fanout, const uint64_t random_stream,
+                           CPUHashTable2 *remap_table) {
+  CHECK(output_data == nullptr || alias_weight_table != nullptr);
+  CPUSamplePartition partition;
+
+  partition.Build(indptr, input, num_input, fanout);
+  partition.Run([&](size_t part, size_t input_begin, size_t input_end) {
+    CPUSampleBuffer &buffer = partition.Buffer(part);
+    buffer.Reset((input_end - input_begin) * fanout, output_data != nullptr);
+    IdType *local_src = buffer.src.data();
+    IdType *local_dst = buffer.dst.data();
+    float *local_data = buffer.data.data();
+
+    // 1. Sample the seeds of this part into the local buffer
+    size_t num_local = 0;
+    for (size_t i = input_begin; i < input_end; i++) {
+      const IdType rid = input[i];
+      const IdType off = indptr[rid];
+      const IdType len = indptr[rid + 1] - off;
+      const IdType src = remap_table ? static_cast<IdType>(i) : rid;
+
+      if (len == 0) {
+        continue;
+      }
+
+      PhiloxRandom rng(RunConfig::seed, random_stream, rid);
+      for (size_t j = 0; j < fanout; j++) {
+        const IdType k = rng.NextBounded(len);
+        const float r = rng.NextUniform();
+        const bool keep = r < prob_table[off + k];
+        local_src[num_local + j] = src;
+        local_dst[num_local + j] = keep ? indices[off + k]
+                                        : alias_table[off + k];
+        if (output_data) {
+          local_data[num_local + j] =
+              alias_weight_table[2 * static_cast<size_t>(off + k) + !keep];
+        }
+      }
+
+      if (remap_table) {
+        remap_table->Claim(local_dst + num_local, fanout, src);
+      }
+      num_local += fanout;
+    }
+    buffer.num = num_local;
+  });
+
+  // 2. Remap and merge the local buffers into the output
+  *num_ouput =
+      partition.Merge(output_src, output_dst, output_data, remap_table);
+  partition.Finish();
+}
+
 }  // namespace cpu
 }  // namespace common
-}  // namespace samgraph
\ No newline at end of file
+}  // namespace samgraph
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "../common.h"
+#include "../constant.h"
+#include "../run_config.h"
+#include "../thread_pool.h"
+#include "../timer.h"
+#include "cpu_function.h"
+#include "cpu_hashtable2.h"
+#include "cpu_random.h"
+#include "cpu_sample_partition.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+namespace {
+
+// rows with more than kMergeFactor * fanout neighbours use binary search
+constexpr size_t kMergeFactor = 16;
+
+// Resolve the sorted draws with one merged pass over the prefix array.
+// time: O(len + fanout), sequential access
+void MergeSearch(const float *const prefix, const IdType len,
+                 const float *draws, IdType *pos, const size_t fanout) {
+  IdType k = 0;
+  for (size_t j = 0; j < fanout; j++) {
+    while (k < len - 1 && prefix[k] < draws[j]) {
+      k++;
+    }
+    pos[j] = k;
+  }
+}
+
+// Branchless lower bound for all draws in lockstep. The remaining range
+// only depends on len, so the probes of different draws are independent and
+// the inner loop can be vectorized into gathers.
+// time: O(fanout * log(len))
+void LockstepSearch(const float *const prefix, const IdType len,
+                    const float *draws, IdType *pos, const size_t fanout) {
+  for (size_t j = 0; j < fanout; j++) {
+    pos[j] = 0;
+  }
+
+  IdType n = len;
+  while (n > 1) {
+    const IdType half = n / 2;
+#pragma omp simd
+    for (size_t j = 0; j < fanout; j++) {
+      pos[j] += (prefix[pos[j] + half] < draws[j]) ? half : 0;
+    }
+    n -= half;
+  }
+
+#pragma omp simd
+  for (size_t j = 0; j < fanout; j++) {
+    pos[j] += (prefix[pos[j]] < draws[j]) ? 1 : 0;
+    // float rounding may push a draw past the last prefix
+    pos[j] = pos[j] < len ? pos[j] : len - 1;
+  }
+}
+
+}  // namespace
+
+// Prefix-sum weighted sampling: draw fanout uniforms in [0, total weight),
+// sort them and map every draw to the first neighbour whose prefix is not
+// smaller than it. Only needs the 4-byte prefix table per edge.
+void CPUSampleWeightedKHopPrefix(const IdType *const indptr,
+                                 const IdType *const indices,
+                                 const float *const prob_prefix_table,
+                                 const IdType *const input,
+                                 const size_t num_input, IdType *output_src,
+                                 IdType *output_dst, float *output_data,
+                                 size_t *num_ouput, const size_t fanout,
+                                 const uint64_t random_stream,
+                                 CPUHashTable2 *remap_table) {
+  CPUSamplePartition partition;
+
+  partition.Build(indptr, input, num_input, kMergeFactor * fanout);
+  partition.Run([&](size_t part, size_t input_begin, size_t input_end) {
+    // reused among batches to avoid allocating in every sampling step
+    static thread_local std::vector<float> draws;
+    static thread_local std::vector<IdType> pos;
+
+    CPUSampleBuffer &buffer = partition.Buffer(part);
+    buffer.Reset((input_end - input_begin) * fanout, output_data != nullptr);
+    IdType *local_src = buffer.src.data();
+    IdType *local_dst = buffer.dst.data();
+    float *local_data = buffer.data.data();
+    draws.resize(fanout);
+    pos.resize(fanout);
+
+    // 1. Sample the seeds of this part into the local buffer
+    size_t num_local = 0;
+    for (size_t i = input_begin; i < input_end; i++) {
+      const IdType rid = input[i];
+      const IdType off = indptr[rid];
+      const IdType len = indptr[rid + 1] - off;
+      const IdType src = remap_table ? static_cast<IdType>(i) : rid;
+
+      if (len == 0) {
+        continue;
+      }
+
+      const float *prefix = prob_prefix_table + off;
+      const float total = prefix[len - 1];
+      PhiloxRandom rng(RunConfig::seed, random_stream, rid);
+      rng.FillUniform(draws.data(), fanout);
+      for (size_t j = 0; j < fanout; j++) {
+        draws[j] *= total;
+      }
+
+      if (len <= kMergeFactor * fanout) {
+        std::sort(draws.begin(), draws.end());
+        MergeSearch(prefix, len, draws.data(), pos.data(), fanout);
+      } else {
+        LockstepSearch(prefix, len, draws.data(), pos.data(), fanout);
+      }
+
+      for (size_t j = 0; j < fanout; j++) {
+        const IdType k = pos[j];
+        local_src[num_local + j] = src;
+        local_dst[num_local + j] = indices[off + k];
+        if (output_data) {
+          const float prev = k > 0 ? prefix[k - 1] : 0.0f;
+          local_data[num_local + j] = (prefix[k] - prev) / total;
+        }
+      }
+
+      if (remap_table) {
+        remap_table->Claim(local_dst + num_local, fanout, src);
+      }
+      num_local += fanout;
+    }
+    buffer.num = num_local;
+  });
+
+  // 2. Remap and merge the local buffers into the output
+  *num_ouput =
+      partition.Merge(output_src, output_dst, output_data, remap_table);
+  partition.Finish();
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
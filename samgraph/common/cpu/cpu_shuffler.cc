@@ -18,13 +18,14 @@
 #include "cpu_shuffler.h"
 
 #include <algorithm>
-#include <chrono>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <numeric>
-#include <random>
 
 #include "../logging.h"
+#include "../run_config.h"
+#include "cpu_random.h"
 
 namespace samgraph {
 namespace common {
@@ -33,6 +34,7 @@ CPUShuffler::CPUShuffler(TensorPtr input, int num_epoch, size_t batch_size,
                          bool drop_last) {
   _num_data = input->Shape().front();
   CHECK_EQ(input->Shape().size(), 1);
+  CHECK_LE(_num_data, std::numeric_limits<uint32_t>::max());
   CHECK_GT(batch_size, 0);
 
   _num_epoch = num_epoch;
@@ -68,14 +70,13 @@ void CPUShuffler::ReShuffle() {
     return;
   }
 
-  auto seed = std::chrono::system_clock::now().time_since_epoch().count();
   void *data = _data->MutableData();
 
-  auto g = std::default_random_engine(seed);
+  // every epoch has its own stream, so it can be replayed from the seed
+  cpu::PhiloxRandom rng(RunConfig::seed, cpu::kShuffleStream | _cur_epoch, 0);
 
   for (size_t i = _num_data - 1; i > 0; i--) {
-    std::uniform_int_distribution<size_t> d(0, i);
-    size_t candidate = d(g);
+    size_t candidate = rng.NextBounded(i + 1);
     switch (_data->Type()) {
       case kI32:
         std::swap((reinterpret_cast<int *>(data))[i],
@@ -0,0 +1,316 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "cpu_topology.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "../logging.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+namespace {
+
+constexpr char kSysfsRoot[] = "/sys/devices/system";
+
+// The first line of a sysfs file, empty if the file does not exist
+std::string ReadLine(const std::string &path) {
+  std::ifstream f(path);
+  std::string line;
+  std::getline(f, line);
+  return line;
+}
+
+// Parses a cpu list like "0-3,8,10-11"
+std::vector<int> ParseCPUList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::string FormatCPUList(std::vector<int> cpus) {
+  if (cpus.empty()) {
+    return "any";
+  }
+  std::sort(cpus.begin(), cpus.end());
+  std::stringstream ss;
+  for (size_t i = 0; i < cpus.size();) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+      j++;
+    }
+    ss << (i ? "," : "") << cpus[i];
+    if (j > i) {
+      ss << "-" << cpus[j];
+    }
+    i = j + 1;
+  }
+  return ss.str();
+}
+
+std::map<int, int> ReadCPUNodes(const std::string &root) {
+  std::map<int, int> cpu_node;
+  std::string node_dir = root + "/node";
+  DIR *dir = opendir(node_dir.c_str());
+  if (dir == nullptr) {
+    return cpu_node;
+  }
+  while (struct dirent *entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+        !std::isdigit(name[4])) {
+      continue;
+    }
+    int node = std::stoi(name.substr(4));
+    for (int cpu : ParseCPUList(ReadLine(node_dir + "/" + name + "/cpulist"))) {
+      cpu_node[cpu] = node;
+    }
+  }
+  closedir(dir);
+  return cpu_node;
+}
+
+std::vector<int> AffinityCPUs() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+// Appends the cpus of the cores in [begin, end)
+void AddCores(const std::vector<CPUCore> &cores, size_t begin, size_t end,
+              std::vector<int> &cpus) {
+  for (size_t i = begin; i < end; i++) {
+    cpus.insert(cpus.end(), cores[i].cpus.begin(), cores[i].cpus.end());
+  }
+}
+
+}  // namespace
+
+const CPUTopology &CPUTopology::Get() {
+  static const CPUTopology topo = Load(kSysfsRoot, AffinityCPUs());
+  return topo;
+}
+
+CPUTopology CPUTopology::Load(const std::string &root,
+                              const std::vector<int> &allowed) {
+  CPUTopology topo;
+  std::set<int> allowed_set(allowed.begin(), allowed.end());
+  std::vector<int> online = ParseCPUList(ReadLine(root + "/cpu/online"));
+  std::map<int, int> cpu_node = ReadCPUNodes(root);
+
+  // (socket, core id) -> cpus
+  std::map<std::pair<int, int>, std::vector<int>> core_cpus;
+  bool known = !online.empty();
+  for (int cpu : online) {
+    if (!allowed_set.empty() && allowed_set.count(cpu) == 0) {
+      continue;
+    }
+    std::string dir = root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+    std::string socket = ReadLine(dir + "physical_package_id");
+    std::string core = ReadLine(dir + "core_id");
+    if (socket.empty() || core.empty()) {
+      known = false;
+      break;
+    }
+    core_cpus[{std::stoi(socket), std::stoi(core)}].push_back(cpu);
+  }
+
+  if (!known || core_cpus.empty()) {
+    // every cpu we may run on is a core of its own
+    std::vector<int> cpus = allowed;
+    if (cpus.empty()) {
+      for (unsigned i = 0; i < std::thread::hardware_concurrency(); i++) {
+        cpus.push_back(i);
+      }
+    }
+    if (cpus.empty()) {
+      cpus.push_back(0);
+    }
+    for (int cpu : cpus) {
+      topo._cores.push_back({0, -1, {cpu}});
+    }
+    topo._num_socket = 1;
+    topo._known = false;
+    return topo;
+  }
+
+  std::set<int> sockets;
+  for (auto &kv : core_cpus) {
+    int node = cpu_node.count(kv.second[0]) ? cpu_node[kv.second[0]] : -1;
+    topo._cores.push_back({kv.first.first, node, kv.second});
+    sockets.insert(kv.first.first);
+  }
+  // by socket, then by the first cpu, the order of the core ids does not
+  // follow the cpu ids on every machine
+  std::sort(topo._cores.begin(), topo._cores.end(),
+            [](const CPUCore &a, const CPUCore &b) {
+              return a.socket != b.socket ? a.socket < b.socket
+                                          : a.cpus[0] < b.cpus[0];
+            });
+  topo._num_socket = sockets.size();
+  topo._known = true;
+  return topo;
+}
+
+size_t CPUTopology::NumCPU() const {
+  size_t num_cpu = 0;
+  for (auto &core : _cores) {
+    num_cpu += core.cpus.size();
+  }
+  return num_cpu;
+}
+
+std::string CPUTopology::ToString() const {
+  std::stringstream ss;
+  ss << _num_socket << " sockets, " << NumCore() << " cores, " << NumCPU()
+     << " cpus";
+  if (!_known) {
+    ss << " (topology unknown)";
+  }
+  return ss.str();
+}
+
+std::string CPUPlacement::ToString() const {
+  std::stringstream ss;
+  ss << "sample " << sample_thread_num << " threads on cpus "
+     << FormatCPUList(sample_cpus);
+  if (extract_thread_num > 0) {
+    ss << ", extract " << extract_thread_num << " threads on cpus "
+       << FormatCPUList(extract_cpus);
+  }
+  ss << ", copy on cpus " << FormatCPUList(copy_cpus)
+     << (pin ? ", pinned" : ", not pinned");
+  return ss.str();
+}
+
+size_t DefaultThreadNum(const CPUTopology &topo, size_t num_process) {
+  return Max<size_t>(topo.NumCore() / Max<size_t>(num_process, 1), 1);
+}
+
+CPUPlacement PlanPlacement(const CPUTopology &topo, size_t num_pool_thread,
+                           bool has_extract, size_t sample_thread_num,
+                           size_t extract_thread_num, bool pin) {
+  const auto &cores = topo.Cores();
+  const size_t num_core = cores.size();
+  // the copier mostly waits for the GPU, one core is enough
+  const size_t num_copy_core = num_core >= 4 ? 1 : 0;
+  const size_t copy_begin = num_core - num_copy_core;
+  // a smaller pool only needs as many cores
+  const size_t num_kernel_core =
+      Max<size_t>(Min(copy_begin, num_pool_thread), 1);
+
+  CPUPlacement plan;
+  plan.pin = pin && topo.Known();
+  if (has_extract) {
+    plan.extract_thread_num = extract_thread_num
+                                  ? extract_thread_num
+                                  : Max<size_t>(num_kernel_core / 4, 1);
+  }
+  plan.sample_thread_num =
+      sample_thread_num
+          ? sample_thread_num
+          : Max<size_t>(num_kernel_core - Min(plan.extract_thread_num,
+                                              num_kernel_core - 1),
+                        1);
+  if (!plan.pin) {
+    return plan;
+  }
+
+  // too few cores to split, the kernel stages share them
+  const bool disjoint =
+      plan.sample_thread_num + plan.extract_thread_num <= num_kernel_core;
+  const size_t num_sample_core =
+      disjoint ? plan.sample_thread_num : num_kernel_core;
+  const size_t extract_begin =
+      disjoint ? num_kernel_core - plan.extract_thread_num : 0;
+  AddCores(cores, 0, num_sample_core, plan.sample_cpus);
+  if (has_extract) {
+    AddCores(cores, extract_begin, num_kernel_core, plan.extract_cpus);
+  }
+  if (num_copy_core > 0) {
+    AddCores(cores, copy_begin, num_core, plan.copy_cpus);
+  } else {
+    AddCores(cores, 0, num_core, plan.copy_cpus);
+  }
+
+  std::vector<size_t> kernel_cores;
+  for (size_t i = 0; i < num_sample_core; i++) {
+    kernel_cores.push_back(i);
+  }
+  for (size_t i = Max(extract_begin, num_sample_core);
+       has_extract && i < num_kernel_core; i++) {
+    kernel_cores.push_back(i);
+  }
+  for (size_t i = 0; i + 1 < num_pool_thread; i++) {
+    plan.pool_cpus.push_back(cores[kernel_cores[i % kernel_cores.size()]].cpus);
+  }
+  return plan;
+}
+
+void PinThread(const std::vector<int> &cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (ret != 0) {
+    LOG(WARNING) << "Failed to pin a thread to cpus " << FormatCPUList(cpus)
+                 << ", error " << ret;
+  }
+}
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
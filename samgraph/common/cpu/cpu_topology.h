@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_CPU_TOPOLOGY_H
+#define SAMGRAPH_CPU_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+#include "../common.h"
+
+namespace samgraph {
+namespace common {
+namespace cpu {
+
+// A physical core, the first cpu is the one the kernel threads go to, the
+// others are its SMT siblings
+struct CPUCore {
+  int socket;
+  int node;
+  std::vector<int> cpus;
+};
+
+// The cores this process may run on, read from /sys/devices/system/cpu and
+// /sys/devices/system/node and restricted to the affinity mask the process
+// was started with. The cores are sorted by socket, so a range of them
+// stays on as few sockets as possible.
+class CPUTopology {
+ public:
+  // The topology of the machine, read once
+  static const CPUTopology &Get();
+  // Reads the sysfs tree under root, keeps the cpus in allowed only
+  static CPUTopology Load(const std::string &root,
+                          const std::vector<int> &allowed);
+
+  const std::vector<CPUCore> &Cores() const { return _cores; }
+  size_t NumCore() const { return _cores.size(); }
+  size_t NumCPU() const;
+  size_t NumSocket() const { return _num_socket; }
+  // False if sysfs could not be read, every cpu is then a core of its own
+  // and no thread is pinned
+  bool Known() const { return _known; }
+  std::string ToString() const;
+
+ private:
+  std::vector<CPUCore> _cores;
+  size_t _num_socket = 0;
+  bool _known = false;
+};
+
+// Where the threads of the arch0 pipeline run. The sample, extract and copy
+// stages get disjoint sets of cores, the samplers take the first cores and
+// the extractors the last ones, so a stage stays on one socket when it fits.
+// The pool threads are pinned one per core of the two kernel stages.
+struct CPUPlacement {
+  // the cpus of each stage, SMT siblings included
+  std::vector<int> sample_cpus;
+  std::vector<int> extract_cpus;
+  std::vector<int> copy_cpus;
+  // the cpus of every pool thread but the calling one
+  std::vector<std::vector<int>> pool_cpus;
+  // kernel threads of all the workers of a stage together
+  size_t sample_thread_num = 0;
+  size_t extract_thread_num = 0;
+  bool pin = false;
+
+  std::string ToString() const;
+};
+
+// Threads of a process when omp_thread_num is left to 0: one per core,
+// shared by the processes started on the same host
+size_t DefaultThreadNum(const CPUTopology &topo, size_t num_process);
+
+// Splits the cores among the stages. The thread nums are taken as given
+// when not 0, else the extract stage gets a quarter of the kernel cores.
+// has_extract is false when the copy stage extracts from the GPU cache.
+CPUPlacement PlanPlacement(const CPUTopology &topo, size_t num_pool_thread,
+                           bool has_extract, size_t sample_thread_num,
+                           size_t extract_thread_num, bool pin);
+
+// Binds the calling thread to the cpus, a no-op for an empty set
+void PinThread(const std::vector<int> &cpus);
+
+}  // namespace cpu
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_CPU_TOPOLOGY_H
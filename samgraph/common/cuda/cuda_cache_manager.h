@@ -52,7 +52,7 @@ class GPUCacheManager {
                          size_t* num_output_cache, const IdType* nodes,
                          const size_t num_nodes, StreamHandle stream);
   void ExtractMissData(void* output_miss, const IdType* miss_src_index,
-                       const size_t num_miss);
+                       const size_t num_miss, uint64_t key);
   void CombineMissData(void* output, const void* miss,
                        const IdType* miss_dst_index, const size_t num_miss,
                        StreamHandle stream);
@@ -99,7 +99,7 @@ class GPUDynamicCacheManager {
                          const IdType* nodes, const size_t num_nodes,
                          StreamHandle stream);
   void ExtractMissData(void* output_miss, const IdType* miss_src_index,
-                       const size_t num_miss);
+                       const size_t num_miss, uint64_t key);
   void CombineMissData(void* output, const void* miss,
                        const IdType* miss_dst_index, const size_t num_miss,
                        StreamHandle stream);
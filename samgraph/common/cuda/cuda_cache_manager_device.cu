@@ -363,6 +363,8 @@ void GPUCacheManager::CombineMissData(void *output, const void *miss,
           output, miss, miss_dst_index, num_miss, _dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       combine_miss_data<short><<<grid, block, 0, cu_stream>>>(
           output, miss, miss_dst_index, num_miss, _dim);
       break;
@@ -415,6 +417,8 @@ void GPUCacheManager::CombineCacheData(void *output,
           _trainer_cache_data, _dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       combine_cache_data<short><<<grid, block, 0, cu_stream>>>(
           output, cache_src_index, cache_dst_index, num_cache,
           _trainer_cache_data, _dim);
@@ -541,6 +545,8 @@ void GPUDynamicCacheManager::CombineMissData(void *output, const void *miss,
           output, miss, miss_dst_index, num_miss, _dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       combine_miss_data<short><<<grid, block, 0, cu_stream>>>(
           output, miss, miss_dst_index, num_miss, _dim);
       break;
@@ -597,6 +603,8 @@ void GPUDynamicCacheManager::CombineCacheData(void *output,
           train_cache_data, _dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       combine_cache_data<short><<<grid, block, 0, cu_stream>>>(
           output, cache_src_index, cache_dst_index, num_cache,
           train_cache_data, _dim);
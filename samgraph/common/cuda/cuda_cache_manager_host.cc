@@ -21,7 +21,9 @@
 
 #include "../common.h"
 #include "../constant.h"
+#include "../cpu/cpu_feature_store.h"
 #include "../device.h"
+#include "../engine.h"
 #include "../function.h"
 #include "../logging.h"
 #include "../run_config.h"
@@ -32,31 +34,6 @@ namespace samgraph {
 namespace common {
 namespace cuda {
 
-namespace {
-
-/** cache is only used for feature, so we can do mock here */
-template <typename T>
-void extract_miss_data(void *output_miss, const IdType *miss_src_index,
-                       const size_t num_miss, const void *src, size_t dim) {
-  T *output_miss_data = reinterpret_cast<T *>(output_miss);
-  const T *cpu_src_data = reinterpret_cast<const T *>(src);
-  size_t idx_mock_mask = 0xffffffffffffffff;
-  if (RunConfig::option_empty_feat != 0) {
-    idx_mock_mask = (1ull << RunConfig::option_empty_feat) - 1;
-  }
-
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-  for (size_t i = 0; i < num_miss; i++) {
-    size_t src_idx = miss_src_index[i] & idx_mock_mask;
-#pragma omp simd
-    for (size_t j = 0; j < dim; j++) {
-      output_miss_data[i * dim + j] = cpu_src_data[src_idx * dim + j];
-    }
-  }
-}
-
-}  // namespace
-
 GPUCacheManager::GPUCacheManager(Context sampler_ctx, Context trainer_ctx,
                                  const void *cpu_src_data, DataType dtype,
                                  size_t dim, const IdType *nodes,
@@ -136,35 +113,18 @@ GPUCacheManager::~GPUCacheManager() {
 
 void GPUCacheManager::ExtractMissData(void *output_miss,
                                       const IdType *miss_src_index,
-                                      const size_t num_miss) {
+                                      const size_t num_miss,
+                                      uint64_t key) {
   if (num_miss == 0) return;
-  switch (_dtype) {
-    case kF32:
-      extract_miss_data<float>(output_miss, miss_src_index, num_miss,
-                               _cpu_src_data, _dim);
-      break;
-    case kF64:
-      extract_miss_data<double>(output_miss, miss_src_index, num_miss,
-                                _cpu_src_data, _dim);
-      break;
-    case kF16:
-      extract_miss_data<short>(output_miss, miss_src_index, num_miss,
-                               _cpu_src_data, _dim);
-      break;
-    case kU8:
-      extract_miss_data<uint8_t>(output_miss, miss_src_index, num_miss,
-                                 _cpu_src_data, _dim);
-      break;
-    case kI32:
-      extract_miss_data<int32_t>(output_miss, miss_src_index, num_miss,
-                                 _cpu_src_data, _dim);
-      break;
-    case kI64:
-      extract_miss_data<int64_t>(output_miss, miss_src_index, num_miss,
-                                 _cpu_src_data, _dim);
-      break;
-    default:
-      CHECK(0);
+  auto feat_store = Engine::Get()->GetGraphDataset()->feat_store;
+  if (RunConfig::option_empty_feat != 0) {
+    cpu::CPUMockExtract(output_miss, _cpu_src_data, miss_src_index, num_miss,
+                        _dim, _dtype);
+  } else if (feat_store) {
+    feat_store->Extract(output_miss, miss_src_index, num_miss, key);
+  } else {
+    cpu::CPUExtract(output_miss, _cpu_src_data, miss_src_index, num_miss, _dim,
+                    _dtype);
   }
 }
 
@@ -269,34 +229,17 @@ GPUDynamicCacheManager::~GPUDynamicCacheManager() {
 
 void GPUDynamicCacheManager::ExtractMissData(void *output_miss,
                                       const IdType *miss_src_index,
-                                      const size_t num_miss) {
-  switch (_dtype) {
-    case kF32:
-      extract_miss_data<float>(output_miss, miss_src_index, num_miss,
-                               _cpu_src_data, _dim);
-      break;
-    case kF64:
-      extract_miss_data<double>(output_miss, miss_src_index, num_miss,
-                                _cpu_src_data, _dim);
-      break;
-    case kF16:
-      extract_miss_data<short>(output_miss, miss_src_index, num_miss,
-                               _cpu_src_data, _dim);
-      break;
-    case kU8:
-      extract_miss_data<uint8_t>(output_miss, miss_src_index, num_miss,
-                                 _cpu_src_data, _dim);
-      break;
-    case kI32:
-      extract_miss_data<int32_t>(output_miss, miss_src_index, num_miss,
-                                 _cpu_src_data, _dim);
-      break;
-    case kI64:
-      extract_miss_data<int64_t>(output_miss, miss_src_index, num_miss,
-                                 _cpu_src_data, _dim);
-      break;
-    default:
-      CHECK(0);
+                                      const size_t num_miss,
+                                      uint64_t key) {
+  auto feat_store = Engine::Get()->GetGraphDataset()->feat_store;
+  if (RunConfig::option_empty_feat != 0) {
+    cpu::CPUMockExtract(output_miss, _cpu_src_data, miss_src_index, num_miss,
+                        _dim, _dtype);
+  } else if (feat_store) {
+    feat_store->Extract(output_miss, miss_src_index, num_miss, key);
+  } else {
+    cpu::CPUExtract(output_miss, _cpu_src_data, miss_src_index, num_miss, _dim,
+                    _dtype);
   }
 }
 
@@ -43,16 +43,21 @@ void *GPUDevice::AllocDataSpace(Context ctx, size_t nbytes, size_t alignment) {
   CHECK_EQ(256 % alignment, 0U);
   CUDA_CALL(cudaSetDevice(ctx.device_id));
   CUDA_CALL(cudaMalloc(&ret, nbytes));
-  // data space is only allocated during init phase, thread-safe
-  _allocated_size_list[ctx.device_id] += nbytes; 
+  std::lock_guard<std::mutex> lock(_allocated_mutex);
+  _allocated_size_list[ctx.device_id] += nbytes;
+  _allocated_nbytes[ret] = nbytes;
   return ret;
 }
 
 void GPUDevice::FreeDataSpace(Context ctx, void *ptr) {
   CUDA_CALL(cudaSetDevice(ctx.device_id));
   CUDA_CALL(cudaFree(ptr));
-  /** data space is only allocated during init phase
-    * freed workspace does not return here */
+  std::lock_guard<std::mutex> lock(_allocated_mutex);
+  auto it = _allocated_nbytes.find(ptr);
+  if (it != _allocated_nbytes.end()) {
+    _allocated_size_list[ctx.device_id] -= it->second;
+    _allocated_nbytes.erase(it);
+  }
 }
 
 void GPUDevice::CopyDataFromTo(const void *from, size_t from_offset, void *to,
@@ -167,6 +172,12 @@ size_t GPUDevice::DataSize(Context ctx) {
 size_t GPUDevice::FreeWorkspaceSize(Context ctx) {
   return GPUWorkspacePool()->FreeSize(ctx);
 }
+WorkspaceStats GPUDevice::GetWorkspaceStats(Context ctx) {
+  return GPUWorkspacePool()->Stats(ctx);
+}
+void GPUDevice::TrimWorkspace(Context ctx) {
+  GPUWorkspacePool()->Trim(ctx);
+}
 
 }  // namespace cuda
 }  // namespace common
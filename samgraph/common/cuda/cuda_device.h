@@ -20,6 +20,8 @@
 
 #include <cuda_runtime.h>
 #include <array>
+#include <mutex>
+#include <unordered_map>
 
 #include "../device.h"
 
@@ -50,6 +52,8 @@ class GPUDevice final : public Device {
   size_t DataSize(Context ctx) override;
   size_t WorkspaceSize(Context ctx) override;
   size_t FreeWorkspaceSize(Context ctx) override;
+  WorkspaceStats GetWorkspaceStats(Context ctx) override;
+  void TrimWorkspace(Context ctx) override;
 
   static const std::shared_ptr<GPUDevice> &Global();
 
@@ -60,6 +64,9 @@ class GPUDevice final : public Device {
                           int to_device, size_t nbytes, cudaStream_t stream);
   // std::array<std::atomic_size_t, 32> _allocated_size_list;
   size_t* _allocated_size_list;
+  // the workspace allocates and frees data space at any time
+  std::mutex _allocated_mutex;
+  std::unordered_map<void*, size_t> _allocated_nbytes;
 };
 
 }  // namespace cuda
@@ -229,6 +229,10 @@ void GPUEngine::Shutdown() {
   }
 
   _should_shutdown = true;
+  // wake up the threads waiting on the graph pool
+  if (_graph_pool) {
+    _graph_pool->Stop();
+  }
   int total_thread_num = _threads.size();
 
   while (!IsAllThreadFinish(total_thread_num)) {
@@ -345,6 +349,8 @@ std::unordered_map<std::string, Context> GPUEngine::GetGraphFileCtx() {
   ret[Constant::kValidSetFile] = CPU();
   ret[Constant::kProbTableFile] = _sampler_ctx;
   ret[Constant::kAliasTableFile] = _sampler_ctx;
+  // only read by the CPU sampler
+  ret[Constant::kAliasWeightTableFile] = MMAP();
   ret[Constant::kInDegreeFile] = MMAP();
   ret[Constant::kOutDegreeFile] = MMAP();
   ret[Constant::kCacheByDegreeFile] = MMAP();
@@ -94,6 +94,8 @@ void GPUExtract(void *dst, const void *src, const IdType *index,
           <<<grid, block, 0, cu_stream>>>(dst, src, index, num_index, dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       gpu_extract<short>
           <<<grid, block, 0, cu_stream>>>(dst, src, index, num_index, dim);
       break;
@@ -140,6 +142,8 @@ void GPUMockExtract(void *dst, const void *src, const IdType *index,
           <<<grid, block, 0, cu_stream>>>(dst, src, index, num_index, dim, idx_mock_mask);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       gpu_mock_extract<short>
           <<<grid, block, 0, cu_stream>>>(dst, src, index, num_index, dim, idx_mock_mask);
       break;
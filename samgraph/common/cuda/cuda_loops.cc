@@ -17,6 +17,7 @@
 
 #include "cuda_loops.h"
 
+#include "../cpu/cpu_feature_store.h"
 #include "../device.h"
 #include "../function.h"
 #include "../logging.h"
@@ -680,7 +681,9 @@ void DoCPUFeatureExtract(TaskPtr task) {
   auto label = dataset->label;
 
   auto feat_dim = dataset->feat->Shape()[1];
-  auto feat_type = dataset->feat->Type();
+  // int8 features are dequantized to kF32 while gathering
+  auto feat_type =
+      dataset->feat_scale->Defined() ? kF32 : dataset->feat->Type();
   auto label_type = dataset->label->Type();
 
   auto input_data = reinterpret_cast<const IdType *>(input_nodes->Data());
@@ -706,6 +709,13 @@ void DoCPUFeatureExtract(TaskPtr task) {
   if (RunConfig::option_empty_feat != 0) {
     cpu::CPUMockExtract(feat_dst, feat_src, input_data, num_input, feat_dim,
                         feat_type);
+  } else if (dataset->feat_store) {
+    dataset->feat_store->Extract(feat_dst, input_data, num_input, task->key);
+  } else if (dataset->feat_scale->Defined()) {
+    cpu::CPUExtractDequant(
+        feat_dst, feat_src,
+        static_cast<const float *>(dataset->feat_scale->Data()), input_data,
+        num_input, feat_dim);
   } else {
     cpu::CPUExtract(feat_dst, feat_src, input_data, num_input, feat_dim,
                     feat_type);
@@ -1052,7 +1062,7 @@ void DoCacheFeatureCopy(TaskPtr task) {
       trainer_ctx, GetTensorBytes(feat_type, {num_output_miss, feat_dim}));
 
   cache_manager->ExtractMissData(cpu_output_miss, cpu_output_miss_src_index,
-                                 num_output_miss);
+                                 num_output_miss, task->key);
 
   double extract_miss_time = t2.Passed();
 
@@ -1226,7 +1236,7 @@ void DoDynamicCacheFeatureCopy(TaskPtr task) {
       trainer_ctx, GetTensorBytes(feat_type, {num_output_miss, feat_dim}));
 
   cache_manager->ExtractMissData(cpu_output_miss, cpu_output_miss_src_index,
-                                 num_output_miss);
+                                 num_output_miss, task->key);
 
   double extract_miss_time = t2.Passed();
 
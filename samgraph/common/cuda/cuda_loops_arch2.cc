@@ -86,8 +86,7 @@ bool RunSampleSubLoopOnce() {
 
 bool RunDataCopySubLoopOnce() {
   auto graph_pool = GPUEngine::Get()->GetGraphPool();
-  if (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  if (!graph_pool->WaitNotFull()) {
     return true;
   }
 
@@ -127,8 +126,7 @@ bool RunDataCopySubLoopOnce() {
 
 bool RunCacheDataCopySubLoopOnce() {
   auto graph_pool = GPUEngine::Get()->GetGraphPool();
-  if (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  if (!graph_pool->WaitNotFull()) {
     return true;
   }
 
@@ -90,9 +90,8 @@ bool RunSampleSubLoopOnce() {
 
 bool RunDataCopySubLoopOnce() {
   auto graph_pool = GPUEngine::Get()->GetGraphPool();
-  while (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
-    // return true;
+  if (!graph_pool->WaitNotFull()) {
+    return true;
   }
 
   auto this_op = kDataCopy;
@@ -147,9 +146,8 @@ bool RunDataCopySubLoopOnce() {
 
 bool RunCacheDataCopySubLoopOnce() {
   auto graph_pool = GPUEngine::Get()->GetGraphPool();
-  while (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
-    // return true;
+  if (!graph_pool->WaitNotFull()) {
+    return true;
   }
 
   auto this_op = kDataCopy;
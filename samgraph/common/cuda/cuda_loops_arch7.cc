@@ -53,8 +53,7 @@ namespace cuda {
 
 bool RunSampleCopySubLoopOnce() {
   auto graph_pool = GPUEngine::Get()->GetGraphPool();
-  if (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  if (!graph_pool->WaitNotFull()) {
     return true;
   }
 
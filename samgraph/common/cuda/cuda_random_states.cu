@@ -91,6 +91,9 @@ GPURandomStates::GPURandomStates(SampleType sample_type,
     case kWeightedKHopHashDedup:
       _num_states = PredictNumNodes(batch_size, fanout, fanout.size() - 1);
       break;
+    case kKHop3:
+      CHECK(0) << "KHop3 is only implemented by the CPU sampler";
+      break;
     default:
       CHECK(0);
   }
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "dataset_loader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+#include "constant.h"
+#include "huge_page.h"
+#include "logging.h"
+#include "run_config.h"
+#include "timer.h"
+
+namespace samgraph {
+namespace common {
+
+namespace {
+
+// Bytes a thread copies at a time, a few read ahead windows
+constexpr size_t kLoadChunkSize = 64 << 20;
+
+}  // namespace
+
+DatasetLoader::DatasetLoader(size_t num_thread)
+    : _num_thread(num_thread > 0
+                      ? num_thread
+                      : static_cast<size_t>(Max(RunConfig::omp_thread_num, 1))) {
+}
+
+void DatasetLoader::Add(TensorPtr *out, std::string filepath, DataType dtype,
+                        std::vector<size_t> shape, Context ctx,
+                        TensorName name, StreamHandle stream) {
+  CHECK(FileExist(filepath)) << "No file " << filepath;
+  size_t nbytes = GetTensorBytes(dtype, shape.begin(), shape.end());
+  _files.push_back({out, std::move(filepath), dtype, std::move(shape), ctx,
+                    Device::Get(ctx), std::move(name), stream, nbytes, nullptr,
+                    nullptr});
+}
+
+void DatasetLoader::Open(File &file) {
+  struct stat st;
+  CHECK_EQ(stat(file.filepath.c_str(), &st), 0);
+  CHECK_EQ(file.nbytes, static_cast<size_t>(st.st_size))
+      << "Unexpected size of " << file.filepath;
+
+  int fd = open(file.filepath.c_str(), O_RDONLY, 0);
+  CHECK_GE(fd, 0) << "Failed to open " << file.filepath;
+  file.mapping =
+      mmap(NULL, file.nbytes, PROT_READ, MAP_SHARED | MAP_FILE, fd, 0);
+  CHECK_NE(file.mapping, MAP_FAILED) << "Failed to map " << file.filepath;
+  close(fd);
+
+  switch (file.ctx.device_type) {
+    case kCPU:
+    case kGPU:
+      // read once from the front by each copying thread, the pages can go
+      // right after
+      madvise(file.mapping, file.nbytes, MADV_SEQUENTIAL);
+      file.data = file.device->AllocWorkspace(
+          file.ctx, file.nbytes, Constant::kAllocNoScale);
+      break;
+    case kMMAP:
+      // the kernel reads the whole file in the background, the early random
+      // accesses fault the pages they need first
+      AdviseHugePage(file.mapping, file.nbytes);
+      madvise(file.mapping, file.nbytes, MADV_WILLNEED);
+      file.data = file.mapping;
+      break;
+    default:
+      CHECK(0);
+  }
+}
+
+void DatasetLoader::Run() {
+  Timer t;
+  ParallelRun(_files.size(), [this](size_t i) { Open(_files[i]); });
+
+  // the chunks of every copied file, as (file, offset)
+  std::vector<std::pair<size_t, size_t>> chunks;
+  size_t copy_nbytes = 0;
+  for (size_t i = 0; i < _files.size(); i++) {
+    if (_files[i].data == _files[i].mapping) {
+      continue;
+    }
+    for (size_t offset = 0; offset < _files[i].nbytes;
+         offset += kLoadChunkSize) {
+      chunks.push_back({i, offset});
+    }
+    copy_nbytes += _files[i].nbytes;
+  }
+  ParallelRun(chunks.size(), [this, &chunks](size_t i) {
+    File &file = _files[chunks[i].first];
+    size_t offset = chunks[i].second;
+    size_t nbytes = Min(kLoadChunkSize, file.nbytes - offset);
+    file.device->CopyDataFromTo(file.mapping, offset, file.data, offset,
+                                nbytes, CPU(), file.ctx, file.stream);
+    file.device->StreamSync(file.ctx, file.stream);
+  });
+
+  for (auto &file : _files) {
+    if (file.data != file.mapping) {
+      munmap(file.mapping, file.nbytes);
+    }
+    *file.out = Tensor::FromBlob(file.data, file.dtype, file.shape, file.ctx,
+                                 file.name);
+  }
+  LOG(DEBUG) << "DatasetLoader: loaded " << _files.size() << " files, copied "
+             << ToReadableSize(copy_nbytes) << " in " << t.Passed()
+             << " secs";
+  _files.clear();
+}
+
+void DatasetLoader::ParallelRun(size_t num,
+                                const std::function<void(size_t)> &fn) {
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    for (size_t i = next.fetch_add(1); i < num; i = next.fetch_add(1)) {
+      fn(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < Min(_num_thread, num); i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace common
+}  // namespace samgraph
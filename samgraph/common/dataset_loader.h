@@ -0,0 +1,78 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_DATASET_LOADER_H
+#define SAMGRAPH_DATASET_LOADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "device.h"
+
+namespace samgraph {
+namespace common {
+
+// Loads the dataset files in parallel. The files are mapped without locking
+// them: the kMMAP ones are read ahead by the kernel in the background, the
+// ones for kCPU and kGPU are read ahead sequentially and copied in chunks,
+// the chunks of all files shared by the threads of the loader.
+//
+// The threads only live during Run, so no thread is left for the processes
+// forked after the dataset is loaded.
+class DatasetLoader {
+ public:
+  // 0 threads takes RunConfig::omp_thread_num
+  explicit DatasetLoader(size_t num_thread = 0);
+
+  // *out gets the file once Run returns
+  void Add(TensorPtr *out, std::string filepath, DataType dtype,
+           std::vector<size_t> shape, Context ctx, TensorName name,
+           StreamHandle stream = nullptr);
+  // Loads the files added since the last Run
+  void Run();
+
+ private:
+  struct File {
+    TensorPtr *out;
+    std::string filepath;
+    DataType dtype;
+    std::vector<size_t> shape;
+    Context ctx;
+    // got by Add, the devices are created without the loader threads racing
+    Device *device;
+    TensorName name;
+    StreamHandle stream;
+    size_t nbytes;
+    void *mapping;
+    void *data;
+  };
+
+  // Maps the file and allocates its copy
+  void Open(File &file);
+  // Calls fn(i) for i in [0, num) on the threads of the loader
+  void ParallelRun(size_t num, const std::function<void(size_t)> &fn);
+
+  const size_t _num_thread;
+  std::vector<File> _files;
+};
+
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_DATASET_LOADER_H
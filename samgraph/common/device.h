@@ -20,6 +20,8 @@
 
 #include <cstdint>
 #include <array>
+#include <string>
+#include <vector>
 
 #include "common.h"
 #include "constant.h"
@@ -33,6 +35,40 @@ constexpr int kAllocAlignment = 64;
 // Number of bytes each allocation must align to in temporary allocation
 constexpr int kTempAllocaAlignment = 64;
 
+enum WorkspaceStatItem {
+  kWorkspaceInUse = 0,
+  kWorkspaceCached,
+  kWorkspacePeakInUse,
+  kWorkspacePeakTotal,
+  kWorkspaceNumAlloc,
+  kWorkspaceNumDeviceAlloc,
+  kWorkspaceNumTrim,
+  kWorkspaceTrimmedBytes,
+  kNumWorkspaceStatItems,
+};
+
+// Workspace memory of one device, see WorkspacePool
+struct WorkspaceSiteStats {
+  std::string site;
+  size_t in_use = 0;
+  size_t peak_in_use = 0;
+  size_t num_alloc = 0;
+};
+
+struct WorkspaceStats {
+  // bytes handed out, and the bytes the pool holds from the device but
+  // nobody uses
+  size_t in_use = 0;
+  size_t cached = 0;
+  size_t peak_in_use = 0;
+  size_t peak_total = 0;
+  size_t num_alloc = 0;
+  size_t num_device_alloc = 0;
+  size_t num_trim = 0;
+  size_t trimmed_bytes = 0;
+  std::vector<WorkspaceSiteStats> sites;
+};
+
 class Device {
  public:
   virtual ~Device() {}
@@ -56,6 +92,9 @@ class Device {
   virtual size_t DataSize(Context ctx) {return 0;};
   virtual size_t WorkspaceSize(Context ctx) {return 0;};
   virtual size_t FreeWorkspaceSize(Context ctx) {return 0;};
+  virtual WorkspaceStats GetWorkspaceStats(Context ctx) { return {}; }
+  // Returns the cached workspace of ctx to the device
+  virtual void TrimWorkspace(Context ctx) {}
   static Device *Get(Context ctx);
 };
 }  // namespace common
@@ -110,6 +110,8 @@ void DistCacheManager::CombineMissData(void *output, const void *miss,
           output, miss, miss_dst_index, num_miss, _dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       combine_miss_data<short><<<grid, block, 0, cu_stream>>>(
           output, miss, miss_dst_index, num_miss, _dim);
       break;
@@ -161,6 +163,8 @@ void DistCacheManager::CombineCacheData(void *output,
           _trainer_cache_data, _dim);
       break;
     case kF16:
+    case kBF16:
+    case kU16:
       combine_cache_data<short><<<grid, block, 0, cu_stream>>>(
           output, cache_src_index, cache_dst_index, num_cache,
           _trainer_cache_data, _dim);
@@ -35,6 +35,7 @@
 #include "../logging.h"
 #include "../profiler.h"
 #include "../run_config.h"
+#include "../thread_pool.h"
 #include "../timer.h"
 #include "dist_loops.h"
 #include "dist_shuffler.h"
@@ -175,8 +176,7 @@ void DistEngine::Init() {
 
 void DistEngine::SampleDataCopy(Context sampler_ctx, StreamHandle stream) {
   _dataset->train_set = Tensor::CopyTo(_dataset->train_set, CPU(), stream);
-  _dataset->valid_set = Tensor::CopyTo(_dataset->valid_set, CPU(), stream);
-  _dataset->test_set = Tensor::CopyTo(_dataset->test_set, CPU(), stream);
+  // the valid and test sets are only mapped once they are used
   if (sampler_ctx.device_type == kGPU) {
     _dataset->indptr = Tensor::CopyTo(_dataset->indptr, sampler_ctx, stream);
     _dataset->indices = Tensor::CopyTo(_dataset->indices, sampler_ctx, stream);
@@ -237,6 +237,8 @@ void DistEngine::SampleInit(int worker_id, Context ctx) {
   _dist_type = DistType::Sample;
   RunConfig::sampler_ctx = ctx;
   _sampler_ctx = RunConfig::sampler_ctx;
+  // the pool of the forked worker, the parent never starts one
+  ThreadPool::Create(RunConfig::omp_thread_num);
   LOG_MEM_USAGE(WARNING, "before sample initialization", _sampler_ctx);
   double time_cuda_context = t0.Passed();
 
@@ -368,6 +370,8 @@ void DistEngine::TrainInit(int worker_id, Context ctx, DistType dist_type) {
   _dist_type = dist_type;
   RunConfig::trainer_ctx = ctx;
   _trainer_ctx = RunConfig::trainer_ctx;
+  // the pool of the forked worker, the parent never starts one
+  ThreadPool::Create(RunConfig::omp_thread_num);
 
   LOG_MEM_USAGE(WARNING, "before train initialization", _trainer_ctx);
   double time_create_cuda_ctx = t0.Passed();
@@ -510,6 +514,10 @@ void DistEngine::Shutdown() {
   }
 
   _should_shutdown = true;
+  // wake up the threads waiting on the graph pool
+  if (_graph_pool) {
+    _graph_pool->Stop();
+  }
   int total_thread_num = _threads.size();
 
   while (!IsAllThreadFinish(total_thread_num)) {
@@ -523,6 +531,8 @@ void DistEngine::Shutdown() {
     _threads[i] = nullptr;
   }
 
+  ThreadPool::Destroy();
+
   // free queue
   for (size_t i = 0; i < cuda::QueueNum; i++) {
     if (_queues[i]) {
@@ -620,6 +630,7 @@ std::unordered_map<std::string, Context> DistEngine::GetGraphFileCtx() {
   ret[Constant::kValidSetFile] = MMAP();
   ret[Constant::kProbTableFile] = MMAP();
   ret[Constant::kAliasTableFile] = MMAP();
+  ret[Constant::kAliasWeightTableFile] = MMAP();
   ret[Constant::kInDegreeFile] = MMAP();
   ret[Constant::kOutDegreeFile] = MMAP();
   ret[Constant::kCacheByDegreeFile] = MMAP();
@@ -59,8 +59,7 @@ static TaskPtr old_task = nullptr;
 
 bool RunSampleSubLoopOnce() {
   auto graph_pool = DistEngine::Get()->GetGraphPool();
-  if (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+  if (!graph_pool->WaitNotFull()) {
     return true;
   }
 
@@ -157,9 +156,8 @@ bool RunSampleSubLoopOnce() {
 
 bool RunDataCopySubLoopOnce() {
   auto graph_pool = DistEngine::Get()->GetGraphPool();
-  while (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
-    // return true;
+  if (!graph_pool->WaitNotFull()) {
+    return true;
   }
 
   auto this_op = cuda::kDataCopy;
@@ -204,9 +202,8 @@ bool RunDataCopySubLoopOnce() {
 bool RunCacheDataCopySubLoopOnce() {
   auto graph_pool = DistEngine::Get()->GetGraphPool();
   auto dist_type  = DistEngine::Get()->GetDistType();
-  while (graph_pool->Full()) {
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
-    // return true;
+  if (!graph_pool->WaitNotFull()) {
+    return true;
   }
 
   auto this_op = cuda::kDataCopy;
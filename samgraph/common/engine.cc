@@ -22,16 +22,23 @@
 
 #include <cstdlib>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iterator>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common.h"
 #include "constant.h"
 #include "cpu/cpu_engine.h"
+#include "cpu/cpu_feature_store.h"
 #include "cuda/cuda_engine.h"
+#include "dataset_loader.h"
 #include "dist/dist_engine.h"
+#include "huge_page.h"
 #include "logging.h"
 #include "profiler.h"
 #include "run_config.h"
@@ -42,6 +49,49 @@ namespace common {
 
 Engine* Engine::_engine = nullptr;
 
+namespace {
+
+// Maps the file on the first Get of a lazy table
+std::function<TensorPtr()> LazyLoader(std::string filepath, DataType dtype,
+                                      std::vector<size_t> shape, Context ctx,
+                                      TensorName name) {
+  return [=]() { return Tensor::FromMmap(filepath, dtype, shape, ctx, name); };
+}
+
+// Logs how much of the large host tensors of the dataset sit on huge pages.
+// khugepaged may still collapse more of the mappings later.
+void ReportHugePageCoverage(const Dataset& dataset) {
+  std::vector<std::pair<const char*, TensorPtr>> tensors = {
+      {"indptr", dataset.indptr},
+      {"indices", dataset.indices},
+      {"feat", dataset.feat},
+      {"label", dataset.label}};
+  size_t total_nbytes = 0;
+  size_t total_huge_nbytes = 0;
+  for (auto& entry : tensors) {
+    const TensorPtr& tensor = entry.second;
+    if (tensor == nullptr || !tensor->Defined() ||
+        tensor->Ctx().device_type == kGPU) {
+      continue;
+    }
+    size_t nbytes = tensor->NumBytes();
+    size_t huge_nbytes = HugePageCoverage(tensor->Data(), nbytes);
+    LOG(INFO) << "dataset." << entry.first << ": "
+              << ToReadableSize(huge_nbytes) << " of "
+              << ToReadableSize(nbytes) << " on huge pages";
+    total_nbytes += nbytes;
+    total_huge_nbytes += huge_nbytes;
+  }
+  if (total_nbytes > 0) {
+    LOG(INFO) << "Dataset huge page coverage: " << std::fixed
+              << std::setprecision(1)
+              << 100.0 * total_huge_nbytes / total_nbytes << "% of "
+              << ToReadableSize(total_nbytes);
+  }
+}
+
+}  // namespace
+
 void Engine::Create() {
   if (_engine) {
     return;
@@ -126,20 +176,62 @@ void Engine::LoadGraphDataset() {
   _dataset->num_edge = meta[Constant::kMetaNumEdge];
   _dataset->num_class = meta[Constant::kMetaNumClass];
 
-  _dataset->indptr =
-      Tensor::FromMmap(_dataset_path + Constant::kIndptrFile, DataType::kI32,
-                       {meta[Constant::kMetaNumNode] + 1},
-                       ctx_map[Constant::kIndptrFile], "dataset.indptr");
-  _dataset->indices =
-      Tensor::FromMmap(_dataset_path + Constant::kIndicesFile, DataType::kI32,
-                       {meta[Constant::kMetaNumEdge]},
-                       ctx_map[Constant::kIndicesFile], "dataset.indices");
+  // Compact datasets are written by utility/data-process/toolkit/quantize
+  DataType feat_type = kF32;
+  DataType label_type = kI64;
+  if (meta.count(Constant::kMetaFeatType) > 0) {
+    feat_type = static_cast<DataType>(meta[Constant::kMetaFeatType]);
+  }
+  if (meta.count(Constant::kMetaLabelType) > 0) {
+    label_type = static_cast<DataType>(meta[Constant::kMetaLabelType]);
+  }
+  CHECK(feat_type == kF32 || feat_type == kF16 || feat_type == kBF16 ||
+        feat_type == kI8)
+      << "Unsupported feature type " << feat_type;
+  CHECK(label_type == kI64 || label_type == kU8 || label_type == kU16)
+      << "Unsupported label type " << label_type;
+
+  // the files are loaded together by loader.Run, the tables few runs read
+  // wait for their first use
+  DatasetLoader loader;
+  loader.Add(&_dataset->indptr, _dataset_path + Constant::kIndptrFile,
+             DataType::kI32, {meta[Constant::kMetaNumNode] + 1},
+             ctx_map[Constant::kIndptrFile], "dataset.indptr");
+  loader.Add(&_dataset->indices, _dataset_path + Constant::kIndicesFile,
+             DataType::kI32, {meta[Constant::kMetaNumEdge]},
+             ctx_map[Constant::kIndicesFile], "dataset.indices");
 
+  _dataset->feat_scale = Tensor::Null();
+  _dataset->feat_store = nullptr;
+  bool use_feat_store = false;
   if (FileExist(_dataset_path + Constant::kFeatFile) && RunConfig::option_empty_feat == 0) {
-    _dataset->feat = Tensor::FromMmap(
-        _dataset_path + Constant::kFeatFile, DataType::kF32,
-        {meta[Constant::kMetaNumNode], meta[Constant::kMetaFeatDim]},
-        ctx_map[Constant::kFeatFile], "dataset.feat");
+    // the host feature store reads the rows itself, the mapping only serves
+    // the rare full scans such as filling the gpu cache
+    use_feat_store = RunConfig::UseHostCache() &&
+                     ctx_map[Constant::kFeatFile].device_type == kMMAP;
+    if (use_feat_store) {
+      CHECK_NE(feat_type, kI8) << "int8 features are not supported by the "
+                                  "host feature store";
+      _dataset->feat = Tensor::FromMmapLazy(
+          _dataset_path + Constant::kFeatFile, feat_type,
+          {meta[Constant::kMetaNumNode], meta[Constant::kMetaFeatDim]},
+          "dataset.feat");
+    } else {
+      loader.Add(&_dataset->feat, _dataset_path + Constant::kFeatFile,
+                 feat_type,
+                 {meta[Constant::kMetaNumNode], meta[Constant::kMetaFeatDim]},
+                 ctx_map[Constant::kFeatFile], "dataset.feat");
+    }
+    // int8 rows are dequantized while the CPU gathers them
+    if (feat_type == kI8) {
+      CHECK(ctx_map[Constant::kFeatFile].device_type != kGPU &&
+            !RunConfig::UseGPUCache())
+          << "int8 features can only be extracted by the CPU";
+      loader.Add(&_dataset->feat_scale,
+                 _dataset_path + Constant::kFeatScaleFile, DataType::kF32,
+                 {meta[Constant::kMetaNumNode]}, ctx_map[Constant::kFeatFile],
+                 "dataset.feat_scale");
+    }
   } else {
     if (RunConfig::option_empty_feat != 0) {
       _dataset->feat = Tensor::EmptyNoScale(
@@ -155,109 +247,121 @@ void Engine::LoadGraphDataset() {
   }
 
   if (FileExist(_dataset_path + Constant::kLabelFile)) {
-    _dataset->label =
-        Tensor::FromMmap(_dataset_path + Constant::kLabelFile, DataType::kI64,
-                         {meta[Constant::kMetaNumNode]},
-                         ctx_map[Constant::kLabelFile], "dataset.label");
+    loader.Add(&_dataset->label, _dataset_path + Constant::kLabelFile,
+               label_type, {meta[Constant::kMetaNumNode]},
+               ctx_map[Constant::kLabelFile], "dataset.label");
   } else {
     _dataset->label =
         Tensor::EmptyNoScale(DataType::kI64, {meta[Constant::kMetaNumNode]},
                              ctx_map[Constant::kLabelFile], "dataset.label");
   }
 
-  _dataset->train_set =
-      Tensor::FromMmap(_dataset_path + Constant::kTrainSetFile, DataType::kI32,
-                       {meta[Constant::kMetaNumTrainSet]},
-                       ctx_map[Constant::kTrainSetFile], "dataset.train_set");
-  _dataset->test_set =
-      Tensor::FromMmap(_dataset_path + Constant::kTestSetFile, DataType::kI32,
-                       {meta[Constant::kMetaNumTestSet]},
-                       ctx_map[Constant::kTestSetFile], "dataset.test_set");
-  _dataset->valid_set =
-      Tensor::FromMmap(_dataset_path + Constant::kValidSetFile, DataType::kI32,
-                       {meta[Constant::kMetaNumValidSet]},
-                       ctx_map[Constant::kValidSetFile], "dataset.valid_set");
+  loader.Add(&_dataset->train_set, _dataset_path + Constant::kTrainSetFile,
+             DataType::kI32, {meta[Constant::kMetaNumTrainSet]},
+             ctx_map[Constant::kTrainSetFile], "dataset.train_set");
+  _dataset->test_set.SetLoader(
+      LazyLoader(_dataset_path + Constant::kTestSetFile, DataType::kI32,
+                 {meta[Constant::kMetaNumTestSet]},
+                 ctx_map[Constant::kTestSetFile], "dataset.test_set"));
+  _dataset->valid_set.SetLoader(
+      LazyLoader(_dataset_path + Constant::kValidSetFile, DataType::kI32,
+                 {meta[Constant::kMetaNumValidSet]},
+                 ctx_map[Constant::kValidSetFile], "dataset.valid_set"));
 
+  _dataset->alias_weight_table = Tensor::Null();
   if (RunConfig::sample_type == kWeightedKHop || RunConfig::sample_type == kWeightedKHopHashDedup) {
-    _dataset->prob_table = Tensor::FromMmap(
-        _dataset_path + Constant::kProbTableFile, DataType::kF32,
-        {meta[Constant::kMetaNumEdge]}, ctx_map[Constant::kProbTableFile],
-        "dataset.prob_table");
-
-    _dataset->alias_table = Tensor::FromMmap(
-        _dataset_path + Constant::kAliasTableFile, DataType::kI32,
-        {meta[Constant::kMetaNumEdge]}, ctx_map[Constant::kAliasTableFile],
-        "dataset.alias_table");
+    loader.Add(&_dataset->prob_table, _dataset_path + Constant::kProbTableFile,
+               DataType::kF32, {meta[Constant::kMetaNumEdge]},
+               ctx_map[Constant::kProbTableFile], "dataset.prob_table");
+    loader.Add(&_dataset->alias_table,
+               _dataset_path + Constant::kAliasTableFile, DataType::kI32,
+               {meta[Constant::kMetaNumEdge]},
+               ctx_map[Constant::kAliasTableFile], "dataset.alias_table");
+    if (RunConfig::sample_type == kWeightedKHop &&
+        RunConfig::sample_edge_weight) {
+      CHECK(FileExist(_dataset_path + Constant::kAliasWeightTableFile))
+          << "The edge weights of " << RunConfig::sample_type << " need "
+          << Constant::kAliasWeightTableFile << " of create_alias_table";
+      loader.Add(&_dataset->alias_weight_table,
+                 _dataset_path + Constant::kAliasWeightTableFile,
+                 DataType::kF32, {2 * meta[Constant::kMetaNumEdge]},
+                 ctx_map[Constant::kAliasWeightTableFile],
+                 "dataset.alias_weight_table");
+    }
     _dataset->prob_prefix_table = Tensor::Null();
   } else if (RunConfig::sample_type == kWeightedKHopPrefix){
     _dataset->prob_table = Tensor::Null();
     _dataset->alias_table = Tensor::Null();
-    _dataset->prob_prefix_table = Tensor::FromMmap(
-        _dataset_path + Constant::kProbPrefixTableFile, DataType::kF32,
-        {meta[Constant::kMetaNumEdge]}, ctx_map[Constant::kProbTableFile],
-        "dataset.prob_prefix_table");
+    loader.Add(&_dataset->prob_prefix_table,
+               _dataset_path + Constant::kProbPrefixTableFile, DataType::kF32,
+               {meta[Constant::kMetaNumEdge]},
+               ctx_map[Constant::kProbTableFile], "dataset.prob_prefix_table");
   } else {
     _dataset->prob_table = Tensor::Null();
     _dataset->alias_table = Tensor::Null();
     _dataset->prob_prefix_table = Tensor::Null();
   }
 
-  if (RunConfig::option_log_node_access) {
-    _dataset->in_degrees = Tensor::FromMmap(
-        _dataset_path + Constant::kInDegreeFile, DataType::kI32,
-        {meta[Constant::kMetaNumNode]}, ctx_map[Constant::kInDegreeFile],
-        "dataset.in_degrees");
-    _dataset->out_degrees = Tensor::FromMmap(
-        _dataset_path + Constant::kOutDegreeFile, DataType::kI32,
-        {meta[Constant::kMetaNumNode]}, ctx_map[Constant::kOutDegreeFile],
-        "dataset.out_degrees");
-  }
+  _dataset->in_degrees.SetLoader(
+      LazyLoader(_dataset_path + Constant::kInDegreeFile, DataType::kI32,
+                 {meta[Constant::kMetaNumNode]},
+                 ctx_map[Constant::kInDegreeFile], "dataset.in_degrees"));
+  _dataset->out_degrees.SetLoader(
+      LazyLoader(_dataset_path + Constant::kOutDegreeFile, DataType::kI32,
+                 {meta[Constant::kMetaNumNode]},
+                 ctx_map[Constant::kOutDegreeFile], "dataset.out_degrees"));
 
-  if (RunConfig::UseGPUCache()) {
+  if (RunConfig::UseGPUCache() || use_feat_store) {
+    std::string ranking_file;
     switch (RunConfig::cache_policy) {
       case kCacheByDegree:
-        _dataset->ranking_nodes = Tensor::FromMmap(
-            _dataset_path + Constant::kCacheByDegreeFile, DataType::kI32,
-            {meta[Constant::kMetaNumNode]},
-            ctx_map[Constant::kCacheByDegreeFile], "dataset.ranking_nodes");
+        ranking_file = Constant::kCacheByDegreeFile;
         break;
       case kCacheByHeuristic:
-        _dataset->ranking_nodes = Tensor::FromMmap(
-            _dataset_path + Constant::kCacheByHeuristicFile, DataType::kI32,
-            {meta[Constant::kMetaNumNode]},
-            ctx_map[Constant::kCacheByHeuristicFile], "dataset.ranking_nodes");
+        ranking_file = Constant::kCacheByHeuristicFile;
         break;
       case kCacheByPreSample:
       case kCacheByPreSampleStatic:
         break;
       case kCacheByDegreeHop:
-        _dataset->ranking_nodes = Tensor::FromMmap(
-            _dataset_path + Constant::kCacheByDegreeHopFile, DataType::kI32,
-            {meta[Constant::kMetaNumNode]},
-            ctx_map[Constant::kCacheByDegreeHopFile], "dataset.ranking_nodes");
+        ranking_file = Constant::kCacheByDegreeHopFile;
         break;
       case kCacheByFakeOptimal:
-        _dataset->ranking_nodes = Tensor::FromMmap(
-            _dataset_path + Constant::kCacheByFakeOptimalFile, DataType::kI32,
-            {meta[Constant::kMetaNumNode]},
-            ctx_map[Constant::kCacheByFakeOptimalFile], "dataset.ranking_nodes");
+        ranking_file = Constant::kCacheByFakeOptimalFile;
         break;
       case kCacheByRandom:
-        _dataset->ranking_nodes = Tensor::FromMmap(
-            _dataset_path + Constant::kCacheByRandomFile, DataType::kI32,
-            {meta[Constant::kMetaNumNode]},
-            ctx_map[Constant::kCacheByRandomFile], "dataset.ranking_nodes");
+        ranking_file = Constant::kCacheByRandomFile;
         break;
       case kDynamicCache:
         break;
       default:
         CHECK(0);
     }
+    if (!ranking_file.empty()) {
+      loader.Add(&_dataset->ranking_nodes, _dataset_path + ranking_file,
+                 DataType::kI32, {meta[Constant::kMetaNumNode]},
+                 ctx_map[ranking_file], "dataset.ranking_nodes");
+    }
+  }
+
+  loader.Run();
+
+  if (use_feat_store) {
+    CHECK(_dataset->ranking_nodes && _dataset->ranking_nodes->Defined())
+        << "The host feature store needs a cache policy with a ranking file";
+    _dataset->feat_store = std::make_shared<cpu::CPUFeatureStore>(
+        _dataset_path + Constant::kFeatFile, feat_type,
+        meta[Constant::kMetaNumNode], meta[Constant::kMetaFeatDim],
+        static_cast<const IdType *>(_dataset->ranking_nodes->Data()),
+        meta[Constant::kMetaNumNode] * RunConfig::host_cache_percentage);
   }
 
   double loading_time = t.Passed();
   LOG(INFO) << "SamGraph loaded dataset(" << _dataset_path << ") successfully ("
             << loading_time << " secs)";
+  if (RunConfig::option_huge_page != kHugePageOff) {
+    ReportHugePageCoverage(*_dataset);
+  }
   LOG(DEBUG) << "dataset(" << _dataset_path << ") has "
              << _dataset->num_node << " nodes, "
              << _dataset->num_edge << " edges ";
@@ -17,49 +17,121 @@
 
 #include "graph_pool.h"
 
-#include <thread>
-
 #include "common.h"
 #include "constant.h"
 #include "logging.h"
+#include "profiler.h"
+#include "timer.h"
 
 namespace samgraph {
 namespace common {
 
-GraphPool::~GraphPool() { _stop = true; }
+namespace {
+
+// Time the calling producer waited for room since its last submit
+thread_local double submit_wait_time = 0;
+
+}  // namespace
+
+GraphPool::GraphPool(size_t max_size, bool ordered)
+    : _max_size(max_size),
+      _ordered(ordered),
+      _ring(max_size),
+      _num_reorder(0),
+      _next_key(0) {
+  CHECK_GT(max_size, 0);
+}
+
+GraphPool::~GraphPool() { Stop(); }
+
+void GraphPool::Drain() {
+  while (!_reorder.empty() && _reorder.begin()->first == _next_key) {
+    if (!_ring.TryPush(_reorder.begin()->second)) {
+      break;
+    }
+    _reorder.erase(_reorder.begin());
+    _num_reorder.fetch_sub(1);
+    _next_key++;
+  }
+}
 
 std::shared_ptr<GraphBatch> GraphPool::GetGraphBatch() {
+  Timer t;
+  std::shared_ptr<GraphBatch> batch;
+  size_t occupancy = 0;
   while (true) {
-    {
-      std::lock_guard<std::mutex> lock(_mutex);
-      if (!_pool.empty()) {
-        auto batch = _pool.front();
-        _pool.pop();
-        auto key = batch->key;
-        LOG(DEBUG) << "GraphPool: Get batch with key " << key;
-        return batch;
-      } else if (_stop) {
-        return nullptr;
-      }
+    occupancy = Size();
+    if (_ring.TryPop(batch)) {
+      break;
+    }
+    if (_not_empty.Stopped()) {
+      return nullptr;
     }
-    std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
+    _not_empty.Wait([this] { return Size() > 0; });
   }
 
-  return nullptr;
+  // pairs with the fence in Submit, either the producer sees the room or
+  // this consumer sees the waiting batch
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (_ordered && _num_reorder.load() > 0) {
+    std::lock_guard<std::mutex> lock(_reorder_mutex);
+    size_t before = _next_key;
+    Drain();
+    if (_next_key != before) {
+      _not_empty.Notify();
+    }
+  }
+  _not_full.Notify();
+
+  auto key = batch->key;
+  Profiler::Get().LogStep(key, kLogL2PoolGetWaitTime, t.Passed());
+  Profiler::Get().LogStep(key, kLogL2PoolOccupancy, occupancy);
+  LOG(DEBUG) << "GraphPool: Get batch with key " << key;
+  return batch;
 }
 
 void GraphPool::Submit(uint64_t key, std::shared_ptr<GraphBatch> batch) {
-  std::lock_guard<std::mutex> lock(_mutex);
-  CHECK(!_stop);
-  _pool.push(batch);
+  Timer t;
+  if (!_ordered) {
+    while (!_ring.TryPush(batch)) {
+      if (_not_full.Stopped()) {
+        return;
+      }
+      _not_full.Wait([this] { return !Full(); });
+    }
+  } else {
+    std::lock_guard<std::mutex> lock(_reorder_mutex);
+    CHECK_GE(key, _next_key);
+    _reorder[key] = batch;
+    _num_reorder.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Drain();
+  }
+  _not_empty.Notify();
 
+  Profiler::Get().LogStep(key, kLogL2PoolSubmitWaitTime,
+                          submit_wait_time + t.Passed());
+  submit_wait_time = 0;
   LOG(DEBUG) << "GraphPool: Add batch with key " << key;
 }
 
-bool GraphPool::Full() {
-  std::lock_guard<std::mutex> lock(_mutex);
-  return _pool.size() >= _max_size;
+bool GraphPool::Full() { return Size() >= _max_size; }
+
+bool GraphPool::WaitNotFull() {
+  if (Full()) {
+    Timer t;
+    _not_full.Wait([this] { return !Full(); });
+    submit_wait_time += t.Passed();
+  }
+  return !_not_full.Stopped();
 }
 
+void GraphPool::Stop() {
+  _not_empty.Stop();
+  _not_full.Stop();
+}
+
+size_t GraphPool::Size() { return _ring.Size(); }
+
 }  // namespace common
 }  // namespace samgraph
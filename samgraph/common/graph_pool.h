@@ -18,31 +18,59 @@
 #ifndef SAMGRAPH_GRAPH_POOL_H
 #define SAMGRAPH_GRAPH_POOL_H
 
+#include <atomic>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
-#include <queue>
 
 #include "common.h"
+#include "mpmc_queue.h"
 
 namespace samgraph {
 namespace common {
 
+// Bounded pool of the batches ready for training. The batches live in a
+// lock-free ring, the threads only take the mutex to sleep when the ring is
+// full or empty and to wake the sleeping ones.
+//
+// An ordered pool holds the batches submitted out of order until the
+// batches before them arrive, so they are got in key order starting from 0.
+// The producers of an ordered pool are serialized by the reorder stage.
 class GraphPool {
  public:
-  GraphPool(size_t max_size) : _stop(false), _max_size(max_size) {}
+  GraphPool(size_t max_size, bool ordered = false);
   ~GraphPool();
 
+  // Blocks until a batch is ready, nullptr once the pool is stopped
   std::shared_ptr<GraphBatch> GetGraphBatch();
+  // Blocks while the ring is full, the batch is dropped once the pool is
+  // stopped. An ordered pool never blocks here.
   void Submit(uint64_t key, std::shared_ptr<GraphBatch> batch);
+  // Only the batches ready to be got count, or the one missing batch could
+  // never be submitted
   bool Full();
+  // Blocks until the pool is not full, false if the pool is stopped
+  bool WaitNotFull();
+  // Wakes up every waiting thread, called when the engine shuts down
+  void Stop();
+  size_t Size();
 
  private:
-  bool _stop;
-  std::mutex _mutex;
+  // Moves the batches that are next in order from the reorder buffer to
+  // the ring, with _reorder_mutex held
+  void Drain();
+
   const size_t _max_size;
-  // std::unordered_map<uint64_t, std::shared_ptr<GraphBatch>> _pool;
-  std::queue<std::shared_ptr<GraphBatch>> _pool;
+  const bool _ordered;
+  MPMCQueue<std::shared_ptr<GraphBatch>> _ring;
+  WaitSet _not_empty;
+  WaitSet _not_full;
+
+  // Batches waiting for the earlier ones, ordered pool only
+  std::mutex _reorder_mutex;
+  std::map<uint64_t, std::shared_ptr<GraphBatch>> _reorder;
+  std::atomic<size_t> _num_reorder;
+  uint64_t _next_key;
 };
 
 }  // namespace common
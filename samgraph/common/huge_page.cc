@@ -0,0 +1,196 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "huge_page.h"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common.h"
+#include "logging.h"
+#include "run_config.h"
+
+namespace samgraph {
+namespace common {
+
+namespace {
+
+// The mappings of AllocHugePage and their sizes
+std::mutex huge_mutex;
+std::unordered_map<const void *, size_t> huge_blocks;
+std::atomic<size_t> num_huge_blocks(0);
+// Set once the hugetlbfs pool has no room, the later allocations go to the
+// transparent huge pages without trying it
+std::atomic<bool> hugetlb_exhausted(false);
+
+void *MapHugeTLB(size_t nbytes) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+  flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+  void *data = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return data == MAP_FAILED ? nullptr : data;
+}
+
+// Maps a huge page more and cuts the unaligned ends off
+void *MapAligned(size_t nbytes) {
+  size_t map_nbytes = nbytes + kHugePageSize;
+  void *map = mmap(nullptr, map_nbytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  CHECK(map != MAP_FAILED) << "mmap " << ToReadableSize(map_nbytes)
+                           << " failed: " << strerror(errno);
+  char *base = static_cast<char *>(map);
+  char *data = reinterpret_cast<char *>(
+      RoundUp<uintptr_t>(reinterpret_cast<uintptr_t>(base), kHugePageSize));
+  if (data != base) {
+    munmap(base, data - base);
+  }
+  size_t tail = (base + map_nbytes) - (data + nbytes);
+  if (tail > 0) {
+    munmap(data + nbytes, tail);
+  }
+  return data;
+}
+
+bool IsHugeField(const char *key) {
+  return strcmp(key, "AnonHugePages") == 0 ||
+         strcmp(key, "ShmemPmdMapped") == 0 ||
+         strcmp(key, "FilePmdMapped") == 0 ||
+         strcmp(key, "Shared_Hugetlb") == 0 ||
+         strcmp(key, "Private_Hugetlb") == 0;
+}
+
+}  // namespace
+
+bool UseHugePage(size_t nbytes) {
+  return RunConfig::option_huge_page != kHugePageOff &&
+         nbytes >= kHugePageSize;
+}
+
+void *AllocHugePage(size_t nbytes) {
+  nbytes = RoundUp(nbytes, kHugePageSize);
+  void *data = nullptr;
+  if (RunConfig::option_huge_page == kHugePageTLB &&
+      !hugetlb_exhausted.load(std::memory_order_relaxed)) {
+    data = MapHugeTLB(nbytes);
+    if (data == nullptr && !hugetlb_exhausted.exchange(true)) {
+      LOG(WARNING) << "The hugetlbfs pool has no room for "
+                   << ToReadableSize(nbytes)
+                   << ", falling back to transparent huge pages";
+    }
+  }
+  if (data == nullptr) {
+    data = MapAligned(nbytes);
+    // fails on the kernels without transparent huge pages, the coverage
+    // reports tell
+    madvise(data, nbytes, MADV_HUGEPAGE);
+  }
+
+  std::lock_guard<std::mutex> lock(huge_mutex);
+  huge_blocks[data] = nbytes;
+  num_huge_blocks.fetch_add(1);
+  return data;
+}
+
+bool FreeHugePage(void *data) {
+  if (num_huge_blocks.load() == 0) {
+    return false;
+  }
+  size_t nbytes;
+  {
+    std::lock_guard<std::mutex> lock(huge_mutex);
+    auto it = huge_blocks.find(data);
+    if (it == huge_blocks.end()) {
+      return false;
+    }
+    nbytes = it->second;
+    huge_blocks.erase(it);
+    num_huge_blocks.fetch_sub(1);
+  }
+  munmap(data, nbytes);
+  return true;
+}
+
+bool IsHugePage(const void *data) {
+  if (num_huge_blocks.load() == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(huge_mutex);
+  return huge_blocks.count(data) > 0;
+}
+
+void AdviseHugePage(void *data, size_t nbytes) {
+  if (RunConfig::option_huge_page == kHugePageOff) {
+    return;
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  uintptr_t lo = RoundUp<uintptr_t>(begin, kHugePageSize);
+  uintptr_t hi = (begin + nbytes) / kHugePageSize * kHugePageSize;
+  if (hi > lo) {
+    madvise(reinterpret_cast<void *>(lo), hi - lo, MADV_HUGEPAGE);
+  }
+}
+
+size_t HugePageCoverage(const void *data, size_t nbytes) {
+  const uintptr_t lo = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t hi = lo + nbytes;
+  std::ifstream smaps("/proc/self/smaps");
+  if (!smaps.is_open()) {
+    return 0;
+  }
+
+  double covered = 0;
+  unsigned long vma_lo = 0, vma_hi = 0;
+  std::string line;
+  while (std::getline(smaps, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    // "start-end perms offset dev inode path" starts a mapping, the fields
+    // of the mapping follow
+    char c = line[0];
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')) {
+      std::sscanf(line.c_str(), "%lx-%lx", &vma_lo, &vma_hi);
+      continue;
+    }
+    if (vma_hi <= lo || vma_lo >= hi) {
+      continue;
+    }
+    char key[64];
+    size_t kb;
+    if (std::sscanf(line.c_str(), "%63[^:]: %zu kB", key, &kb) != 2 ||
+        !IsHugeField(key)) {
+      continue;
+    }
+    // smaps only counts the huge pages of a whole mapping
+    uintptr_t overlap = Min<uintptr_t>(hi, vma_hi) - Max<uintptr_t>(lo, vma_lo);
+    covered += static_cast<double>(kb << 10) * overlap / (vma_hi - vma_lo);
+  }
+  return Min(static_cast<size_t>(covered), nbytes);
+}
+
+}  // namespace common
+}  // namespace samgraph
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_HUGE_PAGE_H
+#define SAMGRAPH_HUGE_PAGE_H
+
+#include <cstddef>
+
+namespace samgraph {
+namespace common {
+
+// Huge pages of x86_64 and aarch64 with 4KB base pages
+constexpr size_t kHugePageSize = 2 << 20;
+
+// The host buffers below kHugePageSize keep the base pages, the rest follow
+// RunConfig::option_huge_page:
+//   kHugePageOff    base pages only
+//   kHugePageAdvise transparent huge pages, madvise(MADV_HUGEPAGE)
+//   kHugePageTLB    the hugetlbfs pool, falling back to kHugePageAdvise once
+//                   the pool runs out
+bool UseHugePage(size_t nbytes);
+
+// Anonymous memory of RoundUp(nbytes, kHugePageSize) bytes aligned to
+// kHugePageSize, only called when UseHugePage(nbytes)
+void *AllocHugePage(size_t nbytes);
+// False if data is not from AllocHugePage
+bool FreeHugePage(void *data);
+bool IsHugePage(const void *data);
+
+// Asks for transparent huge pages on the whole huge pages inside the range,
+// a no-op when the huge pages are off
+void AdviseHugePage(void *data, size_t nbytes);
+
+// Bytes of the range on huge pages now, from /proc/self/smaps
+size_t HugePageCoverage(const void *data, size_t nbytes);
+
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_HUGE_PAGE_H
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_MPMC_QUEUE_H
+#define SAMGRAPH_MPMC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "common.h"
+
+namespace samgraph {
+namespace common {
+
+// Bounded lock-free queue for many producers and consumers. A cell is free
+// for the push at pos when its seq is pos, and holds the item for the pop
+// at pos when its seq is pos + 1, so the threads only contend on the CAS of
+// the position they move.
+template <typename T>
+class MPMCQueue {
+ public:
+  explicit MPMCQueue(size_t capacity)
+      // the seqs of a full and a free cell only differ with 2 cells or more
+      : _num_cell(Max<size_t>(capacity, 2)),
+        _cells(new Cell[_num_cell]),
+        _push_pos(0),
+        _pop_pos(0) {
+    for (size_t i = 0; i < _num_cell; i++) {
+      _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Moves from item on success, false if the queue is full
+  bool TryPush(T &item) { return TryPushN(&item, 1) == 1; }
+  // False if the queue is empty
+  bool TryPop(T &item) { return TryPopN(&item, 1) == 1; }
+
+  // Claims up to num consecutive cells with a single CAS and moves the
+  // items in order, returns how many were pushed
+  size_t TryPushN(T *items, size_t num) {
+    size_t pos = _push_pos.load(std::memory_order_relaxed);
+    size_t claimed = Claim(_push_pos, pos, num, 0);
+    for (size_t i = 0; i < claimed; i++) {
+      Cell &cell = _cells[(pos + i) % _num_cell];
+      cell.item = std::move(items[i]);
+      cell.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  size_t TryPopN(T *items, size_t num) {
+    size_t pos = _pop_pos.load(std::memory_order_relaxed);
+    size_t claimed = Claim(_pop_pos, pos, num, 1);
+    for (size_t i = 0; i < claimed; i++) {
+      Cell &cell = _cells[(pos + i) % _num_cell];
+      items[i] = std::move(cell.item);
+      cell.item = T();
+      cell.seq.store(pos + i + _num_cell, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  // Only a snapshot while the other threads are running
+  size_t Size() const {
+    size_t pop_pos = _pop_pos.load();
+    size_t push_pos = _push_pos.load();
+    return push_pos > pop_pos ? push_pos - pop_pos : 0;
+  }
+
+  size_t Capacity() const { return _num_cell; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T item;
+  };
+
+  // Moves target from pos over the longest run of ready cells, at most num.
+  // A cell at p is ready when its seq is p + lag. On return pos is the
+  // first claimed position.
+  size_t Claim(std::atomic<size_t> &target, size_t &pos, size_t num,
+               size_t lag) {
+    while (true) {
+      size_t run = 0;
+      intptr_t diff = 0;
+      while (run < num) {
+        size_t seq = _cells[(pos + run) % _num_cell].seq.load(
+            std::memory_order_acquire);
+        diff = static_cast<intptr_t>(seq) -
+               static_cast<intptr_t>(pos + run + lag);
+        if (diff != 0) {
+          break;
+        }
+        run++;
+      }
+
+      if (run == 0) {
+        // behind the other side, or another thread took pos already
+        if (diff < 0) {
+          return 0;
+        }
+        pos = target.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (target.compare_exchange_weak(pos, pos + run,
+                                       std::memory_order_relaxed)) {
+        return run;
+      }
+    }
+  }
+
+  const size_t _num_cell;
+  std::unique_ptr<Cell[]> _cells;
+  // the producers and the consumers spin on different cache lines
+  std::atomic<size_t> _push_pos;
+  size_t _padding0[7];
+  std::atomic<size_t> _pop_pos;
+  size_t _padding1[7];
+};
+
+// Lets the threads of a lock-free structure sleep until a condition holds.
+// The waiter is counted before it checks the condition and the notifier
+// checks the count after it changes the state, with full fences between,
+// so either the waiter sees the change or the notifier sees the waiter and
+// takes the mutex to wake it. Nobody touches the mutex while nobody waits.
+class WaitSet {
+ public:
+  WaitSet() : _num_waiter(0), _stop(false) {}
+
+  // Returns when ready() holds or the set is stopped
+  template <typename F>
+  void Wait(F ready) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _num_waiter.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _cv.wait(lock, [&] { return ready() || _stop.load(); });
+    _num_waiter.fetch_sub(1);
+  }
+
+  // Called after the state the waiters check has changed
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_num_waiter.load() > 0) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cv.notify_all();
+    }
+  }
+
+  // Wakes up every waiting thread for good
+  void Stop() {
+    _stop.store(true);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cv.notify_all();
+  }
+
+  bool Stopped() const { return _stop.load(); }
+
+ private:
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::atomic<size_t> _num_waiter;
+  std::atomic<bool> _stop;
+};
+
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_MPMC_QUEUE_H
@@ -21,6 +21,7 @@
 #include <cuda_runtime.h>
 
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -31,10 +32,13 @@
 #include "./dist/dist_engine.h"
 #include "common.h"
 #include "constant.h"
+#include "cpu/cpu_topology.h"
+#include "device.h"
 #include "engine.h"
 #include "logging.h"
 #include "profiler.h"
 #include "run_config.h"
+#include "task_arena.h"
 #include "timer.h"
 
 namespace samgraph {
@@ -163,6 +167,98 @@ void samgraph_config(const char **config_keys, const char **config_values,
     RunConfig::presample_epoch = 0;
   }
 
+  if (configs.count("seed") > 0) {
+    RunConfig::seed = std::stoull(configs["seed"]);
+  } else {
+    std::random_device rd;
+    RunConfig::seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+  }
+  LOG(INFO) << "Use random seed " << RunConfig::seed;
+
+  if (configs.count("sample_edge_weight") > 0) {
+    RunConfig::sample_edge_weight = std::stoi(configs["sample_edge_weight"]);
+    LOG(DEBUG) << "sample_edge_weight=" << RunConfig::sample_edge_weight;
+  }
+
+  if (configs.count("cpu_hash_type") > 0) {
+    RunConfig::cpu_hash_type =
+        static_cast<cpu::CPUHashType>(std::stoi(configs["cpu_hash_type"]));
+    LOG(DEBUG) << "cpu_hash_type=" << RunConfig::cpu_hash_type;
+  }
+
+  if (configs.count("cpu_fused_remap") > 0) {
+    RunConfig::cpu_fused_remap = std::stoi(configs["cpu_fused_remap"]);
+    LOG(DEBUG) << "cpu_fused_remap=" << RunConfig::cpu_fused_remap;
+  }
+
+  if (configs.count("cpu_num_sample_worker") > 0) {
+    RunConfig::cpu_num_sample_worker =
+        std::stoull(configs["cpu_num_sample_worker"]);
+    LOG(DEBUG) << "cpu_num_sample_worker="
+               << RunConfig::cpu_num_sample_worker;
+  }
+
+  if (configs.count("cpu_num_extract_worker") > 0) {
+    RunConfig::cpu_num_extract_worker =
+        std::stoull(configs["cpu_num_extract_worker"]);
+    LOG(DEBUG) << "cpu_num_extract_worker="
+               << RunConfig::cpu_num_extract_worker;
+  }
+
+  if (configs.count("cpu_sample_thread_num") > 0) {
+    RunConfig::cpu_sample_thread_num =
+        std::stoull(configs["cpu_sample_thread_num"]);
+    LOG(DEBUG) << "cpu_sample_thread_num="
+               << RunConfig::cpu_sample_thread_num;
+  }
+
+  if (configs.count("cpu_extract_thread_num") > 0) {
+    RunConfig::cpu_extract_thread_num =
+        std::stoull(configs["cpu_extract_thread_num"]);
+    LOG(DEBUG) << "cpu_extract_thread_num="
+               << RunConfig::cpu_extract_thread_num;
+  }
+
+  if (configs.count("cpu_pin_thread") > 0) {
+    // python passes True/False
+    const std::string &pin = configs["cpu_pin_thread"];
+    RunConfig::cpu_pin_thread = pin == "1" || pin == "True" || pin == "true";
+    LOG(DEBUG) << "cpu_pin_thread=" << RunConfig::cpu_pin_thread;
+  }
+
+  if (configs.count("cpu_ordered_batch") > 0) {
+    RunConfig::cpu_ordered_batch = std::stoi(configs["cpu_ordered_batch"]);
+    LOG(DEBUG) << "cpu_ordered_batch=" << RunConfig::cpu_ordered_batch;
+  }
+
+  if (configs.count("host_cache_percentage") > 0) {
+    RunConfig::host_cache_percentage =
+        std::stod(configs["host_cache_percentage"]);
+    LOG(DEBUG) << "host_cache_percentage="
+               << RunConfig::host_cache_percentage;
+  }
+
+  if (configs.count("host_cache_io_thread_num") > 0) {
+    RunConfig::host_cache_io_thread_num =
+        std::stoull(configs["host_cache_io_thread_num"]);
+    LOG(DEBUG) << "host_cache_io_thread_num="
+               << RunConfig::host_cache_io_thread_num;
+  }
+
+  if (RC::omp_thread_num <= 0) {
+    // the processes of the multi-gpu archs share the host
+    size_t num_process = 1;
+    if (RC::run_arch == kArch5 || RC::run_arch == kArch6) {
+      num_process = RC::num_train_worker;
+    } else if (RC::run_arch == kArch7) {
+      num_process = RC::num_worker;
+    }
+    const auto &topo = cpu::CPUTopology::Get();
+    RC::omp_thread_num = cpu::DefaultThreadNum(topo, num_process);
+    LOG(INFO) << "Use " << RC::omp_thread_num << " omp threads on "
+              << topo.ToString();
+  }
+
   RC::LoadConfigFromEnv();
   LOG(INFO) << "Use " << RunConfig::sample_type << " sampling algorithm";
   RC::is_configured = true;
@@ -308,6 +404,51 @@ void samgraph_report_node_access() {
   }
 }
 
+void samgraph_report_workspace() { Profiler::Get().ReportWorkspace(); }
+
+size_t samgraph_workspace_stat(int device_type, int device_id, int item) {
+  CHECK_LT(item, kNumWorkspaceStatItems);
+  Context ctx(static_cast<DeviceType>(device_type), device_id);
+  WorkspaceStats stats = Device::Get(ctx)->GetWorkspaceStats(ctx);
+  switch (item) {
+    case kWorkspaceInUse:
+      return stats.in_use;
+    case kWorkspaceCached:
+      return stats.cached;
+    case kWorkspacePeakInUse:
+      return stats.peak_in_use;
+    case kWorkspacePeakTotal:
+      return stats.peak_total;
+    case kWorkspaceNumAlloc:
+      return stats.num_alloc;
+    case kWorkspaceNumDeviceAlloc:
+      return stats.num_device_alloc;
+    case kWorkspaceNumTrim:
+      return stats.num_trim;
+    case kWorkspaceTrimmedBytes:
+      return stats.trimmed_bytes;
+    default:
+      CHECK(0);
+  }
+  return 0;
+}
+
+void samgraph_trim_workspace() {
+  // the slabs kept for the next batches are workspace in use
+  TaskArena::ReleaseCache();
+  std::vector<Context> ctxes = {CPU(CPU_CUDA_HOST_MALLOC_DEVICE),
+                                CPU(CPU_CLIB_MALLOC_DEVICE)};
+  if (Engine::Get() != nullptr) {
+    ctxes.push_back(Engine::Get()->GetSamplerCtx());
+    ctxes.push_back(Engine::Get()->GetTrainerCtx());
+  }
+  for (Context ctx : ctxes) {
+    if (ctx.device_type != kMMAP) {
+      Device::Get(ctx)->TrimWorkspace(ctx);
+    }
+  }
+}
+
 void samgraph_trace_step_begin(uint64_t key, int item, uint64_t us) {
   Profiler::Get().TraceStepBegin(key, static_cast<TraceItem>(item), us);
 }
@@ -75,6 +75,14 @@ void samgraph_report_epoch_average(uint64_t epoch);
 
 void samgraph_report_node_access();
 
+void samgraph_report_workspace();
+
+// item is a WorkspaceStatItem
+size_t samgraph_workspace_stat(int device_type, int device_id, int item);
+
+// Returns the cached workspace of the host and the engine devices
+void samgraph_trim_workspace();
+
 void samgraph_trace_step_begin(uint64_t key, int item, uint64_t ts);
 
 void samgraph_trace_step_end(uint64_t key, int item, uint64_t ts);
@@ -31,6 +31,7 @@
 
 #include "common.h"
 #include "constant.h"
+#include "device.h"
 #include "engine.h"
 #include "logging.h"
 #include "run_config.h"
@@ -447,6 +448,17 @@ void Profiler::OutputStep(uint64_t key, std::string type) {
         _step_buf[kLogL1NumNode],_step_buf[kLogL1NumSample]);
   }
 
+  // only the host feature store logs its hot and cold rows
+  double host_nodes =
+      _step_buf[kLogL1HostHotNodes] + _step_buf[kLogL1HostColdNodes];
+  if (level >= 1 && host_nodes > 0) {
+    printf(
+        "        L1  host hot nodes %10.0lf | cold nodes   %10.0lf | "
+        "hot rate %10s\n",
+        _step_buf[kLogL1HostHotNodes], _step_buf[kLogL1HostColdNodes],
+        ToPercentage(_step_buf[kLogL1HostHotNodes] / host_nodes).c_str());
+  }
+
   if (level >= 2 && !RunConfig::UseGPUCache()) {
     printf(
         "    [%s Profiler Level 2 E%u S%u]\n"
@@ -474,6 +486,24 @@ void Profiler::OutputStep(uint64_t key, std::string type) {
         _step_buf[kLogL2LastLayerTime], _step_buf[kLogL2LastLayerSize]);
   }
 
+  // the trainer waits for a batch, the producers wait for room
+  if (level >= 2) {
+    printf(
+        "        L2  pool get wait %.4lf | submit wait %.4lf | "
+        "occupancy %.0lf\n",
+        _step_buf[kLogL2PoolGetWaitTime], _step_buf[kLogL2PoolSubmitWaitTime],
+        _step_buf[kLogL2PoolOccupancy]);
+  }
+
+  // the arch0 pipeline, a task waits in its queues for a free worker
+  if (level >= 2 && RunConfig::run_arch == kArch0) {
+    printf(
+        "        L2  sample workers %zu | extract workers %zu | "
+        "queue wait %.4lf\n",
+        RunConfig::cpu_num_sample_worker, RunConfig::cpu_num_extract_worker,
+        _step_buf[kLogL2PipelineWaitTime]);
+  }
+
   if (level >= 3 && !RunConfig::UseGPUCache()) {
     printf(
         "     [%s Profiler Level 3 E%u S%u]\n"
@@ -554,6 +584,22 @@ void Profiler::OutputStep(uint64_t key, std::string type) {
         _step_buf[kLogL3CacheCombineMissTime],
         _step_buf[kLogL3CacheCombineCacheTime]);
   }
+
+  // only the CPU samplers log their per-thread time
+  if (level >= 3 && _step_buf[kLogL3SampleAvgThreadTime] > 0) {
+    printf(
+        "        L3  sample thread max %.4lf | sample thread avg %.4lf | "
+        "imbalance %.4lf\n",
+        _step_buf[kLogL3SampleMaxThreadTime],
+        _step_buf[kLogL3SampleAvgThreadTime],
+        _step_buf[kLogL3SampleMaxThreadTime] /
+            _step_buf[kLogL3SampleAvgThreadTime]);
+  }
+
+  if (level >= 3 && host_nodes > 0) {
+    printf("        L3  host cold read %.4lf\n",
+           _step_buf[kLogL3HostColdReadTime]);
+  }
 }
 
 void Profiler::OutputEpoch(uint64_t epoch, std::string type) {
@@ -661,9 +707,9 @@ void Profiler::ReportNodeAccess() {
       static_cast<double>(Engine::Get()->GetGraphDataset()->num_node);
 
   const IdType *in_degrees = static_cast<const IdType *>(
-      Engine::Get()->GetGraphDataset()->in_degrees->Data());
+      Engine::Get()->GetGraphDataset()->in_degrees.Get()->Data());
   const IdType *out_degrees = static_cast<const IdType *>(
-      Engine::Get()->GetGraphDataset()->out_degrees->Data());
+      Engine::Get()->GetGraphDataset()->out_degrees.Get()->Data());
   std::ofstream ofs0(Constant::kNodeAccessLogFile + GetTimeString() +
                          Constant::kNodeAccessFileSuffix,
                      std::ofstream::out | std::ofstream::trunc);
@@ -862,5 +908,45 @@ void Profiler::ReportPreSampleSimilarity() {
   ofs0.close();
 }
 
+void Profiler::ReportWorkspace() {
+  std::vector<Context> ctxes = {CPU(CPU_CUDA_HOST_MALLOC_DEVICE),
+                                CPU(CPU_CLIB_MALLOC_DEVICE)};
+  if (Engine::Get() != nullptr) {
+    for (Context ctx :
+         {Engine::Get()->GetSamplerCtx(), Engine::Get()->GetTrainerCtx()}) {
+      if (ctx.device_type == kGPU &&
+          std::find(ctxes.begin(), ctxes.end(), ctx) == ctxes.end()) {
+        ctxes.push_back(ctx);
+      }
+    }
+  }
+
+  for (Context ctx : ctxes) {
+    WorkspaceStats stats = Device::Get(ctx)->GetWorkspaceStats(ctx);
+    if (stats.num_alloc == 0) {
+      continue;
+    }
+    printf(
+        "    [Workspace %s:%d]\n"
+        "        in use  %10s | cached        %10s | peak in use %10s | "
+        "peak total %10s\n"
+        "        allocs  %10zu | device allocs %10zu | trims       %10zu | "
+        "trimmed    %10s\n",
+        ctx.device_type == kGPU ? "gpu" : "cpu", ctx.device_id,
+        ToReadableSize(stats.in_use).c_str(),
+        ToReadableSize(stats.cached).c_str(),
+        ToReadableSize(stats.peak_in_use).c_str(),
+        ToReadableSize(stats.peak_total).c_str(), stats.num_alloc,
+        stats.num_device_alloc, stats.num_trim,
+        ToReadableSize(stats.trimmed_bytes).c_str());
+    for (auto &site : stats.sites) {
+      printf("        site %-10s in use %10s | peak in use %10s | "
+             "allocs %10zu\n",
+             site.site.c_str(), ToReadableSize(site.in_use).c_str(),
+             ToReadableSize(site.peak_in_use).c_str(), site.num_alloc);
+    }
+  }
+}
+
 }  // namespace common
 }  // namespace samgraph
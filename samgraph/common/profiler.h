@@ -73,6 +73,8 @@ enum LogStepItem {
   kLogL1MissBytes,
   kLogL1PrefetchAdvanced,
   kLogL1GetNeighbourTime,
+  kLogL1HostHotNodes,
+  kLogL1HostColdNodes,
   // L2
   kLogL2ShuffleTime,
   kLogL2LastLayerTime,
@@ -84,6 +86,10 @@ enum LogStepItem {
   kLogL2ExtractTime,
   kLogL2FeatCopyTime,
   kLogL2CacheCopyTime,
+  kLogL2PipelineWaitTime,
+  kLogL2PoolGetWaitTime,
+  kLogL2PoolSubmitWaitTime,
+  kLogL2PoolOccupancy,
   // L3
   kLogL3KHopSampleCooTime,
   kLogL3KHopSampleSortCooTime,
@@ -112,6 +118,9 @@ enum LogStepItem {
   kLogL3CacheCopyMissTime,
   kLogL3CacheCombineMissTime,
   kLogL3CacheCombineCacheTime,
+  kLogL3SampleMaxThreadTime,
+  kLogL3SampleAvgThreadTime,
+  kLogL3HostColdReadTime,
   // Number of items
   kNumLogStepItems
 };
@@ -205,6 +214,8 @@ class Profiler {
   void ReportNodeAccessSimple();
 
   void ReportPreSampleSimilarity();
+  // Workspace accounting of the host and the engine devices
+  void ReportWorkspace();
 
   static Profiler &Get();
 
@@ -35,6 +35,8 @@ Context              RunConfig::sampler_ctx;
 Context              RunConfig::trainer_ctx;
 CachePolicy          RunConfig::cache_policy;
 double               RunConfig::cache_percentage               = 0.0f;
+double               RunConfig::host_cache_percentage          = 0.0f;
+size_t               RunConfig::host_cache_io_thread_num       = 8;
 
 size_t               RunConfig::max_sampling_jobs              = 10;
 size_t               RunConfig::max_copying_jobs               = 10;
@@ -48,8 +50,18 @@ size_t               RunConfig::num_layer;
 
 bool                 RunConfig::is_configured                  = false;
 
+uint64_t             RunConfig::seed                           = 0;
+
 // CPUHash2 now is the best parallel hash remapping
 cpu::CPUHashType     RunConfig::cpu_hash_type                  = cpu::kCPUHash2;
+bool                 RunConfig::sample_edge_weight             = false;
+bool                 RunConfig::cpu_fused_remap                = false;
+size_t               RunConfig::cpu_num_sample_worker          = 1;
+size_t               RunConfig::cpu_num_extract_worker         = 1;
+size_t               RunConfig::cpu_sample_thread_num          = 0;
+size_t               RunConfig::cpu_extract_thread_num         = 0;
+bool                 RunConfig::cpu_pin_thread                 = true;
+bool                 RunConfig::cpu_ordered_batch              = true;
 
 size_t               RunConfig::num_sample_worker;
 size_t               RunConfig::num_train_worker;
@@ -69,6 +81,11 @@ int                  RunConfig::barriered_epoch;
 int                  RunConfig::presample_epoch;
 bool                 RunConfig::option_dump_trace              = false;
 size_t               RunConfig::option_empty_feat              = 0;
+size_t               RunConfig::option_extract_prefetch        = 8;
+size_t               RunConfig::option_extract_stream_bytes    = 16 * 1024 * 1024;
+size_t               RunConfig::option_workspace_cache_limit   = 0;
+double               RunConfig::option_workspace_idle_trim     = 0;
+HugePageMode         RunConfig::option_huge_page               = kHugePageOff;
 
 int                  RunConfig::omp_thread_num                 = 40;
 
@@ -98,6 +115,28 @@ void RunConfig::LoadConfigFromEnv() {
   if (GetEnv(Constant::kEnvEmptyFeat) != "") {
     RunConfig::option_empty_feat = std::stoul(GetEnv(Constant::kEnvEmptyFeat));
   }
+  if (GetEnv(Constant::kEnvExtractPrefetch) != "") {
+    RunConfig::option_extract_prefetch =
+        std::stoul(GetEnv(Constant::kEnvExtractPrefetch));
+  }
+  if (GetEnv(Constant::kEnvExtractStreamBytes) != "") {
+    RunConfig::option_extract_stream_bytes =
+        std::stoul(GetEnv(Constant::kEnvExtractStreamBytes));
+  }
+  if (GetEnv(Constant::kEnvWorkspaceCacheLimit) != "") {
+    RunConfig::option_workspace_cache_limit =
+        std::stoul(GetEnv(Constant::kEnvWorkspaceCacheLimit));
+  }
+  if (GetEnv(Constant::kEnvWorkspaceIdleTrim) != "") {
+    RunConfig::option_workspace_idle_trim =
+        std::stod(GetEnv(Constant::kEnvWorkspaceIdleTrim));
+  }
+  if (GetEnv(Constant::kEnvHugePage) != "") {
+    int mode = std::stoi(GetEnv(Constant::kEnvHugePage));
+    CHECK(mode >= kHugePageOff && mode <= kHugePageTLB)
+        << "Unknown huge page mode " << mode;
+    RunConfig::option_huge_page = static_cast<HugePageMode>(mode);
+  }
 }
 
 
@@ -42,6 +42,11 @@ struct RunConfig {
   static Context              trainer_ctx;
   static CachePolicy          cache_policy;
   static double               cache_percentage;
+  // Rows of feat.bin kept in memory by the host feature store, the others
+  // are read from the file on demand. 0 maps the whole file instead.
+  static double               host_cache_percentage;
+  // Threads issuing the cold reads of the host feature store
+  static size_t               host_cache_io_thread_num;
 
   static size_t               max_sampling_jobs;
   static size_t               max_copying_jobs;
@@ -55,7 +60,27 @@ struct RunConfig {
 
   static bool                 is_configured;
 
+  // Seed of the CPU random generators
+  static uint64_t             seed;
+
   static cpu::CPUHashType     cpu_hash_type;
+  // Return the sampled edge weights in TrainGraph::data (CPU sampler)
+  static bool                 sample_edge_weight;
+  // Remap the sampled nodes while sampling instead of in separate passes
+  // (CPU sampler with CPUHashTable2)
+  static bool                 cpu_fused_remap;
+  // Stages of the arch0 pipeline: one shuffler, the sample workers with
+  // their own remap tables, the extract workers and one copier.
+  static size_t               cpu_num_sample_worker;
+  static size_t               cpu_num_extract_worker;
+  // Kernel threads of all the workers of a stage, 0 derives them from the
+  // cores of the machine
+  static size_t               cpu_sample_thread_num;
+  static size_t               cpu_extract_thread_num;
+  // Pin the stages of the arch0 pipeline to disjoint cores
+  static bool                 cpu_pin_thread;
+  // Hand the batches to the trainer in key order
+  static bool                 cpu_ordered_batch;
 
   // For multi-gpu sampling and training
   static size_t               num_sample_worker;
@@ -75,7 +100,20 @@ struct RunConfig {
   static int                  presample_epoch;
   static bool                 option_dump_trace;
   static size_t               option_empty_feat;
-
+  // Rows prefetched ahead by CPUExtract, 0 disables the prefetch
+  static size_t               option_extract_prefetch;
+  // CPUExtract bypasses the cache for outputs of at least this many bytes,
+  // 0 disables the non-temporal stores
+  static size_t               option_extract_stream_bytes;
+  // Cached workspace bytes of a device beyond which it is trimmed, and the
+  // seconds without allocations after which it is, 0 never trims
+  static size_t               option_workspace_cache_limit;
+  static double               option_workspace_idle_trim;
+  // 0 keeps the base pages, 1 asks for transparent huge pages and 2 takes
+  // them from hugetlbfs first, see huge_page.h
+  static HugePageMode         option_huge_page;
+
+  // 0 uses one thread per core, see cpu::DefaultThreadNum
   static int                  omp_thread_num;
 
   // shared memory meta_data path for data communication acrossing processes
@@ -86,6 +124,10 @@ struct RunConfig {
     return cache_percentage > 0 && run_arch != kArch1;
   }
 
+  static inline bool UseHostCache() {
+    return host_cache_percentage > 0;
+  }
+
   static inline bool UseDynamicGPUCache() {
     return cache_policy == kDynamicCache;
   }
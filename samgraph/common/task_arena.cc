@@ -0,0 +1,206 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "task_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#include "constant.h"
+#include "device.h"
+#include "huge_page.h"
+#include "logging.h"
+#include "workspace_pool.h"
+
+namespace samgraph {
+namespace common {
+
+namespace {
+
+constexpr size_t kMinSlabSize = 1 << 20;
+// Released slabs kept per context
+constexpr size_t kMaxCachedSlab = 4;
+
+// The released slabs of every context, and the size a new slab gets
+class SlabCache {
+ public:
+  static SlabCache &Get() {
+    static SlabCache cache;
+    return cache;
+  }
+
+  // A slab of at least nbytes, the first slab of a batch is sized after
+  // the batches before it
+  std::pair<char *, size_t> Take(Context ctx, size_t nbytes, bool first) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto &state = _state[Key(ctx)];
+      if (first) {
+        nbytes = Max(nbytes, state.slab_size);
+      }
+      auto &free = state.free;
+      for (size_t i = 0; i < free.size(); i++) {
+        if (free[i].second >= nbytes) {
+          auto slab = free[i];
+          free.erase(free.begin() + i);
+          return slab;
+        }
+      }
+    }
+    nbytes = RoundUp(Max(nbytes, kMinSlabSize), kMinSlabSize);
+    // the host slabs grow by whole huge pages once they are large enough
+    if (ctx.device_type == kCPU && UseHugePage(nbytes)) {
+      nbytes = RoundUp(nbytes, kHugePageSize);
+    }
+    WorkspaceSite site("task_arena");
+    void *data = Device::Get(ctx)->AllocWorkspace(ctx, nbytes,
+                                                  Constant::kAllocNoScale);
+    return {static_cast<char *>(data), nbytes};
+  }
+
+  void Release() {
+    std::vector<std::pair<Context, char *>> drop;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (auto &entry : _state) {
+        Context ctx(static_cast<DeviceType>(entry.first.first),
+                    entry.first.second);
+        for (auto &slab : entry.second.free) {
+          drop.push_back({ctx, slab.first});
+        }
+        entry.second.free.clear();
+      }
+    }
+    for (auto &slab : drop) {
+      Device::Get(slab.first)->FreeWorkspace(slab.first, slab.second);
+    }
+  }
+
+  // used is what the batch took in ctx from all its slabs
+  void Put(Context ctx, std::vector<std::pair<char *, size_t>> slabs,
+           size_t used) {
+    std::vector<std::pair<char *, size_t>> drop;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto &state = _state[Key(ctx)];
+      // some room for the batches that sample a few more nodes
+      state.slab_size =
+          Max(state.slab_size, RoundUp(used + used / 8, kMinSlabSize));
+      for (auto &slab : slabs) {
+        state.free.push_back(slab);
+      }
+      // the slabs too small for a whole batch go first, then the oldest
+      std::stable_partition(state.free.begin(), state.free.end(),
+                            [&](const std::pair<char *, size_t> &slab) {
+                              return slab.second < state.slab_size;
+                            });
+      while (state.free.size() > kMaxCachedSlab ||
+             (!state.free.empty() &&
+              state.free.front().second < state.slab_size)) {
+        drop.push_back(state.free.front());
+        state.free.erase(state.free.begin());
+      }
+    }
+    for (auto &slab : drop) {
+      Device::Get(ctx)->FreeWorkspace(ctx, slab.first);
+    }
+  }
+
+ private:
+  struct State {
+    size_t slab_size = kMinSlabSize;
+    std::vector<std::pair<char *, size_t>> free;
+  };
+
+  static std::pair<int, int> Key(Context ctx) {
+    return {static_cast<int>(ctx.device_type), ctx.device_id};
+  }
+
+  std::mutex _mutex;
+  std::map<std::pair<int, int>, State> _state;
+};
+
+}  // namespace
+
+TaskArena::~TaskArena() {
+  // give back the slabs of each context together
+  while (!_slabs.empty()) {
+    Context ctx = _slabs.front().ctx;
+    std::vector<std::pair<char *, size_t>> slabs;
+    size_t used = 0;
+    for (auto it = _slabs.begin(); it != _slabs.end();) {
+      if (it->ctx == ctx) {
+        slabs.push_back({it->data, it->size});
+        used += it->used;
+        it = _slabs.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    SlabCache::Get().Put(ctx, std::move(slabs), used);
+  }
+}
+
+void *TaskArena::Alloc(Context ctx, size_t nbytes) {
+  if (ctx.device_type == kMMAP) {
+    ctx = CPU(ctx.device_id);
+  }
+  nbytes = RoundUp(Max<size_t>(nbytes, 1), kAlignment);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  bool first = true;
+  // the newest slab of ctx is the only one with room left
+  for (auto it = _slabs.rbegin(); it != _slabs.rend(); ++it) {
+    if (it->ctx == ctx) {
+      first = false;
+      if (it->size - it->used >= nbytes) {
+        void *data = it->data + it->used;
+        it->used += nbytes;
+        return data;
+      }
+      break;
+    }
+  }
+
+  // the workspace is not always aligned as much as the arena, so the slab
+  // starts at the first aligned byte
+  auto slab = SlabCache::Get().Take(ctx, nbytes + kAlignment, first);
+  size_t pad =
+      RoundUp(reinterpret_cast<uintptr_t>(slab.first), kAlignment) -
+      reinterpret_cast<uintptr_t>(slab.first);
+  _slabs.push_back({ctx, slab.first, slab.second, pad + nbytes});
+  LOG(DEBUG) << "TaskArena: new slab of " << ToReadableSize(slab.second);
+  return slab.first + pad;
+}
+
+void TaskArena::ReleaseCache() { SlabCache::Get().Release(); }
+
+size_t TaskArena::UsedSize(Context ctx) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t used = 0;
+  for (auto &slab : _slabs) {
+    if (slab.ctx == ctx) {
+      used += slab.used;
+    }
+  }
+  return used;
+}
+
+}  // namespace common
+}  // namespace samgraph
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_TASK_ARENA_H
+#define SAMGRAPH_TASK_ARENA_H
+
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+
+namespace samgraph {
+namespace common {
+
+// Buffers of one batch, cut from a few large slabs instead of one workspace
+// allocation each. Nothing is freed until the arena goes, which is when the
+// batch is retired from the graph pool and its tensors are gone.
+//
+// The released slabs are kept for the next batches. Every context remembers
+// the most a batch used, so after the first batches a batch fits in one
+// slab per context.
+class TaskArena {
+ public:
+  static constexpr size_t kAlignment = 256;
+
+  TaskArena() = default;
+  ~TaskArena();
+
+  void *Alloc(Context ctx, size_t nbytes);
+  // Bytes handed out in ctx
+  size_t UsedSize(Context ctx);
+
+  // Frees the slabs kept for the next batches
+  static void ReleaseCache();
+
+ private:
+  struct Slab {
+    Context ctx;
+    char *data;
+    size_t size;
+    size_t used;
+  };
+
+  std::mutex _mutex;
+  std::vector<Slab> _slabs;
+};
+
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_TASK_ARENA_H
@@ -22,6 +22,7 @@
 #include "device.h"
 #include "memory_queue.h"
 #include "run_config.h"
+#include "thread_pool.h"
 #include "timer.h"
 
 namespace samgraph {
@@ -30,37 +31,80 @@ namespace common {
 namespace {
 // TODO: hardcode mq bucket size
 size_t mq_nbytes = 50 * 1024 * 1024;
+// bytes a chunk of the pool copies at least
+constexpr size_t kCopyGrain = 256 * 1024;
 } // namespace
 
-TaskQueue::TaskQueue(size_t max_len) { _max_len = max_len; }
+TaskQueue::TaskQueue(size_t max_len) : _q(max_len), _max_len(max_len) {}
 
 void TaskQueue::AddTask(std::shared_ptr<Task> task) {
-  std::lock_guard<std::mutex> lock(_mutex);
-  _q.push_back(task);
+  while (!_q.TryPush(task)) {
+    if (_not_full.Stopped()) {
+      return;
+    }
+    _not_full.Wait([this] { return _q.Size() < _q.Capacity(); });
+  }
+  _not_empty.Notify();
 }
 
-size_t TaskQueue::PendingLength() {
-  std::lock_guard<std::mutex> lock(_mutex);
-  return _q.size();
+void TaskQueue::AddTasks(std::vector<std::shared_ptr<Task>> &tasks) {
+  size_t num_pushed = 0;
+  while (num_pushed < tasks.size()) {
+    size_t num = _q.TryPushN(tasks.data() + num_pushed,
+                             tasks.size() - num_pushed);
+    num_pushed += num;
+    if (num > 0) {
+      _not_empty.Notify();
+    } else if (_not_full.Stopped()) {
+      break;
+    } else {
+      _not_full.Wait([this] { return _q.Size() < _q.Capacity(); });
+    }
+  }
+  tasks.clear();
 }
 
-bool TaskQueue::Full() {
-  std::lock_guard<std::mutex> lock(_mutex);
-  return _q.size() >= _max_len;
-}
+size_t TaskQueue::PendingLength() { return _q.Size(); }
+
+bool TaskQueue::Full() { return _q.Size() >= _max_len; }
 
 std::shared_ptr<Task> TaskQueue::GetTask() {
-  std::lock_guard<std::mutex> lock(_mutex);
   std::shared_ptr<Task> task;
-  for (auto it = _q.begin(); it != _q.end(); it++) {
-    task = *it;
-    _q.erase(it);
+  if (!_q.TryPop(task)) {
+    return nullptr;
+  }
+  _not_full.Notify();
+  return task;
+}
+
+std::shared_ptr<Task> TaskQueue::WaitTask() {
+  std::shared_ptr<Task> task;
+  while (!_q.TryPop(task)) {
+    if (_not_empty.Stopped()) {
+      return nullptr;
+    }
+    _not_empty.Wait([this] { return _q.Size() > 0; });
+  }
+  _not_full.Notify();
+  return task;
+}
 
-    return task;
+size_t TaskQueue::GetTasks(std::vector<std::shared_ptr<Task>> &tasks,
+                           size_t max_num) {
+  size_t old_size = tasks.size();
+  tasks.resize(old_size + max_num);
+  size_t num = _q.TryPopN(tasks.data() + old_size, max_num);
+  tasks.resize(old_size + num);
+  if (num > 0) {
+    _not_full.Notify();
   }
-  return nullptr;
+  return num;
 }
 
+void TaskQueue::Stop() {
+  _not_empty.Stop();
+  _not_full.Stop();
+}
 
 // for MessageTaskQueue
 namespace {
@@ -118,14 +162,9 @@ namespace {
   void CopyCPUToCPU(const void *from, void *to, size_t nbytes) {
     char *to_data = static_cast<char *>(to);
     const char *from_data = static_cast<const char *>(from);
-#pragma omp parallel for num_threads(RunConfig::omp_thread_num)
-    for (size_t i = 0; i < nbytes; i += 64) {
-      size_t len = std::min(i + 64, nbytes);
-#pragma omp simd
-      for (size_t j = i; j < len; ++j) {
-        to_data[j] = from_data[j];
-      }
-    }
+    ParallelFor(0, nbytes, kCopyGrain, [&](size_t begin, size_t end) {
+      memcpy(to_data + begin, from_data + begin, end - begin);
+    });
   }
 
   void CopyGPUToCPU(const TensorPtr &from, void *to) {
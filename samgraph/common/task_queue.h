@@ -19,28 +19,41 @@
 #define SAMGRAPH_TASK_QUEUE_H
 
 #include <memory>
-#include <mutex>
 #include <vector>
 
 #include "common.h"
 #include "memory_queue.h"
+#include "mpmc_queue.h"
 
 namespace samgraph {
 namespace common {
 
+// FIFO of the tasks between two stages on top of a lock-free ring of
+// max_len tasks. AddTask blocks while the ring is full, which is the
+// backpressure on the producer stage.
 class TaskQueue {
  public:
   TaskQueue(size_t max_len);
   virtual ~TaskQueue() {};
 
   void AddTask(std::shared_ptr<Task>);
+  // Adds the tasks in order and clears the vector
+  void AddTasks(std::vector<std::shared_ptr<Task>> &tasks);
+  // nullptr if the queue is empty
   std::shared_ptr<Task> GetTask();
+  // Blocks until a task arrives, nullptr once the queue is stopped
+  std::shared_ptr<Task> WaitTask();
+  // Appends up to max_num tasks to tasks without blocking, returns how many
+  size_t GetTasks(std::vector<std::shared_ptr<Task>> &tasks, size_t max_num);
   bool Full();
   size_t PendingLength();
+  // Wakes up every waiting thread, called when the engine shuts down
+  void Stop();
 
  private:
-  std::vector<std::shared_ptr<Task>> _q;
-  std::mutex _mutex;
+  MPMCQueue<std::shared_ptr<Task>> _q;
+  WaitSet _not_empty;
+  WaitSet _not_full;
   size_t _max_len;
 };
 
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+
+#include <chrono>
+#include <new>
+
+#include "cpu/cpu_topology.h"
+#include "logging.h"
+#include "run_config.h"
+
+namespace samgraph {
+namespace common {
+
+namespace {
+
+// The outside threads that call the pool share these deques
+constexpr size_t kNumOutsideDeque = 8;
+// Rounds an idle worker polls before it sleeps
+constexpr size_t kNumSpin = 64;
+
+std::atomic<size_t> next_generation(1);
+std::once_flag atfork_flag;
+
+// 0 means the whole pool
+thread_local size_t my_budget = 0;
+// The deque of the calling thread in the pool of my_generation
+thread_local size_t my_generation = 0;
+thread_local size_t my_deque = 0;
+
+}  // namespace
+
+std::atomic<ThreadPool *> ThreadPool::_pool(nullptr);
+std::mutex ThreadPool::_pool_mutex;
+
+void ThreadPool::Create(size_t num_thread,
+                        const std::vector<std::vector<int>> &worker_cpus) {
+  std::lock_guard<std::mutex> lock(_pool_mutex);
+  delete _pool.exchange(nullptr);
+  _pool.store(new ThreadPool(num_thread, worker_cpus));
+}
+
+void ThreadPool::Destroy() {
+  std::lock_guard<std::mutex> lock(_pool_mutex);
+  delete _pool.exchange(nullptr);
+}
+
+ThreadPool *ThreadPool::Get() {
+  ThreadPool *pool = _pool.load();
+  if (pool == nullptr) {
+    std::lock_guard<std::mutex> lock(_pool_mutex);
+    pool = _pool.load();
+    if (pool == nullptr) {
+      pool = new ThreadPool(RunConfig::omp_thread_num, {});
+      _pool.store(pool);
+    }
+  }
+  return pool;
+}
+
+void ThreadPool::ForgetInChild() {
+  // Only the forking thread is copied: the workers are gone and a deque or
+  // the pool mutex may be held by a thread that no longer exists
+  _pool.store(nullptr);
+  new (&_pool_mutex) std::mutex();
+}
+
+ThreadPool::ThreadPool(size_t num_thread,
+                       const std::vector<std::vector<int>> &worker_cpus)
+    : _num_worker(Max<size_t>(num_thread, 1) - 1),
+      _num_task(0),
+      _next_outside_deque(0),
+      _generation(next_generation.fetch_add(1)) {
+  std::call_once(atfork_flag, [] {
+    CHECK_EQ(pthread_atfork(nullptr, nullptr, ForgetInChild), 0);
+  });
+  for (size_t i = 0; i < _num_worker + kNumOutsideDeque; i++) {
+    _deques.emplace_back(new TaskDeque());
+  }
+  for (size_t i = 0; i < _num_worker; i++) {
+    std::vector<int> cpus;
+    if (i < worker_cpus.size()) {
+      cpus = worker_cpus[i];
+    }
+    _workers.emplace_back([this, i, cpus] { WorkerLoop(i, cpus); });
+  }
+  LOG(DEBUG) << "ThreadPool: started " << _num_worker << " workers";
+}
+
+ThreadPool::~ThreadPool() {
+  _has_task.Stop();
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::MyDeque() {
+  if (my_generation != _generation) {
+    my_generation = _generation;
+    my_deque = _num_worker + _next_outside_deque.fetch_add(1) %
+                                 kNumOutsideDeque;
+  }
+  return my_deque;
+}
+
+void ThreadPool::WorkerLoop(size_t worker_id, std::vector<int> cpus) {
+  cpu::PinThread(cpus);
+  my_generation = _generation;
+  my_deque = worker_id;
+
+  size_t num_idle = 0;
+  while (!_has_task.Stopped()) {
+    Task task;
+    if (GetTask(worker_id, task)) {
+      Execute(worker_id, task);
+      num_idle = 0;
+    } else if (++num_idle < kNumSpin) {
+      std::this_thread::yield();
+    } else if (_num_task.load() > 0) {
+      // the waiting tasks belong to jobs that used up their threads
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    } else {
+      _has_task.Wait([this] { return _num_task.load() > 0; });
+      num_idle = 0;
+    }
+  }
+}
+
+bool ThreadPool::GetTask(size_t deque_id, Task &task) {
+  {
+    TaskDeque &deque = *_deques[deque_id];
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (!deque.tasks.empty()) {
+      task = deque.tasks.back();
+      deque.tasks.pop_back();
+      _num_task.fetch_sub(1);
+      task.job->num_thread.fetch_add(1);
+      return true;
+    }
+  }
+
+  for (size_t k = 1; k < _deques.size(); k++) {
+    TaskDeque &deque = *_deques[(deque_id + k) % _deques.size()];
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (deque.tasks.empty()) {
+      continue;
+    }
+    Job *job = deque.tasks.front().job;
+    size_t num_thread = job->num_thread.load();
+    while (num_thread < job->max_thread &&
+           !job->num_thread.compare_exchange_weak(num_thread,
+                                                  num_thread + 1)) {
+    }
+    if (num_thread >= job->max_thread) {
+      continue;
+    }
+    task = deque.tasks.front();
+    deque.tasks.pop_front();
+    _num_task.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Execute(size_t deque_id, Task task) {
+  Job *job = task.job;
+  while (task.end - task.begin > 1) {
+    const size_t mid = task.begin + (task.end - task.begin) / 2;
+    {
+      TaskDeque &deque = *_deques[deque_id];
+      std::lock_guard<std::mutex> lock(deque.mutex);
+      deque.tasks.push_back({job, mid, task.end});
+    }
+    _num_task.fetch_add(1);
+    _has_task.Notify();
+    task.end = mid;
+  }
+
+  const size_t budget = my_budget;
+  my_budget = job->max_thread;
+  (*job->fn)(task.begin);
+  my_budget = budget;
+
+  // the caller may return as soon as the last part is done
+  job->num_thread.fetch_sub(1);
+  job->num_pending.fetch_sub(1, std::memory_order_release);
+}
+
+void ThreadPool::Run(size_t num_part, size_t max_thread,
+                     const std::function<void(size_t)> &fn) {
+  max_thread = Min(max_thread, NumThread());
+  if (num_part <= 1 || max_thread <= 1) {
+    for (size_t i = 0; i < num_part; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  Job job;
+  job.fn = &fn;
+  job.max_thread = max_thread;
+  job.num_thread.store(1);
+  job.num_pending.store(num_part);
+
+  const size_t deque_id = MyDeque();
+  Execute(deque_id, {&job, 0, num_part});
+  while (job.num_pending.load(std::memory_order_acquire) > 0) {
+    Task task;
+    if (GetTask(deque_id, task)) {
+      Execute(deque_id, task);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ParallelForOwnThreads(size_t begin, size_t end, size_t grain,
+                           size_t num_thread,
+                           const std::function<void(size_t, size_t)> &fn) {
+  if (end <= begin) {
+    return;
+  }
+  grain = Max<size_t>(grain, 1);
+  const size_t num_chunk = RoundUpDiv(end - begin, grain);
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    for (size_t i = next.fetch_add(1); i < num_chunk; i = next.fetch_add(1)) {
+      const size_t chunk_begin = begin + i * grain;
+      fn(chunk_begin, Min(chunk_begin + grain, end));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < Min(num_thread, num_chunk); i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+ThreadBudget::ThreadBudget(size_t num_thread) : _prev(my_budget) {
+  my_budget = Max<size_t>(num_thread, 1);
+}
+
+ThreadBudget::~ThreadBudget() { my_budget = _prev; }
+
+size_t ThreadBudget::Get() {
+  const size_t num_thread = ThreadPool::Get()->NumThread();
+  return my_budget ? Min(my_budget, num_thread) : num_thread;
+}
+
+}  // namespace common
+}  // namespace samgraph
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef SAMGRAPH_THREAD_POOL_H
+#define SAMGRAPH_THREAD_POOL_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "mpmc_queue.h"
+
+namespace samgraph {
+namespace common {
+
+// Work-stealing pool shared by the CPU kernels, so the pipeline stages that
+// run kernels at the same time split one set of threads instead of each
+// starting an omp team of omp_thread_num threads.
+//
+// A call is a range of parts. The thread that runs a range keeps halving it
+// and pushes the upper halves to the back of its own deque, the idle
+// threads steal from the front of the other deques, which hold the largest
+// ranges. The calling thread runs parts too while it waits, so a kernel can
+// call the pool again from inside a part without blocking a worker.
+class ThreadPool {
+ public:
+  // Replaces the shared pool with one of num_thread threads, the calling
+  // thread counted. Called by the engine before any kernel runs. Worker i
+  // is pinned to worker_cpus[i] if given.
+  static void Create(size_t num_thread,
+                     const std::vector<std::vector<int>> &worker_cpus = {});
+  static void Destroy();
+  // Creates a pool of omp_thread_num threads if there is none yet. A
+  // forked process starts without a pool: the workers of the parent are not
+  // copied, so its first call creates one.
+  static ThreadPool *Get();
+
+  size_t NumThread() const { return _num_worker + 1; }
+
+  // Runs fn(part) for every part in [0, num_part) on at most max_thread
+  // threads and returns when all parts are done
+  void Run(size_t num_part, size_t max_thread,
+           const std::function<void(size_t)> &fn);
+
+ private:
+  struct Job {
+    const std::function<void(size_t)> *fn;
+    size_t max_thread;
+    std::atomic<size_t> num_thread;
+    std::atomic<size_t> num_pending;
+  };
+
+  struct Task {
+    Job *job;
+    size_t begin;
+    size_t end;
+  };
+
+  struct TaskDeque {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    size_t _padding[8];
+  };
+
+  ThreadPool(size_t num_thread,
+             const std::vector<std::vector<int>> &worker_cpus);
+  ~ThreadPool();
+
+  // The child handler of pthread_atfork, leaks the pool of the parent
+  static void ForgetInChild();
+
+  void WorkerLoop(size_t worker_id, std::vector<int> cpus);
+  size_t MyDeque();
+  // Pops the newest task of the own deque, or steals the oldest one of
+  // another deque whose job still has room for one more thread
+  bool GetTask(size_t deque_id, Task &task);
+  // Runs the task, the job already counts the calling thread
+  void Execute(size_t deque_id, Task task);
+
+  const size_t _num_worker;
+  // the worker deques, then a few deques shared by the outside threads
+  std::vector<std::unique_ptr<TaskDeque>> _deques;
+  std::vector<std::thread> _workers;
+  std::atomic<size_t> _num_task;
+  std::atomic<size_t> _next_outside_deque;
+  const size_t _generation;
+  WaitSet _has_task;
+
+  static std::atomic<ThreadPool *> _pool;
+  static std::mutex _pool_mutex;
+};
+
+// Caps the threads of the pool calls made by the calling thread while the
+// budget lives, e.g. every sample worker of the arch0 pipeline takes its
+// share of the pool. The parts of a call inherit the budget of the caller.
+class ThreadBudget {
+ public:
+  explicit ThreadBudget(size_t num_thread);
+  ~ThreadBudget();
+
+  // The threads the calling thread may use
+  static size_t Get();
+
+ private:
+  size_t _prev;
+};
+
+namespace detail {
+
+constexpr size_t kChunkPerThread = 8;
+
+// Items of a chunk, the chunk count is derived from it again so that no
+// trailing chunk starts past the end
+inline size_t ChunkSize(size_t num_item, size_t grain) {
+  size_t max_chunk = kChunkPerThread * ThreadBudget::Get();
+  size_t num_chunk =
+      Min(RoundUpDiv(num_item, Max<size_t>(grain, 1)), max_chunk);
+  return RoundUpDiv(num_item, num_chunk);
+}
+
+}  // namespace detail
+
+// Calls fn(chunk_begin, chunk_end) for the chunks of [begin, end) on
+// num_thread threads that only live during the call, the calling thread
+// counted. For the work done before the dist engine forks its workers,
+// which must not start the pool in the parent.
+void ParallelForOwnThreads(size_t begin, size_t end, size_t grain,
+                           size_t num_thread,
+                           const std::function<void(size_t, size_t)> &fn);
+
+// Calls fn(chunk_begin, chunk_end) for the chunks of [begin, end), a chunk
+// has grain items or more
+template <typename F>
+void ParallelFor(size_t begin, size_t end, size_t grain, F fn) {
+  if (end <= begin) {
+    return;
+  }
+  const size_t chunk = detail::ChunkSize(end - begin, grain);
+  const size_t num_chunk = RoundUpDiv(end - begin, chunk);
+  ThreadPool::Get()->Run(num_chunk, ThreadBudget::Get(), [&](size_t i) {
+    const size_t chunk_begin = begin + i * chunk;
+    fn(chunk_begin, Min(chunk_begin + chunk, end));
+  });
+}
+
+// map(chunk_begin, chunk_end) returns the value of a chunk, the values are
+// folded with reduce in chunk order starting from identity
+template <typename T, typename MapF, typename ReduceF>
+T ParallelReduce(size_t begin, size_t end, size_t grain, T identity,
+                 MapF map, ReduceF reduce) {
+  if (end <= begin) {
+    return identity;
+  }
+  const size_t chunk = detail::ChunkSize(end - begin, grain);
+  const size_t num_chunk = RoundUpDiv(end - begin, chunk);
+  std::vector<T> partial(num_chunk, identity);
+  ThreadPool::Get()->Run(num_chunk, ThreadBudget::Get(), [&](size_t i) {
+    const size_t chunk_begin = begin + i * chunk;
+    partial[i] = map(chunk_begin, Min(chunk_begin + chunk, end));
+  });
+  T ret = identity;
+  for (size_t i = 0; i < num_chunk; i++) {
+    ret = reduce(std::move(ret), std::move(partial[i]));
+  }
+  return ret;
+}
+
+// Two passes over the same chunks: sum(chunk_begin, chunk_end) returns the
+// total of a chunk, then scan(chunk_begin, chunk_end, prefix) gets init
+// plus the totals of the chunks before it. Returns init plus all totals.
+template <typename T, typename SumF, typename ScanF>
+T ParallelScan(size_t begin, size_t end, size_t grain, T init, SumF sum,
+               ScanF scan) {
+  if (end <= begin) {
+    return init;
+  }
+  const size_t chunk = detail::ChunkSize(end - begin, grain);
+  const size_t num_chunk = RoundUpDiv(end - begin, chunk);
+  std::vector<T> prefix(num_chunk);
+  ThreadPool::Get()->Run(num_chunk, ThreadBudget::Get(), [&](size_t i) {
+    const size_t chunk_begin = begin + i * chunk;
+    prefix[i] = sum(chunk_begin, Min(chunk_begin + chunk, end));
+  });
+  T total = init;
+  for (size_t i = 0; i < num_chunk; i++) {
+    T tmp = prefix[i];
+    prefix[i] = total;
+    total = total + tmp;
+  }
+  ThreadPool::Get()->Run(num_chunk, ThreadBudget::Get(), [&](size_t i) {
+    const size_t chunk_begin = begin + i * chunk;
+    scan(chunk_begin, Min(chunk_begin + chunk, end), prefix[i]);
+  });
+  return total;
+}
+
+}  // namespace common
+}  // namespace samgraph
+
+#endif  // SAMGRAPH_THREAD_POOL_H
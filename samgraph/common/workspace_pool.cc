@@ -17,179 +17,606 @@
 
 #include "workspace_pool.h"
 
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "device.h"
+#include "huge_page.h"
 #include "logging.h"
+#include "mpmc_queue.h"
+#include "run_config.h"
 
 namespace samgraph {
 namespace common {
 
+namespace {
+
 // page size.
 constexpr size_t kWorkspacePageSize = 4 << 10;
+// The requests up to kMaxClassSize are rounded up to a power of two and the
+// blocks are cached, 4KB to 16MB
+constexpr int kNumSizeClass = 13;
+constexpr size_t kMaxClassSize = kWorkspacePageSize << (kNumSizeClass - 1);
+// Bytes of a size class cached by one thread and by the central pool, at
+// least one block. The blocks beyond go back to the device.
+constexpr size_t kThreadCacheSize = 8 << 20;
+constexpr size_t kCentralCacheSize = 64 << 20;
+// The larger blocks are cut from the free ones and merged again when freed,
+// the free memory beyond this is returned to the device a whole
+// allocation at a time
+constexpr size_t kMaxFreeLargeSize = 1ull << 30;
+constexpr size_t kNumShard = 64;
+// A pool over the cache limit is trimmed at most this often, the blocks in
+// the caches of the other threads only go when those threads run again
+constexpr int64_t kMinTrimInterval = 1000000000;
 
-class WorkspacePool::Pool {
- public:
-  Pool() {
-    // List gurad
-    Entry e;
-    e.data = nullptr;
-    e.size = 0;
+size_t ClassSize(int size_class) { return kWorkspacePageSize << size_class; }
+
+int SizeClass(size_t nbytes) {
+  int size_class = 0;
+  while (ClassSize(size_class) < nbytes) {
+    size_class++;
+  }
+  return size_class;
+}
+
+size_t ClassCacheNum(int size_class, size_t cache_size) {
+  return Max<size_t>(cache_size / ClassSize(size_class), 1);
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void UpdateMax(std::atomic<size_t> &max, size_t val) {
+  size_t old = max.load(std::memory_order_relaxed);
+  while (old < val && !max.compare_exchange_weak(old, val)) {
+  }
+}
+
+// Site 0 is every allocation outside a WorkspaceSite
+std::mutex site_mutex;
+const char *site_names[WorkspaceSite::kMaxSite] = {"other"};
+int num_site = 1;
+thread_local int current_site = 0;
+
+}  // namespace
 
-    _free_list.reserve(kListSize);
-    _allocated.reserve(kListSize);
+WorkspaceSite::WorkspaceSite(const char *name) : _prev(current_site) {
+  std::lock_guard<std::mutex> lock(site_mutex);
+  int site = 0;
+  for (int i = 0; i < num_site; i++) {
+    if (std::strcmp(site_names[i], name) == 0) {
+      site = i;
+      break;
+    }
+  }
+  if (site == 0 && num_site < kMaxSite) {
+    site = num_site++;
+    site_names[site] = name;
+  }
+  current_site = site;
+}
+
+WorkspaceSite::~WorkspaceSite() { current_site = _prev; }
+
+int WorkspaceSite::Current() { return current_site; }
+
+const char *WorkspaceSite::Name(int site) {
+  std::lock_guard<std::mutex> lock(site_mutex);
+  return site < num_site ? site_names[site] : nullptr;
+}
 
-    _free_list.push_back(e);
-    _allocated.push_back(e);
+// Allocations take the blocks of their size class from the cache of the
+// calling thread, then from the lock-free central pool of the class, and
+// only then from the device. Only the large blocks take a mutex.
+class WorkspacePool::Pool {
+ public:
+  Pool(Context ctx, Device *device, size_t cache_limit)
+      : _ctx(ctx),
+        _device(device),
+        _cache_limit(cache_limit),
+        _huge_page(ctx.device_type == kCPU &&
+                   RunConfig::option_huge_page != kHugePageOff) {
+    for (int i = 0; i < kNumSizeClass; i++) {
+      _central.emplace_back(new MPMCQueue<ClassBlock *>(
+          Max<size_t>(ClassCacheNum(i, kCentralCacheSize), 2)));
+    }
   }
 
   // allocate from pool
-  void *Alloc(Context ctx, Device *device, size_t nbytes, double scale) {
+  void *Alloc(size_t nbytes, double scale) {
+    const int site = WorkspaceSite::Current();
+    _num_alloc.fetch_add(1, std::memory_order_relaxed);
+
     // Allocate align to page.
-    std::lock_guard<std::mutex> lock(_mutex);
-    nbytes = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize *
-             kWorkspacePageSize;
+    nbytes = RoundUp(nbytes, kWorkspacePageSize);
     if (nbytes == 0) nbytes = kWorkspacePageSize;
+    if (nbytes > kMaxClassSize) {
+      return AllocLarge(nbytes, scale, site);
+    }
 
-    Entry e;
-    if (_free_list.size() == 1) {
-      nbytes *= scale;
-      e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment);
-      e.size = nbytes;
-    } else {
-      if (_free_list.back().size >= nbytes) {
-        // find smallest fit
-        auto it = _free_list.end() - 2;
-        for (; it->size >= nbytes; --it) {
-        }
-        e = *(it + 1);
-        if (e.size > 2 * nbytes) {
-          nbytes *= scale;
-          e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment);
-          e.size = nbytes;
-        } else {
-          _free_list.erase(it + 1);
-          _free_list_total_size -= e.size;
-        }
-      } else {
-        nbytes *= scale;
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment);
-        e.size = nbytes;
+    // the classes leave room to grow already, scale is not needed
+    const int size_class = SizeClass(nbytes);
+    const size_t size = ClassSize(size_class);
+    auto &blocks = MyCache().blocks[size_class];
+    ClassBlock *block = nullptr;
+    if (!blocks.empty()) {
+      block = blocks.back();
+      blocks.pop_back();
+    } else if (!_central[size_class]->TryPop(block)) {
+      block = new ClassBlock();
+      block->data = _device->AllocDataSpace(_ctx, size, kTempAllocaAlignment);
+      block->size_class = size_class;
+      Shard &shard = GetShard(block->data);
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.class_blocks[block->data] = block;
       }
+      _num_device_alloc.fetch_add(1, std::memory_order_relaxed);
+      UpdateMax(_peak_total, _total_size.fetch_add(size) + size);
     }
-    _allocated.push_back(e);
-    _allocated_total_size += e.size;
-    return e.data;
+    // the block is only ours until it is freed
+    block->site = site;
+    AddUsed(site, size);
+    return block->data;
   }
 
   // free resource back to pool
   void Free(void *data) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    Entry e;
-    if (_allocated.back().data == data) {
-      // quick path, last allocated.
-      e = _allocated.back();
-      _allocated.pop_back();
-    } else {
-      int index = static_cast<int>(_allocated.size()) - 2;
-      for (; index > 0 && _allocated[index].data != data; --index) {
+    ClassBlock *block = nullptr;
+    {
+      Shard &shard = GetShard(data);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.class_blocks.find(data);
+      if (it != shard.class_blocks.end()) {
+        block = it->second;
       }
-      CHECK_GT(index, 0) << "trying to free things that has not been allocated";
-      e = _allocated[index];
-      _allocated.erase(_allocated.begin() + index);
     }
-    _allocated_total_size -= e.size;
+    if (block == nullptr) {
+      FreeLarge(data);
+      CheckCacheLimit();
+      return;
+    }
 
-    if (_free_list.back().size < e.size) {
-      _free_list.push_back(e);
-    } else {
-      size_t i = _free_list.size() - 1;
-      _free_list.resize(_free_list.size() + 1);
-      for (; e.size < _free_list[i].size; --i) {
-        _free_list[i + 1] = _free_list[i];
+    const int size_class = block->size_class;
+    SubUsed(block->site, ClassSize(size_class));
+    auto &blocks = MyCache().blocks[size_class];
+    blocks.push_back(block);
+    if (blocks.size() > ClassCacheNum(size_class, kThreadCacheSize)) {
+      // keep half of them for the next allocations of this thread
+      size_t num_keep = blocks.size() / 2;
+      for (size_t i = num_keep; i < blocks.size(); i++) {
+        if (!_central[size_class]->TryPush(blocks[i])) {
+          ReleaseBlock(blocks[i]);
+        }
       }
-      _free_list[i + 1] = e;
+      blocks.resize(num_keep);
     }
-    _free_list_total_size += e.size;
+    CheckCacheLimit();
   }
 
-  // Release all resources
-  void Release(Context ctx, Device *device) {
-    CHECK_EQ(_allocated.size(), 1);
-    for (size_t i = 1; i < _free_list.size(); ++i) {
-      device->FreeDataSpace(ctx, _free_list[i].data);
+  // Returns the free blocks to the device. The ones cached by the threads
+  // go when their thread allocates or frees again.
+  void Trim() {
+    std::lock_guard<std::mutex> trim_lock(_trim_mutex);
+    _trim_epoch.fetch_add(1);
+    size_t trimmed = 0;
+    for (int i = 0; i < kNumSizeClass; i++) {
+      ClassBlock *block;
+      while (_central[i]->TryPop(block)) {
+        trimmed += ReleaseBlock(block);
+      }
     }
-    _free_list.clear();
-  }
-  size_t TotalSize() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _free_list_total_size + _allocated_total_size;
+    {
+      std::lock_guard<std::mutex> lock(_large_mutex);
+      for (auto it = _large_blocks.begin(); it != _large_blocks.end();) {
+        char *base = it->second.base;
+        size_t size = it->second.size;
+        if (it->second.free && it->first == base && size == _base_size[base]) {
+          RemoveFree(it);
+          _device->FreeDataSpace(_ctx, base);
+          _base_size.erase(base);
+          _total_size.fetch_sub(size);
+          trimmed += size;
+          it = _large_blocks.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    _num_trim.fetch_add(1);
+    _trimmed_bytes.fetch_add(trimmed);
+    _last_trim.store(NowNs());
+    LOG(DEBUG) << "WorkspacePool: trim " << ToReadableSize(trimmed)
+               << ", total " << ToReadableSize(_total_size.load());
   }
-  size_t FreeSize() {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _free_list_total_size;
+
+  size_t NumAlloc() { return _num_alloc.load(); }
+  size_t TotalSize() { return _total_size.load(); }
+  size_t FreeSize() { return _total_size.load() - _used_size.load(); }
+
+  WorkspaceStats Stats() {
+    WorkspaceStats stats;
+    stats.in_use = _used_size.load();
+    stats.cached = _total_size.load() - stats.in_use;
+    stats.peak_in_use = _peak_used.load();
+    stats.peak_total = _peak_total.load();
+    stats.num_alloc = _num_alloc.load();
+    stats.num_device_alloc = _num_device_alloc.load();
+    stats.num_trim = _num_trim.load();
+    stats.trimmed_bytes = _trimmed_bytes.load();
+    for (int i = 0; i < WorkspaceSite::kMaxSite; i++) {
+      const SiteCounter &counter = _sites[i];
+      if (counter.num_alloc.load() == 0) {
+        continue;
+      }
+      WorkspaceSiteStats site;
+      site.site = WorkspaceSite::Name(i);
+      site.in_use = counter.in_use.load();
+      site.peak_in_use = counter.peak_in_use.load();
+      site.num_alloc = counter.num_alloc.load();
+      stats.sites.push_back(site);
+    }
+    return stats;
   }
 
  private:
-  /*! \brief a single entry in the pool */
-  struct Entry {
+  // A cached block, the site is the one of its current allocation
+  struct ClassBlock {
     void *data;
+    int size_class;
+    int site;
+  };
+
+  // Blocks of every size class cached by a thread. They are handed to the
+  // central pools when the thread exits, the ones that do not fit stay
+  // allocated: the device may be gone already if the thread is the last one.
+  struct ThreadCache {
+    Pool *pool;
+    uint64_t trim_epoch;
+    std::vector<ClassBlock *> blocks[kNumSizeClass];
+
+    ~ThreadCache() {
+      for (int i = 0; i < kNumSizeClass; i++) {
+        for (ClassBlock *block : blocks[i]) {
+          pool->_central[i]->TryPush(block);
+        }
+      }
+    }
+  };
+
+  // The cached blocks by address, sharded
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<void *, ClassBlock *> class_blocks;
+  };
+
+  struct LargeBlock {
     size_t size;
+    // the device allocation the block was cut from
+    char *base;
+    bool free;
+    int site;
   };
 
-  std::vector<Entry> _free_list;
-  std::vector<Entry> _allocated;
-  size_t _free_list_total_size = 0, _allocated_total_size = 0;
-  std::mutex _mutex;
+  struct SiteCounter {
+    std::atomic<size_t> in_use{0};
+    std::atomic<size_t> peak_in_use{0};
+    std::atomic<size_t> num_alloc{0};
+  };
 
-  constexpr static size_t kListSize = 100;
+  ThreadCache &MyCache() {
+    auto &cache = _thread_caches[this];
+    if (cache == nullptr) {
+      cache.reset(new ThreadCache());
+      cache->pool = this;
+      cache->trim_epoch = _trim_epoch.load();
+    }
+    uint64_t trim_epoch = _trim_epoch.load(std::memory_order_relaxed);
+    if (cache->trim_epoch != trim_epoch) {
+      size_t trimmed = 0;
+      for (auto &blocks : cache->blocks) {
+        for (ClassBlock *block : blocks) {
+          trimmed += ReleaseBlock(block);
+        }
+        blocks.clear();
+      }
+      _trimmed_bytes.fetch_add(trimmed);
+      cache->trim_epoch = trim_epoch;
+    }
+    return *cache;
+  }
+
+  Shard &GetShard(void *data) {
+    return _shards[(reinterpret_cast<size_t>(data) / kWorkspacePageSize) %
+                   kNumShard];
+  }
+
+  void AddUsed(int site, size_t size) {
+    UpdateMax(_peak_used, _used_size.fetch_add(size) + size);
+    SiteCounter &counter = _sites[site];
+    counter.num_alloc.fetch_add(1, std::memory_order_relaxed);
+    UpdateMax(counter.peak_in_use, counter.in_use.fetch_add(size) + size);
+  }
+
+  void SubUsed(int site, size_t size) {
+    _used_size.fetch_sub(size);
+    _sites[site].in_use.fetch_sub(size);
+  }
+
+  void CheckCacheLimit() {
+    if (_cache_limit == 0 || FreeSize() <= _cache_limit ||
+        NowNs() - _last_trim.load() < kMinTrimInterval) {
+      return;
+    }
+    Trim();
+  }
+
+  size_t ReleaseBlock(ClassBlock *block) {
+    {
+      Shard &shard = GetShard(block->data);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.class_blocks.erase(block->data);
+    }
+    size_t size = ClassSize(block->size_class);
+    _device->FreeDataSpace(_ctx, block->data);
+    _total_size.fetch_sub(size);
+    delete block;
+    return size;
+  }
+
+  void *AllocLarge(size_t nbytes, double scale, int site) {
+    std::lock_guard<std::mutex> lock(_large_mutex);
+    // smallest fit
+    auto it = _large_free.lower_bound({nbytes, nullptr});
+    if (it == _large_free.end()) {
+      size_t size = Max(RoundUp(static_cast<size_t>(nbytes * scale),
+                                kWorkspacePageSize),
+                        nbytes);
+      // the slabs are whole huge pages, aligned by the device
+      if (_huge_page) {
+        size = RoundUp(size, kHugePageSize);
+      }
+      char *base = static_cast<char *>(
+          _device->AllocDataSpace(_ctx, size, kTempAllocaAlignment));
+      _base_size[base] = size;
+      _large_blocks[base] = {size, base, true, 0};
+      it = _large_free.insert({size, base}).first;
+      _large_free_size += size;
+      _num_device_alloc.fetch_add(1, std::memory_order_relaxed);
+      UpdateMax(_peak_total, _total_size.fetch_add(size) + size);
+    }
+
+    char *data = it->second;
+    _large_free.erase(it);
+    LargeBlock &block = _large_blocks[data];
+    _large_free_size -= block.size;
+    block.free = false;
+    block.site = site;
+    // the tail is only worth keeping apart if it is large itself
+    if (block.size - nbytes > kMaxClassSize) {
+      char *tail = data + nbytes;
+      size_t tail_size = block.size - nbytes;
+      _large_blocks[tail] = {tail_size, block.base, true, 0};
+      _large_free.insert({tail_size, tail});
+      _large_free_size += tail_size;
+      block.size = nbytes;
+    }
+    AddUsed(site, block.size);
+    return data;
+  }
+
+  void FreeLarge(void *data) {
+    std::lock_guard<std::mutex> lock(_large_mutex);
+    auto it = _large_blocks.find(static_cast<char *>(data));
+    CHECK(it != _large_blocks.end() && !it->second.free)
+        << "trying to free things that has not been allocated";
+    SubUsed(it->second.site, it->second.size);
+    it->second.free = true;
+
+    // merge with the free neighbours cut from the same allocation
+    auto next = std::next(it);
+    if (next != _large_blocks.end() && next->second.free &&
+        next->second.base == it->second.base) {
+      RemoveFree(next);
+      it->second.size += next->second.size;
+      _large_blocks.erase(next);
+    }
+    if (it != _large_blocks.begin()) {
+      auto prev = std::prev(it);
+      if (prev->second.free && prev->second.base == it->second.base) {
+        RemoveFree(prev);
+        prev->second.size += it->second.size;
+        _large_blocks.erase(it);
+        it = prev;
+      }
+    }
+
+    char *base = it->second.base;
+    size_t size = it->second.size;
+    if (it->first == base && size == _base_size[base] &&
+        _large_free_size + size > kMaxFreeLargeSize) {
+      _device->FreeDataSpace(_ctx, base);
+      _base_size.erase(base);
+      _large_blocks.erase(it);
+      _total_size.fetch_sub(size);
+      return;
+    }
+    _large_free.insert({size, it->first});
+    _large_free_size += size;
+  }
+
+  void RemoveFree(std::map<char *, LargeBlock>::iterator it) {
+    _large_free.erase({it->second.size, it->first});
+    _large_free_size -= it->second.size;
+  }
+
+  Context _ctx;
+  Device *_device;
+  const size_t _cache_limit;
+  // the host slabs are whole huge pages
+  const bool _huge_page;
+
+  std::vector<std::unique_ptr<MPMCQueue<ClassBlock *>>> _central;
+  Shard _shards[kNumShard];
+  static thread_local std::unordered_map<Pool *, std::unique_ptr<ThreadCache>>
+      _thread_caches;
+
+  std::mutex _large_mutex;
+  // every large block by address, and the free ones by size
+  std::map<char *, LargeBlock> _large_blocks;
+  std::set<std::pair<size_t, char *>> _large_free;
+  std::unordered_map<char *, size_t> _base_size;
+  size_t _large_free_size = 0;
+
+  // the thread caches are dropped when they see a new epoch
+  std::mutex _trim_mutex;
+  std::atomic<uint64_t> _trim_epoch{0};
+  std::atomic<int64_t> _last_trim{0};
+
+  std::atomic<size_t> _total_size{0};
+  std::atomic<size_t> _used_size{0};
+  std::atomic<size_t> _peak_total{0};
+  std::atomic<size_t> _peak_used{0};
+  std::atomic<size_t> _num_alloc{0};
+  std::atomic<size_t> _num_device_alloc{0};
+  std::atomic<size_t> _num_trim{0};
+  std::atomic<size_t> _trimmed_bytes{0};
+  SiteCounter _sites[WorkspaceSite::kMaxSite];
 };
 
+thread_local std::unordered_map<
+    WorkspacePool::Pool *, std::unique_ptr<WorkspacePool::Pool::ThreadCache>>
+    WorkspacePool::Pool::_thread_caches;
+
 WorkspacePool::WorkspacePool(DeviceType device_type,
                              std::shared_ptr<Device> device)
-    : _device_type(device_type), _device(device) {
-  std::fill(_array.begin(), _array.end(), nullptr);
+    : _device_type(device_type),
+      _device(device),
+      _cache_limit(RunConfig::option_workspace_cache_limit),
+      _idle_trim(RunConfig::option_workspace_idle_trim),
+      _trimmer_pid(getpid()),
+      _stop(false) {
+  for (auto &pool : _array) {
+    pool.store(nullptr);
+  }
+  if (_idle_trim > 0) {
+    _trimmer = std::thread([this] { TrimLoop(); });
+  }
 }
 
 WorkspacePool::~WorkspacePool() {
-  // for (size_t i = 0; i < _array.size(); ++i) {
-  //   if (_array[i] != nullptr) {
-  //     Context ctx;
-  //     ctx.device_type = _device_type;
-  //     ctx.device_id = static_cast<int>(i);
-  //     _array[i]->Release(ctx, _device.get());
-  //     delete _array[i];
-  //   }
-  // }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _stop_cv.notify_all();
+  if (_trimmer.joinable()) {
+    // a forked child has a copy of the thread but not the thread
+    if (getpid() == _trimmer_pid) {
+      _trimmer.join();
+    } else {
+      _trimmer.detach();
+    }
+  }
+  // The pools stay, the caches of the threads still running hand their
+  // blocks back to them when the threads exit. Trim returns the memory.
 }
 
-void *WorkspacePool::AllocWorkspace(Context ctx, size_t size, double scale) {
-  if (_array[ctx.device_id] != nullptr) {
-    return _array[ctx.device_id]->Alloc(ctx, _device.get(), size, scale);
+void WorkspacePool::TrimLoop() {
+  // a pool is idle once its allocation count stays the same for _idle_trim,
+  // the allocations do not read the clock
+  struct Activity {
+    size_t num_alloc = 0;
+    int64_t since = 0;
+    bool trimmed = true;
+  };
+  std::array<Activity, kMaxDevice> activity;
+  const int64_t idle_ns = static_cast<int64_t>(_idle_trim * 1e9);
+  auto period = std::chrono::duration<double>(Max(_idle_trim / 4, 0.05));
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_stop) {
+    _stop_cv.wait_for(lock, period);
+    if (_stop) {
+      break;
+    }
+    int64_t now = NowNs();
+    for (int i = 0; i < kMaxDevice; i++) {
+      Pool *pool = _array[i].load();
+      if (pool == nullptr) {
+        continue;
+      }
+      size_t num_alloc = pool->NumAlloc();
+      if (num_alloc != activity[i].num_alloc) {
+        activity[i] = {num_alloc, now, false};
+      } else if (!activity[i].trimmed && now - activity[i].since >= idle_ns) {
+        pool->Trim();
+        activity[i].trimmed = true;
+      }
+    }
+  }
+}
+
+WorkspacePool::Pool *WorkspacePool::GetPool(Context ctx) {
+  CHECK_LT(static_cast<size_t>(ctx.device_id), _array.size());
+  Pool *pool = _array[ctx.device_id].load();
+  if (pool != nullptr) {
+    return pool;
   }
 
   std::lock_guard<std::mutex> lock(_mutex);
-  if (_array[ctx.device_id] == nullptr) {
-    _array[ctx.device_id] = new Pool();
+  pool = _array[ctx.device_id].load();
+  if (pool == nullptr) {
+    pool = new Pool(ctx, _device.get(), _cache_limit);
+    _array[ctx.device_id].store(pool);
   }
+  return pool;
+}
 
-  return _array[ctx.device_id]->Alloc(ctx, _device.get(), size, scale);
+void *WorkspacePool::AllocWorkspace(Context ctx, size_t size, double scale) {
+  return GetPool(ctx)->Alloc(size, scale);
 }
 
 void WorkspacePool::FreeWorkspace(Context ctx, void *ptr) {
   CHECK(static_cast<size_t>(ctx.device_id) < _array.size() &&
-        _array[ctx.device_id] != nullptr);
-  _array[ctx.device_id]->Free(ptr);
+        _array[ctx.device_id].load() != nullptr);
+  _array[ctx.device_id].load()->Free(ptr);
 }
 
 size_t WorkspacePool::TotalSize(Context ctx) {
-  if (_array[ctx.device_id] == nullptr) return 0;
-  return _array[ctx.device_id]->TotalSize();
+  Pool *pool = _array[ctx.device_id].load();
+  if (pool == nullptr) return 0;
+  return pool->TotalSize();
 }
 size_t WorkspacePool::FreeSize(Context ctx) {
-  if (_array[ctx.device_id] == nullptr) return 0;
-  return _array[ctx.device_id]->FreeSize();
+  Pool *pool = _array[ctx.device_id].load();
+  if (pool == nullptr) return 0;
+  return pool->FreeSize();
+}
+
+WorkspaceStats WorkspacePool::Stats(Context ctx) {
+  Pool *pool = _array[ctx.device_id].load();
+  if (pool == nullptr) return {};
+  return pool->Stats();
+}
+
+void WorkspacePool::Trim(Context ctx) {
+  Pool *pool = _array[ctx.device_id].load();
+  if (pool != nullptr) {
+    pool->Trim();
+  }
 }
 
 }  // namespace common
@@ -19,8 +19,11 @@
 #define SAMGRAPH_WORKSPACE_POOL_H
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #include "common.h"
 #include "device.h"
@@ -28,6 +31,31 @@
 namespace samgraph {
 namespace common {
 
+// Names the workspace allocations of the calling thread while it is alive,
+// the pools account the bytes of every site apart. The name must outlive
+// the process, a literal.
+class WorkspaceSite {
+ public:
+  static constexpr int kMaxSite = 16;
+
+  explicit WorkspaceSite(const char* name);
+  ~WorkspaceSite();
+
+  static int Current();
+  static const char* Name(int site);
+
+ private:
+  int _prev;
+};
+
+// Caches the temporary buffers of a device, so a batch does not allocate
+// (and pin) its buffers from the device again. The buffers of up to 16MB
+// come from power-of-two size classes cached per thread, the larger ones
+// are cut from the free blocks. See workspace_pool.cc.
+//
+// The cached buffers go back to the device on Trim, when they exceed
+// RunConfig::option_workspace_cache_limit, or when no buffer was allocated
+// for RunConfig::option_workspace_idle_trim seconds.
 class WorkspacePool {
  public:
   WorkspacePool(DeviceType device_type, std::shared_ptr<Device> device);
@@ -37,15 +65,28 @@ class WorkspacePool {
   void FreeWorkspace(Context ctx, void* ptr);
   size_t TotalSize(Context ctx);
   size_t FreeSize(Context ctx);
+  WorkspaceStats Stats(Context ctx);
+  void Trim(Context ctx);
 
  private:
   static constexpr int kMaxDevice = 32;
 
   class Pool;
-  std::array<Pool*, kMaxDevice> _array;
+  Pool* GetPool(Context ctx);
+  void TrimLoop();
+
+  std::array<std::atomic<Pool*>, kMaxDevice> _array;
   DeviceType _device_type;
   std::shared_ptr<Device> _device;
   std::mutex _mutex;
+
+  size_t _cache_limit;
+  double _idle_trim;
+  // trims the idle pools, only if _idle_trim is set
+  std::thread _trimmer;
+  int _trimmer_pid;
+  bool _stop;
+  std::condition_variable _stop_cv;
 };
 
 }  // namespace common
@@ -45,6 +45,37 @@
 namespace samgraph {
 namespace torch {
 
+namespace {
+
+// torch has no uint16, the kU16 labels are read as int16 and masked back
+::torch::Dtype ToTorchType(common::DataType dtype) {
+  switch (dtype) {
+    case common::kF32:
+      return ::torch::kF32;
+    case common::kF64:
+      return ::torch::kF64;
+    case common::kF16:
+      return ::torch::kHalf;
+    case common::kBF16:
+      return ::torch::kBFloat16;
+    case common::kU8:
+      return ::torch::kByte;
+    case common::kI8:
+      return ::torch::kChar;
+    case common::kU16:
+      return ::torch::kI16;
+    case common::kI32:
+      return ::torch::kI32;
+    case common::kI64:
+      return ::torch::kI64;
+    default:
+      CHECK(false);
+  }
+  return ::torch::kF32;
+}
+
+}  // namespace
+
 ::torch::Tensor GetGraphFeature(uint64_t key) {
   auto graph_batch = common::Engine::Get()->GetGraphBatch();
   auto feat = graph_batch->input_feat;
@@ -57,9 +88,10 @@ namespace torch {
       feat->MutableData(),
       {(long long)feat->Shape()[0], (long long)feat->Shape()[1]},
       [feat](void* data) {},
-      ::torch::TensorOptions().dtype(::torch::kF32).device(device));
+      ::torch::TensorOptions().dtype(ToTorchType(feat->Type())).device(device));
 
-  return tensor;
+  // the compact features are widened on the trainer GPU
+  return tensor.to(::torch::kF32);
 }
 
 ::torch::Tensor GetGraphLabel(uint64_t key) {
@@ -72,9 +104,12 @@ namespace torch {
   ::torch::Tensor tensor = ::torch::from_blob(
       label->MutableData(), {(long long)label->Shape()[0]},
       [label](void* data) {},
-      ::torch::TensorOptions().dtype(::torch::kI64).device(device));
+      ::torch::TensorOptions().dtype(ToTorchType(label->Type())).device(device));
 
-  return tensor;
+  if (label->Type() == common::kU16) {
+    return tensor.to(::torch::kI32).bitwise_and(0xffff).to(::torch::kI64);
+  }
+  return tensor.to(::torch::kI64);
 }
 
 ::torch::Tensor GetGraphRow(uint64_t key, int layer_idx) {
@@ -112,15 +147,20 @@ namespace torch {
   auto device = "cuda:" + std::to_string(trainer_ctx.device_id);
 
   CHECK_EQ(key, graph_batch->key);
+  // random walk returns the visit counts, weighted khop the edge weights
+  auto dtype =
+      data->Type() == common::kF32 ? ::torch::kF32 : ::torch::kI32;
   ::torch::Tensor tensor = ::torch::from_blob(
       data->MutableData(), {(long long)data->Shape()[0]}, [data](void* ) {},
-      ::torch::TensorOptions().dtype(::torch::kI32).device(device));
+      ::torch::TensorOptions().dtype(dtype).device(device));
 
   return tensor;
 }
 
 ::torch::Tensor GetDatasetFeature() {
-  auto feat = common::Engine::Get()->GetGraphDataset()->feat;
+  auto dataset = common::Engine::Get()->GetGraphDataset();
+  auto feat = dataset->feat;
+  auto feat_scale = dataset->feat_scale;
 
   CHECK(feat->Ctx().device_type == common::kCPU ||
         feat->Ctx().device_type == common::kMMAP);
@@ -129,9 +169,18 @@ namespace torch {
       feat->MutableData(),
       {(long long)feat->Shape()[0], (long long)feat->Shape()[1]},
       [feat](void* data) {},
-      ::torch::TensorOptions().dtype(::torch::kF32).device("cpu"));
-
-  return tensor;
+      ::torch::TensorOptions().dtype(ToTorchType(feat->Type())).device("cpu"));
+
+  // the compact features are widened like those of a batch, the int8 rows
+  // are dequantized with their scales
+  if (feat_scale->Defined()) {
+    ::torch::Tensor scale = ::torch::from_blob(
+        feat_scale->MutableData(), {(long long)feat_scale->Shape()[0], 1},
+        [feat_scale](void* data) {},
+        ::torch::TensorOptions().dtype(::torch::kF32).device("cpu"));
+    return tensor.to(::torch::kF32).mul_(scale);
+  }
+  return tensor.to(::torch::kF32);
 }
 
 ::torch::Tensor GetDatasetLabel() {
@@ -143,9 +192,12 @@ namespace torch {
   ::torch::Tensor tensor = ::torch::from_blob(
       label->MutableData(), {(long long)label->Shape()[0]},
       [label](void* data) {},
-      ::torch::TensorOptions().dtype(::torch::kI64).device("cpu"));
+      ::torch::TensorOptions().dtype(ToTorchType(label->Type())).device("cpu"));
 
-  return tensor;
+  if (label->Type() == common::kU16) {
+    return tensor.to(::torch::kI32).bitwise_and(0xffff).to(::torch::kI64);
+  }
+  return tensor.to(::torch::kI64);
 }
 
 ::torch::Tensor GetGraphInputNodes(uint64_t key) {
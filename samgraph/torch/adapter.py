@@ -51,6 +51,9 @@ report_step_average  = _basics.report_step_average
 report_epoch         = _basics.report_epoch
 report_epoch_average = _basics.report_epoch_average
 report_node_access   = _basics.report_node_access
+report_workspace     = _basics.report_workspace
+workspace_stat       = _basics.workspace_stat
+trim_workspace       = _basics.trim_workspace
 trace_step_begin     = _basics.trace_step_begin
 trace_step_end       = _basics.trace_step_end
 trace_step_begin_now = _basics.trace_step_begin_now
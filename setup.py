@@ -72,32 +72,44 @@ setup(
             sources=[
                 'samgraph/common/common.cc',
                 'samgraph/common/constant.cc',
+                'samgraph/common/dataset_loader.cc',
                 'samgraph/common/device.cc',
                 'samgraph/common/engine.cc',
                 'samgraph/common/graph_pool.cc',
+                'samgraph/common/huge_page.cc',
                 'samgraph/common/logging.cc',
                 'samgraph/common/operation.cc',
                 'samgraph/common/profiler.cc',
                 'samgraph/common/run_config.cc',
+                'samgraph/common/task_arena.cc',
                 'samgraph/common/task_queue.cc',
+                'samgraph/common/thread_pool.cc',
                 'samgraph/common/workspace_pool.cc',
                 'samgraph/common/memory_queue.cc',
                 'samgraph/common/cpu/cpu_device.cc',
                 'samgraph/common/cpu/cpu_engine.cc',
                 'samgraph/common/cpu/cpu_extraction.cc',
+                'samgraph/common/cpu/cpu_feature_store.cc',
+                'samgraph/common/cpu/cpu_frequency_hashmap.cc',
                 'samgraph/common/cpu/cpu_hashtable0.cc',
                 'samgraph/common/cpu/cpu_hashtable1.cc',
                 'samgraph/common/cpu/cpu_hashtable2.cc',
+                'samgraph/common/cpu/cpu_hashtable3.cc',
+                'samgraph/common/cpu/cpu_hashtable4.cc',
+                'samgraph/common/cpu/cpu_hashtable5.cc',
                 'samgraph/common/cpu/cpu_loops_arch0.cc',
                 'samgraph/common/cpu/cpu_loops.cc',
-                'samgraph/common/cpu/cpu_random.cc',
+                'samgraph/common/cpu/cpu_sample_partition.cc',
                 'samgraph/common/cpu/cpu_sampling_khop0.cc',
                 'samgraph/common/cpu/cpu_sampling_khop1.cc',
                 'samgraph/common/cpu/cpu_sampling_khop2.cc',
+                'samgraph/common/cpu/cpu_sampling_khop3.cc',
                 'samgraph/common/cpu/cpu_sampling_random_walk.cc',
                 'samgraph/common/cpu/cpu_sampling_weighted_khop.cc',
+                'samgraph/common/cpu/cpu_sampling_weighted_khop_prefix.cc',
                 'samgraph/common/cpu/cpu_sanity_check.cc',
                 'samgraph/common/cpu/cpu_shuffler.cc',
+                'samgraph/common/cpu/cpu_topology.cc',
                 'samgraph/common/cpu/mmap_cpu_device.cc',
                 'samgraph/common/cuda/cuda_cache.cu',
                 'samgraph/common/cuda/cuda_cache_manager_device.cu',
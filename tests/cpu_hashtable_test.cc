@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/cpu/cpu_common.h"
+#include "samgraph/common/cpu/cpu_hashtable0.h"
+#include "samgraph/common/cpu/cpu_hashtable1.h"
+#include "samgraph/common/cpu/cpu_hashtable2.h"
+#include "samgraph/common/cpu/cpu_hashtable3.h"
+#include "samgraph/common/cpu/cpu_hashtable4.h"
+#include "samgraph/common/cpu/cpu_hashtable5.h"
+#include "samgraph/common/thread_pool.h"
+#include "test_common/common.h"
+#include "test_common/timer.h"
+
+using samgraph::common::IdType;
+using samgraph::common::ThreadPool;
+using namespace samgraph::common::cpu;
+
+namespace {
+
+constexpr size_t kNumNode = 20000000;
+constexpr size_t kBatchSize = 4000;
+constexpr size_t kNumBatch = 4;
+const std::vector<size_t> kFanout = {10, 10, 10};
+
+uint64_t Mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb3fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+// Half of the neighbours are close to the node, like a reordered graph
+IdType Neighbour(IdType node, size_t j) {
+  const uint64_t r = Mix(static_cast<uint64_t>(node) * 64 + j);
+  if (r & 1) {
+    return (node + (r >> 1) % 4096) % kNumNode;
+  }
+  return (r >> 1) % kNumNode;
+}
+
+std::unique_ptr<CPUHashTable> CreateTable(CPUHashType type) {
+  const size_t max_items = samgraph::common::Min(
+      samgraph::common::PredictNumNodes(kBatchSize, kFanout, kFanout.size()),
+      kNumNode);
+  switch (type) {
+    case kCPUHash0:
+      return std::unique_ptr<CPUHashTable>(new CPUHashTable0(kNumNode));
+    case kCPUHash1:
+      return std::unique_ptr<CPUHashTable>(new CPUHashTable1(kNumNode));
+    case kCPUHash2:
+      return std::unique_ptr<CPUHashTable>(new CPUHashTable2(kNumNode));
+    case kCPUHash3:
+      return std::unique_ptr<CPUHashTable>(new CPUHashTable3(max_items));
+    case kCPUHash4:
+      return std::unique_ptr<CPUHashTable>(
+          new CPUHashTable4(kNumNode, max_items));
+    default:
+      return std::unique_ptr<CPUHashTable>(new CPUHashTable5(max_items));
+  }
+}
+
+}  // namespace
+
+// Remap the layers of synthetic batches with every hashtable, and check
+// that the remapped edges point back to the sampled ones
+TEST(CPUHashTableTest, RemapBenchmark) {
+  ThreadPool::Create(std::thread::hardware_concurrency());
+  const std::vector<std::string> names = {"CPUHash0", "CPUHash1", "CPUHash2",
+                                          "CPUHash3", "CPUHash4", "CPUHash5"};
+  std::vector<size_t> num_unique(kCPUHash5 + 1, 0);
+
+  for (int type = kCPUHash0; type <= kCPUHash5; type++) {
+    auto table = CreateTable(static_cast<CPUHashType>(type));
+    double populate_time = 0;
+    double map_edges_time = 0;
+    double map_nodes_time = 0;
+
+    for (size_t b = 0; b < kNumBatch; b++) {
+      std::vector<IdType> input(kBatchSize);
+      for (size_t i = 0; i < kBatchSize; i++) {
+        input[i] = (b * kBatchSize + i) * 2477 % kNumNode;
+      }
+
+      table->Reset();
+      Timer t0;
+      table->Populate(input.data(), input.size());
+      populate_time += t0.Passed();
+
+      for (size_t fanout : kFanout) {
+        const size_t num_edge = input.size() * fanout;
+        std::vector<IdType> src(num_edge);
+        std::vector<IdType> dst(num_edge);
+        for (size_t k = 0; k < num_edge; k++) {
+          src[k] = input[k / fanout];
+          dst[k] = Neighbour(src[k], k % fanout);
+        }
+        std::vector<IdType> new_src(num_edge);
+        std::vector<IdType> new_dst(num_edge);
+
+        Timer t1;
+        table->Populate(dst.data(), num_edge);
+        populate_time += t1.Passed();
+
+        Timer t2;
+        table->MapEdges(src.data(), dst.data(), num_edge, new_src.data(),
+                        new_dst.data());
+        map_edges_time += t2.Passed();
+
+        std::vector<IdType> unique(table->NumItems());
+        Timer t3;
+        table->MapNodes(unique.data(), unique.size());
+        map_nodes_time += t3.Passed();
+
+        for (size_t k = 0; k < num_edge; k++) {
+          ASSERT_EQ(unique[new_src[k]], src[k]);
+          ASSERT_EQ(unique[new_dst[k]], dst[k]);
+        }
+        // the seeds keep their ids
+        for (size_t i = 0; i < input.size(); i++) {
+          ASSERT_EQ(unique[i], input[i]);
+        }
+        num_unique[type] += unique.size();
+        input.swap(unique);
+      }
+    }
+
+    LOG << names[type] << " populate: " << populate_time / kNumBatch
+        << " | map edges: " << map_edges_time / kNumBatch
+        << " | map nodes: " << map_nodes_time / kNumBatch << "\n";
+    EXPECT_EQ(num_unique[type], num_unique[kCPUHash0]);
+  }
+}
+
+// Apart from CPUHash0 and CPUHash1, the new ids only depend on the input
+TEST(CPUHashTableTest, ThreadIndependentIds) {
+  for (int type = kCPUHash2; type <= kCPUHash5; type++) {
+    std::vector<IdType> expected;
+    for (int num_threads : {1, 3, 8}) {
+      ThreadPool::Create(num_threads);
+      ASSERT_EQ(ThreadPool::Get()->NumThread(),
+                static_cast<size_t>(num_threads));
+      auto table = CreateTable(static_cast<CPUHashType>(type));
+      std::vector<IdType> input(kBatchSize);
+      for (size_t i = 0; i < kBatchSize; i++) {
+        input[i] = i * 2477 % kNumNode;
+      }
+      table->Populate(input.data(), input.size());
+
+      for (size_t fanout : kFanout) {
+        std::vector<IdType> dst(input.size() * fanout);
+        for (size_t k = 0; k < dst.size(); k++) {
+          dst[k] = Neighbour(input[k / fanout], k % fanout);
+        }
+        table->Populate(dst.data(), dst.size());
+        input.resize(table->NumItems());
+        table->MapNodes(input.data(), input.size());
+      }
+
+      if (expected.empty()) {
+        expected = input;
+      }
+      EXPECT_EQ(input, expected) << "type " << type << " with "
+                                 << num_threads << " threads";
+    }
+  }
+  ThreadPool::Destroy();
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "samgraph/common/cpu/cpu_topology.h"
+
+using samgraph::common::cpu::CPUPlacement;
+using samgraph::common::cpu::CPUTopology;
+using samgraph::common::cpu::DefaultThreadNum;
+using samgraph::common::cpu::PlanPlacement;
+
+namespace {
+
+constexpr int kNumSocket = 2;
+constexpr int kCorePerSocket = 4;
+constexpr int kNumCore = kNumSocket * kCorePerSocket;
+
+void MakeDir(const std::string &path) { mkdir(path.c_str(), 0755); }
+
+void WriteFile(const std::string &path, const std::string &content) {
+  std::ofstream f(path);
+  f << content << "\n";
+}
+
+// A sysfs tree of 2 sockets with 4 cores of 2 SMT threads each, numbered
+// like most x86 machines: cpu c and cpu c + 8 are siblings
+std::string MakeSysfs() {
+  char tmpl[] = "/tmp/samgraph_sysfs_XXXXXX";
+  std::string root = mkdtemp(tmpl);
+  MakeDir(root + "/cpu");
+  MakeDir(root + "/node");
+  WriteFile(root + "/cpu/online", "0-" + std::to_string(2 * kNumCore - 1));
+  for (int cpu = 0; cpu < 2 * kNumCore; cpu++) {
+    int core = cpu % kNumCore;
+    std::string dir = root + "/cpu/cpu" + std::to_string(cpu);
+    MakeDir(dir);
+    MakeDir(dir + "/topology");
+    WriteFile(dir + "/topology/physical_package_id",
+              std::to_string(core / kCorePerSocket));
+    WriteFile(dir + "/topology/core_id",
+              std::to_string(core % kCorePerSocket));
+  }
+  MakeDir(root + "/node/node0");
+  MakeDir(root + "/node/node1");
+  WriteFile(root + "/node/node0/cpulist", "0-3,8-11");
+  WriteFile(root + "/node/node1/cpulist", "4-7,12-15");
+  return root;
+}
+
+std::set<int> ToSet(const std::vector<int> &cpus) {
+  return std::set<int>(cpus.begin(), cpus.end());
+}
+
+bool Disjoint(const std::vector<int> &a, const std::vector<int> &b) {
+  std::set<int> sa = ToSet(a);
+  return std::none_of(b.begin(), b.end(),
+                      [&](int cpu) { return sa.count(cpu) > 0; });
+}
+
+}  // namespace
+
+TEST(CPUTopologyTest, Load) {
+  std::string root = MakeSysfs();
+  CPUTopology topo = CPUTopology::Load(root, {});
+  ASSERT_TRUE(topo.Known());
+  EXPECT_EQ(topo.NumSocket(), kNumSocket);
+  EXPECT_EQ(topo.NumCore(), kNumCore);
+  EXPECT_EQ(topo.NumCPU(), 2 * kNumCore);
+  for (int i = 0; i < kNumCore; i++) {
+    const auto &core = topo.Cores()[i];
+    EXPECT_EQ(core.socket, i / kCorePerSocket);
+    EXPECT_EQ(core.node, i / kCorePerSocket);
+    EXPECT_EQ(core.cpus, std::vector<int>({i, i + kNumCore}));
+  }
+  EXPECT_EQ(DefaultThreadNum(topo, 1), kNumCore);
+  EXPECT_EQ(DefaultThreadNum(topo, 2), kNumCore / 2);
+
+  // the cpus outside the affinity mask are dropped, a core keeps the
+  // siblings that are left
+  CPUTopology part = CPUTopology::Load(root, {0, 1, 8, 12});
+  EXPECT_EQ(part.NumCore(), 3);
+  EXPECT_EQ(part.NumCPU(), 4);
+  EXPECT_EQ(part.NumSocket(), 2);
+
+  CPUTopology missing = CPUTopology::Load(root + "/none", {2, 3});
+  EXPECT_FALSE(missing.Known());
+  EXPECT_EQ(missing.NumCore(), 2);
+  std::system(("rm -rf " + root).c_str());
+}
+
+TEST(CPUTopologyTest, Placement) {
+  std::string root = MakeSysfs();
+  CPUTopology topo = CPUTopology::Load(root, {});
+  std::system(("rm -rf " + root).c_str());
+
+  CPUPlacement plan = PlanPlacement(topo, kNumCore, true, 0, 0, true);
+  ASSERT_TRUE(plan.pin);
+  // one core copies, a quarter of the rest extracts
+  EXPECT_EQ(plan.extract_thread_num, 1);
+  EXPECT_EQ(plan.sample_thread_num, kNumCore - 2);
+  EXPECT_EQ(plan.sample_cpus.size(), 2 * plan.sample_thread_num);
+  EXPECT_TRUE(Disjoint(plan.sample_cpus, plan.extract_cpus));
+  EXPECT_TRUE(Disjoint(plan.sample_cpus, plan.copy_cpus));
+  EXPECT_TRUE(Disjoint(plan.extract_cpus, plan.copy_cpus));
+  // the samplers start on the first socket
+  EXPECT_EQ(ToSet(plan.sample_cpus).count(0), 1);
+  EXPECT_EQ(plan.pool_cpus.size(), kNumCore - 1);
+  for (const auto &cpus : plan.pool_cpus) {
+    EXPECT_TRUE(Disjoint(cpus, plan.copy_cpus));
+  }
+
+  // the given thread nums are kept
+  plan = PlanPlacement(topo, kNumCore, true, 3, 2, true);
+  EXPECT_EQ(plan.sample_thread_num, 3);
+  EXPECT_EQ(plan.extract_thread_num, 2);
+  EXPECT_EQ(plan.extract_cpus.size(), 4);
+  EXPECT_TRUE(Disjoint(plan.sample_cpus, plan.extract_cpus));
+
+  // no extract stage with the GPU cache
+  plan = PlanPlacement(topo, kNumCore, false, 0, 0, true);
+  EXPECT_EQ(plan.extract_thread_num, 0);
+  EXPECT_TRUE(plan.extract_cpus.empty());
+  EXPECT_EQ(plan.sample_thread_num, kNumCore - 1);
+
+  // a small pool stays on the first cores
+  plan = PlanPlacement(topo, 4, true, 0, 0, true);
+  EXPECT_EQ(plan.sample_thread_num + plan.extract_thread_num, 4);
+  EXPECT_EQ(plan.pool_cpus.size(), 3);
+
+  plan = PlanPlacement(topo, kNumCore, true, 0, 0, false);
+  EXPECT_FALSE(plan.pin);
+  EXPECT_TRUE(plan.sample_cpus.empty());
+  EXPECT_TRUE(plan.pool_cpus.empty());
+}
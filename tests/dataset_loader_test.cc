@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/dataset_loader.h"
+
+using samgraph::common::CPU;
+using samgraph::common::CPU_CLIB_MALLOC_DEVICE;
+using samgraph::common::DatasetLoader;
+using samgraph::common::LazyTensor;
+using samgraph::common::MMAP;
+using samgraph::common::Tensor;
+using samgraph::common::TensorPtr;
+using samgraph::common::kI32;
+using samgraph::common::kMMAP;
+
+namespace {
+
+// A file of num ints counting up from first, removed with the test
+class TempFile {
+ public:
+  TempFile(size_t num, int32_t first) : _path(NewPath()) {
+    std::vector<int32_t> data(num);
+    for (size_t i = 0; i < num; i++) {
+      data[i] = first + static_cast<int32_t>(i);
+    }
+    FILE *file = fopen(_path.c_str(), "wb");
+    fwrite(data.data(), sizeof(int32_t), num, file);
+    fclose(file);
+  }
+  ~TempFile() { unlink(_path.c_str()); }
+
+  const std::string &Path() const { return _path; }
+
+ private:
+  static std::string NewPath() {
+    static int num_file = 0;
+    return "/tmp/samgraph_loader_test_" + std::to_string(getpid()) + "_" +
+           std::to_string(num_file++) + ".bin";
+  }
+
+  std::string _path;
+};
+
+void ExpectCount(const TensorPtr &tensor, size_t num, int32_t first) {
+  ASSERT_TRUE(tensor && tensor->Defined());
+  ASSERT_EQ(tensor->Shape().front(), num);
+  const int32_t *data = static_cast<const int32_t *>(tensor->Data());
+  for (size_t i = 0; i < num; i++) {
+    if (data[i] != first + static_cast<int32_t>(i)) {
+      FAIL() << "wrong item " << i;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(DatasetLoaderTest, Files) {
+  // more than one chunk
+  const size_t large = (64 << 20) / sizeof(int32_t) + 1000;
+  TempFile a(large, 0), b(1000, 7), c(10, -5);
+  TensorPtr ta, tb, tc;
+  DatasetLoader loader(4);
+  loader.Add(&ta, a.Path(), kI32, {large}, CPU(CPU_CLIB_MALLOC_DEVICE), "a");
+  loader.Add(&tb, b.Path(), kI32, {1000}, MMAP(), "b");
+  loader.Add(&tc, c.Path(), kI32, {10}, CPU(CPU_CLIB_MALLOC_DEVICE), "c");
+  loader.Run();
+
+  ExpectCount(ta, large, 0);
+  ExpectCount(tb, 1000, 7);
+  ExpectCount(tc, 10, -5);
+  EXPECT_EQ(tb->Ctx().device_type, kMMAP);
+}
+
+TEST(DatasetLoaderTest, FromMmap) {
+  TempFile a(5000, 3);
+  ExpectCount(Tensor::FromMmap(a.Path(), kI32, {5000},
+                               CPU(CPU_CLIB_MALLOC_DEVICE), "a"),
+              5000, 3);
+  ExpectCount(Tensor::FromMmap(a.Path(), kI32, {5000}, MMAP(), "a"), 5000, 3);
+}
+
+TEST(DatasetLoaderTest, Lazy) {
+  LazyTensor empty;
+  EXPECT_FALSE(empty.Get()->Defined());
+
+  TempFile a(100, 1);
+  int num_load = 0;
+  LazyTensor lazy;
+  lazy.SetLoader([&]() {
+    num_load++;
+    return Tensor::FromMmap(a.Path(), kI32, {100}, MMAP(), "a");
+  });
+  EXPECT_EQ(num_load, 0);
+  ExpectCount(lazy.Get(), 100, 1);
+  ExpectCount(lazy.Get(), 100, 1);
+  EXPECT_EQ(num_load, 1);
+
+  lazy = Tensor::Null();
+  EXPECT_FALSE(lazy.Get()->Defined());
+}
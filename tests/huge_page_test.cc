@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/device.h"
+#include "samgraph/common/huge_page.h"
+#include "samgraph/common/run_config.h"
+
+using samgraph::common::AllocHugePage;
+using samgraph::common::Context;
+using samgraph::common::CPU;
+using samgraph::common::CPU_CLIB_MALLOC_DEVICE;
+using samgraph::common::Device;
+using samgraph::common::FreeHugePage;
+using samgraph::common::HugePageCoverage;
+using samgraph::common::HugePageMode;
+using samgraph::common::IsHugePage;
+using samgraph::common::RunConfig;
+using samgraph::common::UseHugePage;
+using samgraph::common::kHugePageAdvise;
+using samgraph::common::kHugePageOff;
+using samgraph::common::kHugePageSize;
+using samgraph::common::kHugePageTLB;
+
+namespace {
+
+constexpr size_t kMB = 1024 * 1024;
+
+// Sets the huge page mode for one test
+class HugePageScope {
+ public:
+  explicit HugePageScope(HugePageMode mode)
+      : _prev(RunConfig::option_huge_page) {
+    RunConfig::option_huge_page = mode;
+  }
+  ~HugePageScope() { RunConfig::option_huge_page = _prev; }
+
+ private:
+  HugePageMode _prev;
+};
+
+bool THPEnabled() {
+  std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string mode;
+  std::getline(file, mode);
+  return mode.find("[always]") != std::string::npos ||
+         mode.find("[madvise]") != std::string::npos;
+}
+
+}  // namespace
+
+TEST(HugePageTest, Off) {
+  HugePageScope scope(kHugePageOff);
+  EXPECT_FALSE(UseHugePage(64 * kMB));
+
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  void *data = Device::Get(ctx)->AllocDataSpace(ctx, 4 * kMB, 64);
+  EXPECT_FALSE(IsHugePage(data));
+  EXPECT_FALSE(FreeHugePage(data));
+  Device::Get(ctx)->FreeDataSpace(ctx, data);
+}
+
+TEST(HugePageTest, AllocFree) {
+  HugePageScope scope(kHugePageAdvise);
+  EXPECT_FALSE(UseHugePage(kHugePageSize - 1));
+  EXPECT_TRUE(UseHugePage(kHugePageSize));
+
+  char *data = static_cast<char *>(AllocHugePage(3 * kMB));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % kHugePageSize, 0);
+  EXPECT_TRUE(IsHugePage(data));
+  EXPECT_FALSE(IsHugePage(data + kHugePageSize));
+  // rounded up to whole huge pages
+  std::memset(data, 1, 2 * kHugePageSize);
+  EXPECT_TRUE(FreeHugePage(data));
+  EXPECT_FALSE(IsHugePage(data));
+}
+
+TEST(HugePageTest, Device) {
+  HugePageScope scope(kHugePageAdvise);
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  void *small = Device::Get(ctx)->AllocDataSpace(ctx, kMB, 64);
+  void *large = Device::Get(ctx)->AllocDataSpace(ctx, 5 * kMB, 64);
+  EXPECT_FALSE(IsHugePage(small));
+  EXPECT_TRUE(IsHugePage(large));
+  std::memset(large, 1, 5 * kMB);
+  Device::Get(ctx)->FreeDataSpace(ctx, small);
+  Device::Get(ctx)->FreeDataSpace(ctx, large);
+  EXPECT_FALSE(IsHugePage(large));
+}
+
+// Without a hugetlbfs pool the allocations fall back to THP
+TEST(HugePageTest, TLB) {
+  HugePageScope scope(kHugePageTLB);
+  for (int i = 0; i < 2; i++) {
+    char *data = static_cast<char *>(AllocHugePage(4 * kMB));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % kHugePageSize, 0);
+    std::memset(data, 1, 4 * kMB);
+    EXPECT_TRUE(FreeHugePage(data));
+  }
+}
+
+TEST(HugePageTest, Coverage) {
+  HugePageScope scope(kHugePageAdvise);
+  const size_t nbytes = 16 * kMB;
+
+  void *base = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(base, MAP_FAILED);
+  madvise(base, nbytes, MADV_NOHUGEPAGE);
+  std::memset(base, 1, nbytes);
+  EXPECT_EQ(HugePageCoverage(base, nbytes), 0);
+  munmap(base, nbytes);
+
+  char *data = static_cast<char *>(AllocHugePage(nbytes));
+  std::memset(data, 1, nbytes);
+  size_t covered = HugePageCoverage(data, nbytes);
+  EXPECT_LE(covered, nbytes);
+  if (THPEnabled()) {
+    EXPECT_GT(covered, 0);
+  }
+  // half of the range, half of the huge pages
+  EXPECT_LE(HugePageCoverage(data, nbytes / 2), nbytes / 2);
+  FreeHugePage(data);
+}
@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/mpmc_queue.h"
+#include "test_common/common.h"
+#include "test_common/timer.h"
+
+using samgraph::common::MPMCQueue;
+using samgraph::common::Task;
+using samgraph::common::TaskPtr;
+using samgraph::common::WaitSet;
+
+namespace {
+
+constexpr size_t kQueueLen = 64;
+constexpr size_t kNumTaskPerProducer = 20000;
+constexpr size_t kBatch = 8;
+const std::vector<size_t> kNumThreads = {1, 4, 16};
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// The queue TaskQueue used before, erasing from the front of a vector
+class MutexQueue {
+ public:
+  bool TryPush(TaskPtr &task) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_q.size() >= kQueueLen) {
+      return false;
+    }
+    _q.push_back(std::move(task));
+    return true;
+  }
+  bool TryPop(TaskPtr &task) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_q.empty()) {
+      return false;
+    }
+    task = std::move(_q.front());
+    _q.erase(_q.begin());
+    return true;
+  }
+
+ private:
+  std::mutex _mutex;
+  std::vector<TaskPtr> _q;
+};
+
+struct Result {
+  double avg_latency_us;
+  double throughput;
+};
+
+// Every producer sends tasks whose key is the send time, the consumers
+// check that each producer's tasks arrive in order and add up the latency
+template <typename Q, typename PushFn, typename PopFn>
+Result HandOff(Q &q, size_t num_thread, PushFn push, PopFn pop) {
+  const size_t total = num_thread * kNumTaskPerProducer;
+  std::atomic<size_t> num_recv(0);
+  std::atomic<uint64_t> sum_latency(0);
+  std::atomic<bool> in_order(true);
+
+  Timer t;
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < num_thread; p++) {
+    threads.emplace_back([&, p] {
+      for (size_t i = 0; i < kNumTaskPerProducer; i++) {
+        auto task = std::make_shared<Task>();
+        task->key = NowNs();
+        // the producer and its sequence number ride in the unused counters
+        task->miss_cache_index.num_miss = p;
+        task->miss_cache_index.num_cache = i;
+        push(q, task);
+      }
+    });
+  }
+  for (size_t c = 0; c < num_thread; c++) {
+    threads.emplace_back([&] {
+      std::vector<size_t> last(num_thread, 0);
+      std::vector<TaskPtr> tasks;
+      while (num_recv.load() < total) {
+        tasks.clear();
+        if (!pop(q, tasks)) {
+          std::this_thread::yield();
+          continue;
+        }
+        uint64_t now = NowNs();
+        for (auto &task : tasks) {
+          sum_latency.fetch_add(now - task->key);
+          size_t producer = task->miss_cache_index.num_miss;
+          size_t seq = task->miss_cache_index.num_cache + 1;
+          // a single consumer sees the tasks of a producer in order
+          if (num_thread == 1 && seq <= last[producer]) {
+            in_order.store(false);
+          }
+          last[producer] = seq;
+        }
+        num_recv.fetch_add(tasks.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = t.Passed();
+
+  EXPECT_EQ(num_recv.load(), total);
+  EXPECT_TRUE(in_order.load());
+  return {static_cast<double>(sum_latency.load()) / total / 1000,
+          total / seconds};
+}
+
+void Report(const char *name, size_t num_thread, Result r) {
+  LOG << name << " with " << num_thread << " producers and " << num_thread
+      << " consumers: latency " << r.avg_latency_us << " us, "
+      << r.throughput / 1e6 << " M tasks/s\n";
+}
+
+}  // namespace
+
+TEST(MPMCQueueTest, SingleThread) {
+  MPMCQueue<TaskPtr> q(4);
+  EXPECT_EQ(q.Capacity(), 4u);
+
+  for (uint64_t i = 0; i < 4; i++) {
+    auto task = std::make_shared<Task>();
+    task->key = i;
+    EXPECT_TRUE(q.TryPush(task));
+    EXPECT_EQ(task, nullptr);
+  }
+  auto extra = std::make_shared<Task>();
+  EXPECT_FALSE(q.TryPush(extra));
+  EXPECT_NE(extra, nullptr);
+  EXPECT_EQ(q.Size(), 4u);
+
+  std::vector<TaskPtr> tasks(8);
+  EXPECT_EQ(q.TryPopN(tasks.data(), 3), 3u);
+  for (uint64_t i = 0; i < 3; i++) {
+    EXPECT_EQ(tasks[i]->key, i);
+  }
+
+  // the batch push wraps around the end of the ring
+  for (uint64_t i = 0; i < 4; i++) {
+    tasks[i] = std::make_shared<Task>();
+    tasks[i]->key = 4 + i;
+  }
+  EXPECT_EQ(q.TryPushN(tasks.data(), 4), 3u);
+  EXPECT_NE(tasks[3], nullptr);
+
+  TaskPtr task;
+  for (uint64_t i = 3; i < 7; i++) {
+    EXPECT_TRUE(q.TryPop(task));
+    EXPECT_EQ(task->key, i);
+  }
+  EXPECT_FALSE(q.TryPop(task));
+  EXPECT_EQ(q.Size(), 0u);
+}
+
+// Sleeping consumers are woken up by the producers and by Stop()
+TEST(MPMCQueueTest, BlockingPop) {
+  MPMCQueue<TaskPtr> q(kQueueLen);
+  WaitSet not_empty;
+  std::atomic<size_t> num_recv(0);
+
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 4; c++) {
+    consumers.emplace_back([&] {
+      TaskPtr task;
+      while (true) {
+        if (q.TryPop(task)) {
+          num_recv.fetch_add(1);
+          continue;
+        }
+        if (not_empty.Stopped()) {
+          break;
+        }
+        not_empty.Wait([&] { return q.Size() > 0; });
+      }
+    });
+  }
+
+  for (size_t i = 0; i < kNumTaskPerProducer; i++) {
+    auto task = std::make_shared<Task>();
+    while (!q.TryPush(task)) {
+      std::this_thread::yield();
+    }
+    not_empty.Notify();
+  }
+  while (num_recv.load() < kNumTaskPerProducer) {
+    std::this_thread::yield();
+  }
+  not_empty.Stop();
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+  EXPECT_EQ(num_recv.load(), kNumTaskPerProducer);
+}
+
+// Hand-off latency of the lock-free ring against the mutex queue, with
+// single and batch pops
+TEST(MPMCQueueTest, HandOffBenchmark) {
+  auto spin_push = [](auto &q, TaskPtr &task) {
+    while (!q.TryPush(task)) {
+      std::this_thread::yield();
+    }
+  };
+  auto single_pop = [](auto &q, std::vector<TaskPtr> &tasks) {
+    TaskPtr task;
+    if (!q.TryPop(task)) {
+      return false;
+    }
+    tasks.push_back(std::move(task));
+    return true;
+  };
+  auto batch_pop = [](MPMCQueue<TaskPtr> &q, std::vector<TaskPtr> &tasks) {
+    tasks.resize(kBatch);
+    tasks.resize(q.TryPopN(tasks.data(), kBatch));
+    return !tasks.empty();
+  };
+
+  for (size_t num_thread : kNumThreads) {
+    MutexQueue mutex_q;
+    Report("mutex queue", num_thread,
+           HandOff(mutex_q, num_thread, spin_push, single_pop));
+
+    MPMCQueue<TaskPtr> ring(kQueueLen);
+    Report("mpmc ring", num_thread,
+           HandOff(ring, num_thread, spin_push, single_pop));
+
+    MPMCQueue<TaskPtr> batch_ring(kQueueLen);
+    Report("mpmc ring, batch pop", num_thread,
+           HandOff(batch_ring, num_thread, spin_push, batch_pop));
+  }
+}
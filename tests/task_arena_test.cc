@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/task_arena.h"
+
+using samgraph::common::Context;
+using samgraph::common::CPU;
+using samgraph::common::CPU_CLIB_MALLOC_DEVICE;
+using samgraph::common::TaskArena;
+using samgraph::common::Tensor;
+using samgraph::common::TensorName;
+using samgraph::common::TensorPtr;
+using samgraph::common::kI32;
+
+namespace {
+
+constexpr size_t kKB = 1024;
+constexpr size_t kMB = 1024 * 1024;
+
+}  // namespace
+
+TEST(TaskArenaTest, Alloc) {
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  auto arena = std::make_shared<TaskArena>();
+  char *a = static_cast<char *>(arena->Alloc(ctx, 100));
+  char *b = static_cast<char *>(arena->Alloc(ctx, 1000));
+  char *c = static_cast<char *>(arena->Alloc(ctx, 4 * kKB));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % TaskArena::kAlignment, 0);
+  EXPECT_EQ(b, a + TaskArena::kAlignment);
+  EXPECT_EQ(c, b + 1024);
+  // and the padding that aligns the slab
+  EXPECT_GE(arena->UsedSize(ctx), TaskArena::kAlignment + 1024 + 4 * kKB);
+  EXPECT_LT(arena->UsedSize(ctx), 2 * TaskArena::kAlignment + 1024 + 4 * kKB);
+  std::memset(a, 1, 100);
+  std::memset(b, 2, 1000);
+  std::memset(c, 3, 4 * kKB);
+
+  // larger than the slab
+  char *d = static_cast<char *>(arena->Alloc(ctx, 3 * kMB));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % TaskArena::kAlignment, 0);
+  std::memset(d, 4, 3 * kMB);
+  EXPECT_EQ(a[99], 1);
+  EXPECT_EQ(b[999], 2);
+  EXPECT_EQ(c[4 * kKB - 1], 3);
+}
+
+TEST(TaskArenaTest, Reuse) {
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  for (int round = 0; round < 3; round++) {
+    auto arena = std::make_shared<TaskArena>();
+    for (int i = 0; i < 64; i++) {
+      arena->Alloc(ctx, 100 * kKB);
+    }
+  }
+
+  // a batch of the same size now fits in the first slab
+  auto arena = std::make_shared<TaskArena>();
+  char *first = static_cast<char *>(arena->Alloc(ctx, 100 * kKB));
+  for (int i = 1; i < 64; i++) {
+    char *next = static_cast<char *>(arena->Alloc(ctx, 100 * kKB));
+    EXPECT_EQ(next, first + i * 100 * kKB);
+  }
+  void *slab = first;
+  arena = nullptr;
+
+  arena = std::make_shared<TaskArena>();
+  EXPECT_EQ(arena->Alloc(ctx, 100 * kKB), slab);
+}
+
+TEST(TaskArenaTest, TensorKeepsArena) {
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  auto arena = std::make_shared<TaskArena>();
+  TensorPtr tensor =
+      Tensor::Empty(kI32, {1024}, ctx, TensorName("arena_test_", 7, 1), arena);
+  int *data = static_cast<int *>(tensor->MutableData());
+  std::weak_ptr<TaskArena> weak = arena;
+  arena = nullptr;
+  EXPECT_FALSE(weak.expired());
+  for (int i = 0; i < 1024; i++) {
+    data[i] = i;
+  }
+  tensor = nullptr;
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(TaskArenaTest, TensorName) {
+  EXPECT_EQ(TensorName("task.input_feat_cpu_", 12).ToString(),
+            "task.input_feat_cpu_12");
+  EXPECT_EQ(TensorName("train_graph.row_cpu_sample_", 12, 2).ToString(),
+            "train_graph.row_cpu_sample_12_2");
+  EXPECT_EQ(TensorName(std::string("dataset.feat")).ToString(),
+            "dataset.feat");
+  EXPECT_EQ(TensorName().ToString(), "");
+}
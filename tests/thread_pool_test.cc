@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/thread_pool.h"
+#include "test_common/common.h"
+#include "test_common/timer.h"
+
+using samgraph::common::ParallelFor;
+using samgraph::common::ParallelForOwnThreads;
+using samgraph::common::ParallelReduce;
+using samgraph::common::ParallelScan;
+using samgraph::common::ThreadBudget;
+using samgraph::common::ThreadPool;
+
+namespace {
+
+constexpr size_t kNumThread = 8;
+constexpr size_t kNumItem = 1000003;
+
+}  // namespace
+
+TEST(ThreadPoolTest, ParallelFor) {
+  ThreadPool::Create(kNumThread);
+  std::vector<int> hit(kNumItem, 0);
+  ParallelFor(0, kNumItem, 1000, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      hit[i]++;
+    }
+  });
+  for (size_t i = 0; i < kNumItem; i++) {
+    ASSERT_EQ(hit[i], 1) << "item " << i;
+  }
+  ParallelFor(5, 5, 1, [&](size_t, size_t) { FAIL(); });
+}
+
+// Fewer items than the chunk limit of the budget, with grain 1
+TEST(ThreadPoolTest, SmallRange) {
+  ThreadPool::Create(1);
+  for (size_t num_item : {1, 7, 10, 13}) {
+    std::mutex mutex;
+    std::vector<int> hit(num_item, 0);
+    auto check = [&](size_t begin, size_t end) {
+      std::lock_guard<std::mutex> lock(mutex);
+      EXPECT_LE(begin, end);
+      EXPECT_LE(end, num_item);
+      for (size_t i = begin; i < end; i++) {
+        hit[i]++;
+      }
+    };
+    ParallelFor(0, num_item, 1, check);
+    ParallelReduce(
+        0, num_item, 1, 0,
+        [&](size_t begin, size_t end) {
+          check(begin, end);
+          return 0;
+        },
+        [](int a, int b) { return a + b; });
+    ParallelScan(
+        0, num_item, 1, 0, [](size_t, size_t) { return 0; },
+        [&](size_t begin, size_t end, int) { check(begin, end); });
+    for (size_t i = 0; i < num_item; i++) {
+      ASSERT_EQ(hit[i], 3) << "item " << i << " of " << num_item;
+    }
+  }
+}
+
+TEST(ThreadPoolTest, ReduceAndScan) {
+  ThreadPool::Create(kNumThread);
+  std::vector<size_t> data(kNumItem);
+  for (size_t i = 0; i < kNumItem; i++) {
+    data[i] = i % 7;
+  }
+
+  size_t sum = ParallelReduce(
+      0, kNumItem, 4096, size_t(0),
+      [&](size_t begin, size_t end) {
+        return std::accumulate(data.begin() + begin, data.begin() + end,
+                               size_t(0));
+      },
+      [](size_t a, size_t b) { return a + b; });
+  EXPECT_EQ(sum, std::accumulate(data.begin(), data.end(), size_t(0)));
+
+  std::vector<size_t> prefix(kNumItem);
+  size_t total = ParallelScan(
+      0, kNumItem, 4096, size_t(10),
+      [&](size_t begin, size_t end) {
+        return std::accumulate(data.begin() + begin, data.begin() + end,
+                               size_t(0));
+      },
+      [&](size_t begin, size_t end, size_t acc) {
+        for (size_t i = begin; i < end; i++) {
+          prefix[i] = acc;
+          acc += data[i];
+        }
+      });
+  EXPECT_EQ(total, sum + 10);
+  size_t expected = 10;
+  for (size_t i = 0; i < kNumItem; i++) {
+    ASSERT_EQ(prefix[i], expected) << "item " << i;
+    expected += data[i];
+  }
+}
+
+// Parts that call the pool again, from several outside threads at once
+TEST(ThreadPoolTest, NestedCalls) {
+  ThreadPool::Create(kNumThread);
+  std::atomic<size_t> count(0);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 4; c++) {
+    callers.emplace_back([&] {
+      for (int round = 0; round < 20; round++) {
+        ParallelFor(0, 64, 1, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; i++) {
+            ParallelFor(0, 100, 10, [&](size_t b, size_t e) {
+              count.fetch_add(e - b);
+            });
+          }
+        });
+      }
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(count.load(), 4u * 20 * 64 * 100);
+}
+
+// A stage with a budget never has more threads in its kernels
+TEST(ThreadPoolTest, Budget) {
+  ThreadPool::Create(kNumThread);
+  for (size_t budget : {1, 2, 3}) {
+    ThreadBudget scope(budget);
+    EXPECT_EQ(ThreadBudget::Get(), budget);
+    std::atomic<size_t> active(0);
+    std::atomic<size_t> max_active(0);
+    ParallelFor(0, 256, 1, [&](size_t, size_t) {
+      size_t now = active.fetch_add(1) + 1;
+      size_t seen = max_active.load();
+      while (now > seen && !max_active.compare_exchange_weak(seen, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      active.fetch_sub(1);
+    });
+    // the owner of a deque may take one of its tasks back while a thief
+    // still counts
+    EXPECT_LE(max_active.load(), budget + 1);
+    LOG << "budget " << budget << ": at most " << max_active.load()
+        << " threads\n";
+  }
+  EXPECT_EQ(ThreadBudget::Get(), ThreadPool::Get()->NumThread());
+}
+
+TEST(ThreadPoolTest, OwnThreads) {
+  std::vector<int> hit(kNumItem, 0);
+  ParallelForOwnThreads(0, kNumItem, 1000, kNumThread,
+                        [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      hit[i]++;
+    }
+  });
+  for (size_t i = 0; i < kNumItem; i++) {
+    ASSERT_EQ(hit[i], 1) << "item " << i;
+  }
+}
+
+// A forked child gets a pool of its own instead of the workers of the
+// parent, which were not copied
+TEST(ThreadPoolTest, Fork) {
+  ThreadPool::Create(kNumThread);
+  ParallelFor(0, 1024, 1, [](size_t, size_t) {});
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    ParallelFor(0, 64, 1, [&](size_t, size_t) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+    _exit(threads.size() > 1 ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(ThreadPoolTest, ForOverhead) {
+  ThreadPool::Create(kNumThread);
+  constexpr int kNumCall = 2000;
+  std::vector<float> data(1 << 16, 1.0f);
+  Timer t;
+  for (int c = 0; c < kNumCall; c++) {
+    ParallelFor(0, data.size(), 1024, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        data[i] = data[i] * 0.5f + 1.0f;
+      }
+    });
+  }
+  LOG << "ParallelFor over 64K floats: " << t.Passed() / kNumCall * 1e6
+      << " us per call\n";
+  ThreadPool::Destroy();
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "samgraph/common/common.h"
+#include "samgraph/common/cpu/cpu_device.h"
+#include "samgraph/common/run_config.h"
+#include "samgraph/common/workspace_pool.h"
+#include "test_common/common.h"
+#include "test_common/timer.h"
+
+using samgraph::common::Context;
+using samgraph::common::CPU;
+using samgraph::common::CPU_CLIB_MALLOC_DEVICE;
+using samgraph::common::RunConfig;
+using samgraph::common::WorkspacePool;
+using samgraph::common::WorkspaceSite;
+using samgraph::common::WorkspaceStats;
+using samgraph::common::kCPU;
+using samgraph::common::cpu::CPUDevice;
+
+namespace {
+
+constexpr size_t kKB = 1024;
+constexpr size_t kMB = 1024 * 1024;
+constexpr size_t kNumThread = 8;
+constexpr size_t kNumRound = 20000;
+
+std::unique_ptr<WorkspacePool> NewPool() {
+  return std::unique_ptr<WorkspacePool>(
+      new WorkspacePool(kCPU, CPUDevice::Global()));
+}
+
+}  // namespace
+
+TEST(WorkspacePoolTest, SizeClass) {
+  auto pool = NewPool();
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  void *a = pool->AllocWorkspace(ctx, 10 * kKB, 1);
+  EXPECT_EQ(pool->TotalSize(ctx), 16 * kKB);
+  EXPECT_EQ(pool->FreeSize(ctx), 0);
+  pool->FreeWorkspace(ctx, a);
+  EXPECT_EQ(pool->FreeSize(ctx), 16 * kKB);
+
+  // same class, the cached block comes back
+  void *b = pool->AllocWorkspace(ctx, 13 * kKB, 1);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(pool->TotalSize(ctx), 16 * kKB);
+  void *c = pool->AllocWorkspace(ctx, 13 * kKB, 1);
+  EXPECT_NE(b, c);
+  pool->FreeWorkspace(ctx, b);
+  pool->FreeWorkspace(ctx, c);
+  EXPECT_EQ(pool->FreeSize(ctx), pool->TotalSize(ctx));
+}
+
+TEST(WorkspacePoolTest, SplitAndMerge) {
+  auto pool = NewPool();
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  char *whole = static_cast<char *>(pool->AllocWorkspace(ctx, 256 * kMB, 1));
+  pool->FreeWorkspace(ctx, whole);
+  const size_t total = pool->TotalSize(ctx);
+  EXPECT_EQ(total, 256 * kMB);
+
+  // a smaller request is cut from the free block instead of allocating
+  char *a = static_cast<char *>(pool->AllocWorkspace(ctx, 64 * kMB, 1));
+  char *b = static_cast<char *>(pool->AllocWorkspace(ctx, 64 * kMB, 1));
+  EXPECT_EQ(a, whole);
+  EXPECT_EQ(b, whole + 64 * kMB);
+  EXPECT_EQ(pool->TotalSize(ctx), total);
+  EXPECT_EQ(pool->FreeSize(ctx), 128 * kMB);
+
+  // the pieces merge again
+  pool->FreeWorkspace(ctx, a);
+  pool->FreeWorkspace(ctx, b);
+  char *again = static_cast<char *>(pool->AllocWorkspace(ctx, 256 * kMB, 1));
+  EXPECT_EQ(again, whole);
+  EXPECT_EQ(pool->TotalSize(ctx), total);
+  pool->FreeWorkspace(ctx, again);
+}
+
+TEST(WorkspacePoolTest, ManyThreads) {
+  auto pool = NewPool();
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  std::vector<std::thread> threads;
+  std::vector<size_t> num_bad(kNumThread, 0);
+  Timer t;
+  for (size_t id = 0; id < kNumThread; id++) {
+    threads.emplace_back([&, id] {
+      std::mt19937 gen(id);
+      std::vector<std::pair<uint8_t *, size_t>> live;
+      for (size_t r = 0; r < kNumRound; r++) {
+        // mostly small buffers, some large ones
+        size_t size = gen() % 64 == 0 ? (gen() % 32 + 17) * kMB
+                                      : (gen() % 256 + 1) * kKB;
+        auto data = static_cast<uint8_t *>(pool->AllocWorkspace(ctx, size, 1));
+        data[0] = data[size - 1] = static_cast<uint8_t>(id);
+        live.push_back({data, size});
+        // frees some of them out of order, like the stages of a batch
+        while (live.size() > 4 || (gen() % 2 && !live.empty())) {
+          size_t i = gen() % live.size();
+          auto item = live[i];
+          if (item.first[0] != id || item.first[item.second - 1] != id) {
+            num_bad[id]++;
+          }
+          pool->FreeWorkspace(ctx, item.first);
+          live[i] = live.back();
+          live.pop_back();
+        }
+      }
+      for (auto item : live) {
+        pool->FreeWorkspace(ctx, item.first);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double time = t.Passed();
+
+  for (size_t id = 0; id < kNumThread; id++) {
+    EXPECT_EQ(num_bad[id], 0);
+  }
+  EXPECT_EQ(pool->FreeSize(ctx), pool->TotalSize(ctx));
+  // the caches are bounded, the memory does not grow with the rounds
+  EXPECT_LT(pool->TotalSize(ctx), 2048 * kMB);
+  printf("%zu threads: %.1f ns per alloc/free, %zu MB held\n", kNumThread,
+         time * 1e9 / (kNumThread * kNumRound), pool->TotalSize(ctx) / kMB);
+}
+
+TEST(WorkspacePoolTest, Stats) {
+  auto pool = NewPool();
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  void *a;
+  void *b;
+  {
+    WorkspaceSite site("test_a");
+    a = pool->AllocWorkspace(ctx, 10 * kKB, 1);
+  }
+  {
+    WorkspaceSite site("test_b");
+    b = pool->AllocWorkspace(ctx, 64 * kMB, 1);
+  }
+  // freed outside the sites, still counted to them
+  pool->FreeWorkspace(ctx, a);
+  void *c = pool->AllocWorkspace(ctx, 10 * kKB, 1);
+
+  WorkspaceStats stats = pool->Stats(ctx);
+  EXPECT_EQ(stats.in_use, 16 * kKB + 64 * kMB);
+  EXPECT_EQ(stats.cached, 0);
+  EXPECT_EQ(stats.peak_in_use, 16 * kKB + 64 * kMB);
+  EXPECT_EQ(stats.num_alloc, 3);
+  EXPECT_EQ(stats.num_device_alloc, 2);
+  ASSERT_EQ(stats.sites.size(), 3);
+  EXPECT_EQ(stats.sites[0].site, "other");
+  EXPECT_EQ(stats.sites[0].in_use, 16 * kKB);
+  EXPECT_EQ(stats.sites[1].site, "test_a");
+  EXPECT_EQ(stats.sites[1].in_use, 0);
+  EXPECT_EQ(stats.sites[1].peak_in_use, 16 * kKB);
+  EXPECT_EQ(stats.sites[2].site, "test_b");
+  EXPECT_EQ(stats.sites[2].in_use, 64 * kMB);
+
+  pool->FreeWorkspace(ctx, b);
+  pool->FreeWorkspace(ctx, c);
+  stats = pool->Stats(ctx);
+  EXPECT_EQ(stats.in_use, 0);
+  EXPECT_EQ(stats.cached, 16 * kKB + 64 * kMB);
+}
+
+TEST(WorkspacePoolTest, Trim) {
+  auto pool = NewPool();
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+  void *small = pool->AllocWorkspace(ctx, 10 * kKB, 1);
+  void *large = pool->AllocWorkspace(ctx, 64 * kMB, 1);
+  void *kept = pool->AllocWorkspace(ctx, 32 * kMB, 1);
+  pool->FreeWorkspace(ctx, small);
+  pool->FreeWorkspace(ctx, large);
+
+  // the large block goes at once, the cached one of this thread when it
+  // allocates again
+  pool->Trim(ctx);
+  EXPECT_EQ(pool->TotalSize(ctx), 16 * kKB + 32 * kMB);
+  void *again = pool->AllocWorkspace(ctx, 64 * kKB, 1);
+  EXPECT_EQ(pool->TotalSize(ctx), 64 * kKB + 32 * kMB);
+  WorkspaceStats stats = pool->Stats(ctx);
+  EXPECT_EQ(stats.num_trim, 1);
+  EXPECT_EQ(stats.trimmed_bytes, 16 * kKB + 64 * kMB);
+  EXPECT_EQ(stats.peak_total, 16 * kKB + 96 * kMB);
+  pool->FreeWorkspace(ctx, again);
+  pool->FreeWorkspace(ctx, kept);
+}
+
+TEST(WorkspacePoolTest, TrimPolicy) {
+  RunConfig::option_workspace_cache_limit = 48 * kMB;
+  RunConfig::option_workspace_idle_trim = 0.2;
+  auto pool = NewPool();
+  RunConfig::option_workspace_cache_limit = 0;
+  RunConfig::option_workspace_idle_trim = 0;
+  Context ctx = CPU(CPU_CLIB_MALLOC_DEVICE);
+
+  // over the limit
+  void *a = pool->AllocWorkspace(ctx, 32 * kMB, 1);
+  void *b = pool->AllocWorkspace(ctx, 32 * kMB, 1);
+  pool->FreeWorkspace(ctx, a);
+  EXPECT_EQ(pool->TotalSize(ctx), 64 * kMB);
+  pool->FreeWorkspace(ctx, b);
+  EXPECT_EQ(pool->TotalSize(ctx), 0);
+
+  // idle
+  void *c = pool->AllocWorkspace(ctx, 32 * kMB, 1);
+  pool->FreeWorkspace(ctx, c);
+  EXPECT_EQ(pool->TotalSize(ctx), 32 * kMB);
+  for (int i = 0; i < 50 && pool->TotalSize(ctx) > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_EQ(pool->TotalSize(ctx), 0);
+  EXPECT_EQ(pool->Stats(ctx).num_trim, 2);
+}
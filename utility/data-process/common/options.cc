@@ -27,6 +27,7 @@ std::string Options::root = "/graph-learning/samgraph/";
 std::string Options::graph = "papers100M";
 size_t Options::num_threads = 48;
 bool Options::is64type = false;
+uint64_t Options::seed = 0;
 CLI::App Options::_app;
 
 void Options::InitOptions(std::string app_name) {
@@ -43,6 +44,7 @@ void Options::InitOptions(std::string app_name) {
       }));
   _app.add_option("-t,--threads", num_threads);
   _app.add_flag("--64", is64type);
+  _app.add_option("--seed", seed);
 }
 
 void Options::Parse(int argc, char* argv[]) {
@@ -52,6 +54,7 @@ void Options::Parse(int argc, char* argv[]) {
   std::cout << "Graph: " << graph << std::endl;
   std::cout << "Threads: " << num_threads << std::endl;
   std::cout << "64 bit: " << is64type << std::endl;
+  std::cout << "Seed: " << seed << std::endl;
 }
 
 int Options::Exit(const CLI::ParseError& e) { return _app.exit(e); }
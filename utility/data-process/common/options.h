@@ -21,6 +21,7 @@
 #include <CLI/App.hpp>
 #include <CLI/Config.hpp>
 #include <CLI/Formatter.hpp>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 
@@ -43,6 +44,7 @@ class Options {
   static std::string graph;
   static bool is64type;
   static size_t num_threads;
+  static uint64_t seed;
 
  private:
   static CLI::App _app;
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/graph_loader.h"
+#include "common/options.h"
+#include "common/utils.h"
+
+namespace {
+
+// The numeric values of samgraph::common::DataType
+constexpr int kF32 = 0;
+constexpr int kF16 = 2;
+constexpr int kU8 = 3;
+constexpr int kI8 = 5;
+constexpr int kI64 = 6;
+constexpr int kBF16 = 7;
+constexpr int kU16 = 8;
+
+const std::string kFeatScaleFile = "feat_scale.bin";
+const std::string kMetaFeatType = "FEAT_TYPE";
+const std::string kMetaLabelType = "LABEL_TYPE";
+
+std::string feat_type = "fp32";
+std::string label_type = "u64";
+std::string output;
+
+uint32_t FloatBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+// Round to nearest even, nan stays a quiet nan
+uint16_t FloatToBF16(float f) {
+  uint32_t bits = FloatBits(f);
+  if (std::isnan(f)) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40);
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+// Round to nearest even, overflow goes to inf and tiny values to subnormals
+uint16_t FloatToF16(float f) {
+  const uint32_t bits = FloatBits(f);
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  const uint32_t abs = bits & 0x7fffffff;
+
+  if (abs >= 0x7f800000) {
+    return sign | (abs > 0x7f800000 ? 0x7e00 : 0x7c00);
+  }
+  // 65520 and above round to inf
+  if (abs >= 0x477ff000) {
+    return sign | 0x7c00;
+  }
+  // below 2^-14 the result is subnormal
+  if (abs < 0x38800000) {
+    // below half of the smallest subnormal
+    if (abs < 0x33000000) {
+      return sign;
+    }
+    const uint32_t exp = abs >> 23;
+    const uint32_t mant = (abs & 0x7fffff) | 0x800000;
+    const uint32_t shift = 126 - exp;
+    uint32_t half = mant >> shift;
+    const uint32_t rest = mant & ((1u << shift) - 1);
+    const uint32_t mid = 1u << (shift - 1);
+    if (rest > mid || (rest == mid && (half & 1))) {
+      half++;
+    }
+    return sign | static_cast<uint16_t>(half);
+  }
+
+  uint32_t half = ((abs >> 13) - (112 << 10));
+  const uint32_t rest = abs & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+    half++;
+  }
+  return sign | static_cast<uint16_t>(half);
+}
+
+template <typename T>
+void ToFile(const std::vector<T> &data, const std::string &filename) {
+  std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary |
+                                  std::ofstream::trunc);
+  ofs.write(reinterpret_cast<const char *>(data.data()),
+            data.size() * sizeof(T));
+  utility::Check(ofs.good(), "Writing file error: " + filename);
+  ofs.close();
+}
+
+void ConvertFeature(utility::GraphPtr graph, const std::string &folder) {
+  utility::Check(graph->feature != nullptr, "feat.bin not found");
+
+  const size_t num_nodes = graph->num_nodes;
+  const size_t dim = graph->feat_dim;
+  const float *feat = graph->feature;
+
+  if (feat_type == "fp16" || feat_type == "bf16") {
+    const bool is_f16 = feat_type == "fp16";
+    std::vector<uint16_t> out(num_nodes * dim);
+#pragma omp parallel for
+    for (size_t i = 0; i < num_nodes * dim; i++) {
+      out[i] = is_f16 ? FloatToF16(feat[i]) : FloatToBF16(feat[i]);
+    }
+    ToFile(out, folder + utility::GraphLoader::kFeatFile);
+  } else if (feat_type == "int8") {
+    // Symmetric quantization, one scale per row
+    std::vector<int8_t> out(num_nodes * dim);
+    std::vector<float> scale(num_nodes);
+#pragma omp parallel for
+    for (size_t i = 0; i < num_nodes; i++) {
+      const float *row = feat + i * dim;
+      float max_abs = 0;
+      for (size_t j = 0; j < dim; j++) {
+        max_abs = std::max(max_abs, std::abs(row[j]));
+      }
+      scale[i] = max_abs / 127;
+      const float inv = max_abs > 0 ? 127 / max_abs : 0;
+      for (size_t j = 0; j < dim; j++) {
+        float q = std::round(row[j] * inv);
+        q = std::min(127.0f, std::max(-127.0f, q));
+        out[i * dim + j] = static_cast<int8_t>(q);
+      }
+    }
+    ToFile(out, folder + utility::GraphLoader::kFeatFile);
+    ToFile(scale, folder + kFeatScaleFile);
+  } else {
+    utility::Check(false, "Unsupported feature type " + feat_type);
+  }
+}
+
+template <typename T>
+void NarrowLabel(utility::GraphPtr graph, const std::string &folder) {
+  const size_t num_nodes = graph->num_nodes;
+  const uint64_t *label = graph->label;
+  std::vector<T> out(num_nodes);
+
+  bool fit = true;
+#pragma omp parallel for reduction(&& : fit)
+  for (size_t i = 0; i < num_nodes; i++) {
+    fit = fit && label[i] <= std::numeric_limits<T>::max();
+    out[i] = static_cast<T>(label[i]);
+  }
+  utility::Check(fit, "The labels do not fit into " + label_type);
+
+  ToFile(out, folder + utility::GraphLoader::kLabelFile);
+}
+
+void ConvertLabel(utility::GraphPtr graph, const std::string &folder) {
+  utility::Check(graph->label != nullptr, "label.bin not found");
+  if (label_type == "u8") {
+    NarrowLabel<uint8_t>(graph, folder);
+  } else if (label_type == "u16") {
+    NarrowLabel<uint16_t>(graph, folder);
+  } else {
+    utility::Check(false, "Unsupported label type " + label_type);
+  }
+}
+
+// Copy the meta of the source dataset and record the new data types
+void WriteMeta(const std::string &src, const std::string &dst, int feat,
+               int label) {
+  std::ifstream ifs(src + utility::GraphLoader::kMetaFile);
+  std::ofstream ofs(dst + utility::GraphLoader::kMetaFile,
+                    std::ofstream::out | std::ofstream::trunc);
+  std::string line;
+  while (std::getline(ifs, line)) {
+    std::string key = line.substr(0, line.find_first_of(" \t"));
+    if (key == kMetaFeatType || key == kMetaLabelType || key.empty()) {
+      continue;
+    }
+    ofs << line << "\n";
+  }
+  ofs << kMetaFeatType << " " << feat << "\n";
+  ofs << kMetaLabelType << " " << label << "\n";
+  ofs.close();
+}
+
+void LinkFile(const std::string &src, const std::string &dst,
+              const std::string &name) {
+  unlink((dst + name).c_str());
+  utility::Check(symlink((src + name).c_str(), (dst + name).c_str()) == 0,
+                 "Cannot link " + dst + name);
+}
+
+// The graph topology and the caches are shared with the source dataset
+void LinkOtherFiles(const std::string &src, const std::string &dst) {
+  const std::vector<std::string> skip = {
+      utility::GraphLoader::kMetaFile, utility::GraphLoader::kFeatFile,
+      utility::GraphLoader::kLabelFile, kFeatScaleFile};
+
+  DIR *dir = opendir(src.c_str());
+  utility::Check(dir != nullptr, "Cannot open " + src);
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    std::string name = entry->d_name;
+    if (name == "." || name == ".." ||
+        std::find(skip.begin(), skip.end(), name) != skip.end()) {
+      continue;
+    }
+    LinkFile(src, dst, name);
+  }
+  closedir(dir);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  utility::Options::InitOptions("Quantize dataset");
+  utility::Options::CustomOption("-o,--output", output);
+  utility::Options::CustomOption("--feat-type", feat_type);
+  utility::Options::CustomOption("--label-type", label_type);
+  OPTIONS_PARSE(argc, argv);
+
+  utility::Check(!output.empty(), "The output folder is not set");
+  if (output.back() != '/') {
+    output += '/';
+  }
+  mkdir(output.c_str(), 0755);
+
+  utility::GraphLoader graph_loader(utility::Options::root);
+  auto graph = graph_loader.GetGraphDataset(utility::Options::graph);
+  utility::Check(graph->folder != output,
+                 "The output folder must differ from the source");
+
+  // fp32 features and u64 labels are linked from the source dataset
+  int feat = kF32;
+  int label = kI64;
+  if (feat_type == "fp32") {
+    LinkFile(graph->folder, output, utility::GraphLoader::kFeatFile);
+  } else {
+    ConvertFeature(graph, output);
+    feat = feat_type == "fp16" ? kF16 : feat_type == "bf16" ? kBF16 : kI8;
+  }
+  if (label_type == "u64") {
+    LinkFile(graph->folder, output, utility::GraphLoader::kLabelFile);
+  } else {
+    ConvertLabel(graph, output);
+    label = label_type == "u8" ? kU8 : kU16;
+  }
+
+  WriteMeta(graph->folder, output, feat, label);
+  LinkOtherFiles(graph->folder, output);
+
+  std::cout << "Wrote " << feat_type << " features and " << label_type
+            << " labels to " << output << std::endl;
+}
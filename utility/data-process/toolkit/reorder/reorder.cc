@@ -0,0 +1,412 @@
+/*
+ * Copyright 2022 Institute of Parallel and Distributed Systems, Shanghai Jiao Tong University
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <parallel/algorithm>
+#endif
+
+#include "common/graph_loader.h"
+#include "common/options.h"
+#include "common/utils.h"
+
+// Renumber the nodes so that the hot ones are contiguous and write the
+// reordered dataset to another folder. Run it before quantize-dataset, the
+// graph loader only reads fp32 features and u64 labels.
+
+namespace {
+
+// rows of one node, any element type
+const std::vector<std::string> kNodeFiles = {
+    "feat.bin",       "label.bin",       "feat_scale.bin",
+    "in_degrees.bin", "out_degrees.bin",
+};
+// one value per edge, in the order of indices.bin
+const std::vector<std::string> kEdgeFiles = {
+    "prob_table.bin",
+    "prob_prefix_table.bin",
+};
+// node ids, the alias table is one per edge too
+const std::vector<std::string> kNodeListFiles = {
+    "train_set.bin",         "valid_set.bin",
+    "test_set.bin",          "cache_by_degree.bin",
+    "cache_by_heuristic.bin", "cache_by_degree_hop.bin",
+    "cache_by_fake_optimal.bin", "cache_by_random.bin",
+};
+const std::string kAliasTableFile = "alias_table.bin";
+// two floats per edge, moved as one 8-byte value
+const std::string kAliasWeightTableFile = "alias_weight_table.bin";
+const std::string kMappingFile = "reorder_old2new.bin";
+
+// rows written at once
+constexpr size_t kChunkBytes = 64 * 1024 * 1024;
+
+std::string order = "degree";
+std::string rank_file = "cache_by_degree.bin";
+std::string output;
+
+size_t FileSize(const std::string &file) {
+  struct stat st;
+  utility::Check(stat(file.c_str(), &st) == 0, "Cannot stat " + file);
+  return st.st_size;
+}
+
+// Mapped without mlock, the files are read once
+const char *MapFile(const std::string &file, size_t nbytes) {
+  if (nbytes == 0) {
+    return nullptr;
+  }
+  int fd = open(file.c_str(), O_RDONLY, 0);
+  utility::Check(fd >= 0, "Cannot open " + file);
+  void *ret = mmap(NULL, nbytes, PROT_READ, MAP_SHARED | MAP_FILE, fd, 0);
+  utility::Check(ret != MAP_FAILED, "Cannot map " + file);
+  close(fd);
+  return static_cast<const char *>(ret);
+}
+
+std::vector<uint32_t> DegreeOrder(utility::GraphPtr graph) {
+  // the nodes with most out edges are the most sampled ones
+  auto info = utility::DegreeInfo::GetDegrees(graph);
+  const std::vector<uint32_t> &out_degrees = info->out_degrees;
+
+  std::vector<uint32_t> new2old(graph->num_nodes);
+#pragma omp parallel for
+  for (size_t i = 0; i < graph->num_nodes; i++) {
+    new2old[i] = i;
+  }
+  auto cmp = [&out_degrees](uint32_t a, uint32_t b) {
+    return out_degrees[a] > out_degrees[b] ||
+           (out_degrees[a] == out_degrees[b] && a < b);
+  };
+#ifdef __linux__
+  __gnu_parallel::sort(new2old.begin(), new2old.end(), cmp);
+#else
+  std::sort(new2old.begin(), new2old.end(), cmp);
+#endif
+  return new2old;
+}
+
+std::vector<uint32_t> RankOrder(utility::GraphPtr graph) {
+  const std::string file = graph->folder + rank_file;
+  utility::Check(utility::FileExist(file), file + " not found");
+  utility::Check(FileSize(file) == graph->num_nodes * sizeof(uint32_t),
+                 file + " does not rank every node");
+
+  std::vector<uint32_t> new2old(graph->num_nodes);
+  std::ifstream ifs(file, std::ifstream::binary);
+  ifs.read(reinterpret_cast<char *>(new2old.data()),
+           new2old.size() * sizeof(uint32_t));
+  return new2old;
+}
+
+// Reverse Cuthill-McKee on the in-edges: every component is traversed
+// from its node of least degree, the neighbours are queued by ascending
+// degree, and the whole order is reversed at the end
+std::vector<uint32_t> RCMOrder(utility::GraphPtr graph) {
+  const size_t num_nodes = graph->num_nodes;
+  const uint32_t *indptr = graph->indptr;
+  const uint32_t *indices = graph->indices;
+  auto degree = [indptr](uint32_t v) { return indptr[v + 1] - indptr[v]; };
+
+  std::vector<uint32_t> starts(num_nodes);
+#pragma omp parallel for
+  for (size_t i = 0; i < num_nodes; i++) {
+    starts[i] = i;
+  }
+  auto cmp = [&degree](uint32_t a, uint32_t b) {
+    return degree(a) < degree(b) || (degree(a) == degree(b) && a < b);
+  };
+#ifdef __linux__
+  __gnu_parallel::sort(starts.begin(), starts.end(), cmp);
+#else
+  std::sort(starts.begin(), starts.end(), cmp);
+#endif
+
+  std::vector<uint32_t> new2old;
+  new2old.reserve(num_nodes);
+  std::vector<bool> visited(num_nodes, false);
+  std::vector<uint32_t> neighbours;
+  for (uint32_t start : starts) {
+    if (visited[start]) {
+      continue;
+    }
+    visited[start] = true;
+    // new2old doubles as the bfs queue
+    size_t head = new2old.size();
+    new2old.push_back(start);
+    for (; head < new2old.size(); head++) {
+      const uint32_t v = new2old[head];
+      neighbours.clear();
+      for (uint32_t k = indptr[v]; k < indptr[v + 1]; k++) {
+        if (!visited[indices[k]]) {
+          visited[indices[k]] = true;
+          neighbours.push_back(indices[k]);
+        }
+      }
+      std::sort(neighbours.begin(), neighbours.end(), cmp);
+      new2old.insert(new2old.end(), neighbours.begin(), neighbours.end());
+    }
+  }
+
+  std::reverse(new2old.begin(), new2old.end());
+  return new2old;
+}
+
+// Write the rows in the new order, chunk by chunk
+void PermuteRows(const std::string &name, const std::string &src_folder,
+                 const std::vector<uint32_t> &new2old) {
+  const std::string file = src_folder + name;
+  if (!utility::FileExist(file)) {
+    return;
+  }
+
+  const size_t num_nodes = new2old.size();
+  const size_t nbytes = FileSize(file);
+  utility::Check(nbytes % num_nodes == 0, file + " is not one row per node");
+  const size_t row_bytes = nbytes / num_nodes;
+  const char *src = MapFile(file, nbytes);
+
+  std::ofstream ofs(output + name, std::ofstream::out |
+                                       std::ofstream::binary |
+                                       std::ofstream::trunc);
+  const size_t chunk_rows = std::max<size_t>(kChunkBytes / row_bytes, 1);
+  std::vector<char> buf(std::min(chunk_rows, num_nodes) * row_bytes);
+  for (size_t begin = 0; begin < num_nodes; begin += chunk_rows) {
+    const size_t end = std::min(begin + chunk_rows, num_nodes);
+#pragma omp parallel for
+    for (size_t v = begin; v < end; v++) {
+      memcpy(buf.data() + (v - begin) * row_bytes,
+             src + static_cast<size_t>(new2old[v]) * row_bytes, row_bytes);
+    }
+    ofs.write(buf.data(), (end - begin) * row_bytes);
+  }
+  utility::Check(ofs.good(), "Writing file error: " + output + name);
+  ofs.close();
+  munmap(const_cast<char *>(src), nbytes);
+
+  std::cout << "Reordered " << name << std::endl;
+}
+
+// Write the rows of an edge file in the new order, the edges of one row
+// keep their order so the edge files stay aligned with indices.bin
+template <typename T>
+void PermuteEdges(const std::string &name, const T *src,
+                  const uint32_t *indptr,
+                  const std::vector<uint32_t> &new_indptr,
+                  const std::vector<uint32_t> &new2old,
+                  std::function<T(T)> map) {
+  const size_t num_nodes = new2old.size();
+  std::ofstream ofs(output + name, std::ofstream::out |
+                                       std::ofstream::binary |
+                                       std::ofstream::trunc);
+  const size_t chunk_edges = kChunkBytes / sizeof(T);
+  std::vector<T> buf;
+  for (size_t begin = 0; begin < num_nodes;) {
+    // at least one row per chunk
+    size_t end = begin + 1;
+    while (end < num_nodes &&
+           new_indptr[end + 1] - new_indptr[begin] <= chunk_edges) {
+      end++;
+    }
+    buf.resize(new_indptr[end] - new_indptr[begin]);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (size_t v = begin; v < end; v++) {
+      const uint32_t u = new2old[v];
+      T *dst = buf.data() + (new_indptr[v] - new_indptr[begin]);
+      for (uint32_t k = indptr[u]; k < indptr[u + 1]; k++) {
+        dst[k - indptr[u]] = map(src[k]);
+      }
+    }
+    ofs.write(reinterpret_cast<const char *>(buf.data()),
+              buf.size() * sizeof(T));
+    begin = end;
+  }
+  utility::Check(ofs.good(), "Writing file error: " + output + name);
+  ofs.close();
+
+  std::cout << "Reordered " << name << std::endl;
+}
+
+void RelabelNodeList(const std::string &name, const std::string &src_folder,
+                     const std::vector<uint32_t> &old2new) {
+  const std::string file = src_folder + name;
+  if (!utility::FileExist(file)) {
+    return;
+  }
+
+  const size_t nbytes = FileSize(file);
+  const uint32_t *src = reinterpret_cast<const uint32_t *>(MapFile(file, nbytes));
+  std::vector<uint32_t> out(nbytes / sizeof(uint32_t));
+#pragma omp parallel for
+  for (size_t i = 0; i < out.size(); i++) {
+    out[i] = old2new[src[i]];
+  }
+  munmap(const_cast<uint32_t *>(src), nbytes);
+
+  std::ofstream ofs(output + name, std::ofstream::out |
+                                       std::ofstream::binary |
+                                       std::ofstream::trunc);
+  ofs.write(reinterpret_cast<const char *>(out.data()),
+            out.size() * sizeof(uint32_t));
+  utility::Check(ofs.good(), "Writing file error: " + output + name);
+  ofs.close();
+
+  std::cout << "Relabeled " << name << std::endl;
+}
+
+void Reorder(utility::GraphPtr graph, const std::vector<uint32_t> &new2old) {
+  const size_t num_nodes = graph->num_nodes;
+  const std::string &folder = graph->folder;
+  const uint32_t *indptr = graph->indptr;
+
+  std::vector<uint32_t> old2new(num_nodes, num_nodes);
+#pragma omp parallel for
+  for (size_t v = 0; v < num_nodes; v++) {
+    old2new[new2old[v]] = v;
+  }
+  bool is_permutation = true;
+#pragma omp parallel for reduction(&& : is_permutation)
+  for (size_t v = 0; v < num_nodes; v++) {
+    is_permutation = is_permutation && old2new[v] < num_nodes;
+  }
+  utility::Check(is_permutation, "The order is not a permutation");
+
+  // 1. Topology
+  std::vector<uint32_t> new_indptr(num_nodes + 1);
+  new_indptr[0] = 0;
+  for (size_t v = 0; v < num_nodes; v++) {
+    const uint32_t u = new2old[v];
+    new_indptr[v + 1] = new_indptr[v] + indptr[u + 1] - indptr[u];
+  }
+  std::ofstream ofs(output + utility::GraphLoader::kIndptrFile,
+                    std::ofstream::out | std::ofstream::binary |
+                        std::ofstream::trunc);
+  ofs.write(reinterpret_cast<const char *>(new_indptr.data()),
+            new_indptr.size() * sizeof(uint32_t));
+  ofs.close();
+
+  auto relabel = [&old2new](uint32_t v) { return old2new[v]; };
+  auto keep = [](float w) { return w; };
+  PermuteEdges<uint32_t>(utility::GraphLoader::kIndicesFile, graph->indices,
+                         indptr, new_indptr, new2old, relabel);
+
+  // 2. Edge tables
+  for (const std::string &name : kEdgeFiles) {
+    if (utility::FileExist(folder + name)) {
+      const size_t nbytes = FileSize(folder + name);
+      utility::Check(nbytes == graph->num_edges * sizeof(float),
+                     name + " is not one float per edge");
+      const float *src = reinterpret_cast<const float *>(
+          MapFile(folder + name, nbytes));
+      PermuteEdges<float>(name, src, indptr, new_indptr, new2old, keep);
+      munmap(const_cast<float *>(src), nbytes);
+    }
+  }
+  if (utility::FileExist(folder + kAliasTableFile)) {
+    const size_t nbytes = FileSize(folder + kAliasTableFile);
+    utility::Check(nbytes == graph->num_edges * sizeof(uint32_t),
+                   kAliasTableFile + " is not one id per edge");
+    const uint32_t *src = reinterpret_cast<const uint32_t *>(
+        MapFile(folder + kAliasTableFile, nbytes));
+    PermuteEdges<uint32_t>(kAliasTableFile, src, indptr, new_indptr, new2old,
+                           relabel);
+    munmap(const_cast<uint32_t *>(src), nbytes);
+  }
+  if (utility::FileExist(folder + kAliasWeightTableFile)) {
+    const size_t nbytes = FileSize(folder + kAliasWeightTableFile);
+    utility::Check(nbytes == graph->num_edges * sizeof(uint64_t),
+                   kAliasWeightTableFile + " is not two floats per edge");
+    const uint64_t *src = reinterpret_cast<const uint64_t *>(
+        MapFile(folder + kAliasWeightTableFile, nbytes));
+    PermuteEdges<uint64_t>(kAliasWeightTableFile, src, indptr, new_indptr,
+                           new2old, [](uint64_t w) { return w; });
+    munmap(const_cast<uint64_t *>(src), nbytes);
+  }
+
+  // 3. Node data and node lists
+  for (const std::string &name : kNodeFiles) {
+    PermuteRows(name, folder, new2old);
+  }
+  for (const std::string &name : kNodeListFiles) {
+    RelabelNodeList(name, folder, old2new);
+  }
+
+  // 4. Meta and the mapping
+  std::ifstream meta_in(folder + utility::GraphLoader::kMetaFile);
+  std::ofstream meta_out(output + utility::GraphLoader::kMetaFile,
+                         std::ofstream::out | std::ofstream::trunc);
+  meta_out << meta_in.rdbuf();
+  meta_out.close();
+
+  std::ofstream mapping(output + kMappingFile, std::ofstream::out |
+                                                   std::ofstream::binary |
+                                                   std::ofstream::trunc);
+  mapping.write(reinterpret_cast<const char *>(old2new.data()),
+                old2new.size() * sizeof(uint32_t));
+  mapping.close();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  utility::Options::InitOptions("Reorder dataset");
+  utility::Options::CustomOption("-o,--output", output);
+  utility::Options::CustomOption("--order", order);
+  utility::Options::CustomOption("--rank-file", rank_file);
+  OPTIONS_PARSE(argc, argv);
+
+  utility::Check(!output.empty(), "The output folder is not set");
+  if (output.back() != '/') {
+    output += '/';
+  }
+  mkdir(output.c_str(), 0755);
+
+  utility::GraphLoader graph_loader(utility::Options::root);
+  auto graph = graph_loader.GetGraphDataset(utility::Options::graph);
+  utility::Check(graph->folder != output,
+                 "The output folder must differ from the source");
+
+  utility::Timer t;
+  std::vector<uint32_t> new2old;
+  if (order == "degree") {
+    new2old = DegreeOrder(graph);
+  } else if (order == "rank") {
+    new2old = RankOrder(graph);
+  } else if (order == "rcm") {
+    new2old = RCMOrder(graph);
+  } else {
+    utility::Check(false, "Unsupported order " + order);
+  }
+  std::cout << "Computed the " << order << " order in " << t.Passed()
+            << " secs" << std::endl;
+
+  Reorder(graph, new2old);
+
+  std::cout << "Wrote the reordered dataset to " << output << " ("
+            << t.Passed() << " secs)" << std::endl;
+}
@@ -18,7 +18,6 @@
 #include <fstream>
 #include <iostream>
 #include <queue>
-#include <random>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -26,11 +25,15 @@
 #include "common/graph_loader.h"
 #include "common/options.h"
 #include "common/utils.h"
+#include "samgraph/common/cpu/cpu_random.h"
 
 namespace {
 
 std::string output0_filepath = "prob_table.bin";
 std::string output1_filepath = "alias_table.bin";
+// probability of the kept and of the aliased edge of every column, read by
+// the CPU sampler when it returns the edge weights
+std::string output2_filepath = "alias_weight_table.bin";
 std::shared_ptr<utility::DegreeInfo> degree_info;
 
 #define WEIGHT_POLICY_TYPES( F ) \
@@ -57,11 +60,13 @@ void InitPolicy(std::string policy_str) {
   weight_policy = policy_str_to_int[policy_str];
 }
 
-uint32_t RandomInt(const uint32_t &min, const uint32_t &max) {
-  static thread_local std::random_device dev;
-  static thread_local std::mt19937 generator(dev());
-  std::uniform_int_distribution<uint32_t> distribution(min, max);
-  return distribution(generator);
+// The random number of an edge only depends on the seed and the edge, so
+// the tables are reproducible whatever the number of threads.
+uint32_t RandomInt(const uint32_t &min, const uint32_t &max,
+                   const uint32_t nodeid, const uint32_t edge_idx) {
+  using samgraph::common::cpu::PhiloxRandom;
+  PhiloxRandom rng(utility::Options::seed, 0, nodeid);
+  return min + PhiloxRandom::Bound(rng.At(edge_idx), max - min + 1);
 }
 
 void AddPrefixToFilepath(std::string prefix) {
@@ -71,6 +76,7 @@ void AddPrefixToFilepath(std::string prefix) {
 
   output0_filepath = prefix + output0_filepath;
   output1_filepath = prefix + output1_filepath;
+  output2_filepath = prefix + output2_filepath;
 }
 
 float InverseSrcDegreeRand(uint32_t src, uint32_t dst) {
@@ -78,10 +84,10 @@ float InverseSrcDegreeRand(uint32_t src, uint32_t dst) {
   // return 1.0 / RandomInt(1, src_out_deg);
   return 1.0 / src_out_deg;
 }
-float InverseBothDegreeRand(uint32_t src, uint32_t dst) {
+float InverseBothDegreeRand(uint32_t src, uint32_t dst, uint32_t edge_idx) {
   uint32_t src_out_deg = degree_info->out_degrees[src];
   uint32_t dst_in_deg = degree_info->in_degrees[dst];
-  return 1.0 / RandomInt(1, std::max(src_out_deg, dst_in_deg));
+  return 1.0 / RandomInt(1, std::max(src_out_deg, dst_in_deg), dst, edge_idx);
 }
 float SrcSuffix(uint32_t src, uint32_t dst) {
   if (degree_info->out_degrees[src] < 10) return 100;
@@ -96,7 +102,8 @@ float SrcSuffix(uint32_t src, uint32_t dst) {
 void CreateAliasTable(const uint32_t *indptr, const uint32_t *indices,
                       size_t num_nodes, size_t num_edges,
                       std::vector<float> &prob_table,
-                      std::vector<uint32_t> &alias_table) {
+                      std::vector<uint32_t> &alias_table,
+                      std::vector<float> &alias_weight_table) {
 #pragma omp parallel for
   for (uint32_t nodeid = 0; nodeid < num_nodes; nodeid++) {
     const uint32_t off = indptr[nodeid];
@@ -110,9 +117,9 @@ void CreateAliasTable(const uint32_t *indptr, const uint32_t *indices,
       uint32_t dst = nodeid, src = indices[off+i];
       switch(weight_policy) {
         case kDefault:
-          weights[i] = static_cast<float>(RandomInt(1, 10)); break;
+          weights[i] = static_cast<float>(RandomInt(1, 10, nodeid, i)); break;
         case kInverseBothDegreeRand:
-          weights[i] = InverseBothDegreeRand(src, dst); break;
+          weights[i] = InverseBothDegreeRand(src, dst, i); break;
         case kInverseSrcDegreeRand:
           weights[i] = InverseSrcDegreeRand(src, dst); break;
         case kSrcSuffix:
@@ -127,6 +134,8 @@ void CreateAliasTable(const uint32_t *indptr, const uint32_t *indices,
       utility::Check(weights[i] != NAN, "do not allow nan");
       weights[i] /= weight_sum;
       weights[i] *= len;
+      alias_weight_table[2 * (size_t(off) + i)] = weights[i] / len;
+      alias_weight_table[2 * (size_t(off) + i) + 1] = 0;
     }
 
     // 2. create alias table
@@ -150,6 +159,8 @@ void CreateAliasTable(const uint32_t *indptr, const uint32_t *indices,
 
       prob_table[off + small_idx] = weights[small_idx];
       alias_table[off + small_idx] = indices[off + large_idx];
+      alias_weight_table[2 * (size_t(off) + small_idx) + 1] =
+          alias_weight_table[2 * (size_t(off) + large_idx)];
 
       weights[large_idx] -= (1 - weights[small_idx]);
 
@@ -186,8 +197,14 @@ void CreateAliasTable(const uint32_t *indptr, const uint32_t *indices,
              prob_table.size() * sizeof(float));
   ofs1.write((const char *)alias_table.data(),
              alias_table.size() * sizeof(uint32_t));
+  std::ofstream ofs2(output2_filepath, std::ofstream::out |
+                                           std::ofstream::binary |
+                                           std::ofstream::trunc);
+  ofs2.write((const char *)alias_weight_table.data(),
+             alias_weight_table.size() * sizeof(float));
   ofs0.close();
   ofs1.close();
+  ofs2.close();
 }
 
 }  // namespace
@@ -210,10 +227,11 @@ int main(int argc, char *argv[]) {
 
   std::vector<uint32_t> alias_table(graph->num_edges);
   std::vector<float> prob_table(graph->num_edges);
+  std::vector<float> alias_weight_table(2 * graph->num_edges);
 
   AddPrefixToFilepath(graph->folder);
   CreateAliasTable(indptr, indices, num_nodes, num_edges, prob_table,
-                   alias_table);
+                   alias_table, alias_weight_table);
 
   return 0;
 }
\ No newline at end of file
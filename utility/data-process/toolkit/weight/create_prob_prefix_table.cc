@@ -18,7 +18,6 @@
 #include <fstream>
 #include <iostream>
 #include <queue>
-#include <random>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -26,6 +25,7 @@
 #include "common/graph_loader.h"
 #include "common/options.h"
 #include "common/utils.h"
+#include "samgraph/common/cpu/cpu_random.h"
 
 namespace {
 
@@ -56,11 +56,13 @@ void InitPolicy(std::string policy_str) {
   weight_policy = policy_str_to_int[policy_str];
 }
 
-uint32_t RandomInt(const uint32_t &min, const uint32_t &max) {
-  static thread_local std::random_device dev;
-  static thread_local std::mt19937 generator(dev());
-  std::uniform_int_distribution<uint32_t> distribution(min, max);
-  return distribution(generator);
+// The random number of an edge only depends on the seed and the edge, so
+// the tables are reproducible whatever the number of threads.
+uint32_t RandomInt(const uint32_t &min, const uint32_t &max,
+                   const uint32_t nodeid, const uint32_t edge_idx) {
+  using samgraph::common::cpu::PhiloxRandom;
+  PhiloxRandom rng(utility::Options::seed, 0, nodeid);
+  return min + PhiloxRandom::Bound(rng.At(edge_idx), max - min + 1);
 }
 
 void AddPrefixToFilepath(std::string prefix) {
@@ -76,10 +78,10 @@ float InverseSrcDegreeRand(uint32_t src, uint32_t dst) {
   // return 1.0 / RandomInt(1, src_out_deg);
   return 1.0 / src_out_deg;
 }
-float InverseBothDegreeRand(uint32_t src, uint32_t dst) {
+float InverseBothDegreeRand(uint32_t src, uint32_t dst, uint32_t edge_idx) {
   uint32_t src_out_deg = degree_info->out_degrees[src];
   uint32_t dst_in_deg = degree_info->in_degrees[dst];
-  return 1.0 / RandomInt(1, std::max(src_out_deg, dst_in_deg));
+  return 1.0 / RandomInt(1, std::max(src_out_deg, dst_in_deg), dst, edge_idx);
 }\
 float SrcSuffix(uint32_t src, uint32_t dst) {
   if (degree_info->out_degrees[src] < 10) return 100;
@@ -107,9 +109,9 @@ void CreateProbPrefixTable(const uint32_t *indptr, const uint32_t *indices,
       float weight;
       switch(weight_policy) {
         case kDefault:
-          weight = static_cast<float>(RandomInt(1, 10)); break;
+          weight = static_cast<float>(RandomInt(1, 10, nodeid, i)); break;
         case kInverseBothDegreeRand:
-          weight = InverseBothDegreeRand(src, dst); break;
+          weight = InverseBothDegreeRand(src, dst, i); break;
         case kInverseSrcDegreeRand:
           weight = InverseSrcDegreeRand(src, dst); break;
         case kSrcSuffix: